@@ -87,8 +87,19 @@ async function evaluate() {
 
     $("#secondary-message").html("It can take around a minute to process a full game.");
 
+    // Use the chess program's own analysis when it covers every position
+    let nativeAnalysis: EngineLine[][] | null = (window as any).electronAPI?.getNativeAnalysis?.() ?? null;
+    if (nativeAnalysis?.length == positions.length) {
+        positions.forEach((position, index) => {
+            position.topLines = nativeAnalysis![index];
+            position.worker = "native";
+        });
+    }
+
     // Fetch cloud evaluations where possible
     for (let position of positions) {
+        if (position.topLines) break;
+
         function placeCutoff() {
             let lastPosition = positions[positions.indexOf(position) - 1];
             if (!lastPosition) return;
@@ -55,13 +55,25 @@ function createWindow() {
   // Load the Express server URL
   mainWindow.loadURL(`http://localhost:${PORT}`);
 
-  // Check for command line arguments (PGN file path)
+  // Check for command line arguments (PGN file path, then the game's native analysis)
   const pgnFilePath = process.argv[2];
+  const analysisFilePath = process.argv[3];
   if (pgnFilePath && fs.existsSync(pgnFilePath)) {
     try {
       const pgn = fs.readFileSync(pgnFilePath, 'utf8');
-      // Wait for window to be ready before sending PGN
+      let analysis = null;
+      if (analysisFilePath && fs.existsSync(analysisFilePath)) {
+        try {
+          analysis = JSON.parse(fs.readFileSync(analysisFilePath, 'utf8'));
+        } catch (error) {
+          console.error('Error reading analysis file, the game will be evaluated here:', error);
+        }
+      }
+      // Wait for window to be ready before sending PGN; the analysis goes first so it is there when evaluation starts
       mainWindow.webContents.on('did-finish-load', () => {
+        if (analysis) {
+          mainWindow.webContents.send('load-analysis', analysis);
+        }
         mainWindow.webContents.send('load-pgn', pgn);
       });
     } catch (error) {
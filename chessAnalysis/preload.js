@@ -1,8 +1,22 @@
 const { contextBridge, ipcRenderer } = require('electron');
 
+// Engine lines for every position of the game, when the chess program already analysed it.
+// Handed out once: any later game reviewed in this window is evaluated by the viewer itself.
+let nativeAnalysis = null;
+
 // Expose IPC API to renderer process
 contextBridge.exposeInMainWorld('electronAPI', {
-  sendPGN: (pgn) => ipcRenderer.send('send-pgn', pgn)
+  sendPGN: (pgn) => ipcRenderer.send('send-pgn', pgn),
+  getNativeAnalysis: () => {
+    const analysis = nativeAnalysis;
+    nativeAnalysis = null;
+    return analysis;
+  }
+});
+
+ipcRenderer.on('load-analysis', (event, analysis) => {
+  console.log('Received native analysis of', analysis.length, 'positions');
+  nativeAnalysis = analysis;
 });
 
 // Listen for PGN data from main process
@@ -0,0 +1,148 @@
+#include "AssetLoader.h"
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+using namespace sf;
+
+AssetLoader::AssetLoader(int threads) : stopping(false)
+{
+    if (threads <= 0)
+        threads = min(4, max(1, static_cast<int>(thread::hardware_concurrency())));
+
+    for (int i = 0; i < threads; i++)
+    {
+        workers.emplace_back(&AssetLoader::work, this);
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        lock_guard<mutex> lock(assetMutex);
+        stopping = true;
+    }
+    assetChanged.notify_all();
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+AssetLoader::Asset *AssetLoader::request(const string &path, bool isImage)
+{
+    lock_guard<mutex> lock(assetMutex);
+    unique_ptr<Asset> &asset = assets[path];
+    if (!asset)
+    {
+        asset.reset(new Asset());
+        asset->path = path;
+        asset->isImage = isImage;
+        asset->done = false;
+        asset->ok = false;
+        queue.push_back(asset.get());
+        assetChanged.notify_one();
+    }
+    return asset.get();
+}
+
+void AssetLoader::requestImage(const string &path)
+{
+    request(path, true);
+}
+
+void AssetLoader::requestFile(const string &path)
+{
+    request(path, false);
+}
+
+// Helper function to read a whole file into memory
+static bool readFile(const string &path, vector<char> &bytes)
+{
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open())
+        return false;
+
+    streamoff size = file.tellg();
+    if (size < 0)
+        return false;
+    bytes.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    return size == 0 || file.read(bytes.data(), size).good();
+}
+
+void AssetLoader::work()
+{
+    while (true)
+    {
+        Asset *asset;
+        {
+            unique_lock<mutex> lock(assetMutex);
+            assetChanged.wait(lock, [&]()
+                              { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            asset = queue.front();
+            queue.pop_front();
+        }
+
+        // Decoding is where the time goes (the menu JPEG most of all), and it needs no context
+        bool ok = asset->isImage ? asset->image.loadFromFile(asset->path) : readFile(asset->path, asset->bytes);
+
+        {
+            lock_guard<mutex> lock(assetMutex);
+            asset->ok = ok;
+            asset->done = true;
+        }
+        assetChanged.notify_all();
+    }
+}
+
+AssetLoader::Asset *AssetLoader::wait(const string &path)
+{
+    unique_lock<mutex> lock(assetMutex);
+    auto it = assets.find(path);
+    if (it == assets.end())
+        return nullptr;
+
+    Asset *asset = it->second.get();
+    auto queued = find(queue.begin(), queue.end(), asset);
+    if (queued != queue.end())
+    {
+        // Nobody has started on it yet: load it here rather than wait behind the rest of the queue
+        queue.erase(queued);
+        lock.unlock();
+        bool ok = asset->isImage ? asset->image.loadFromFile(asset->path) : readFile(asset->path, asset->bytes);
+        lock.lock();
+        asset->ok = ok;
+        asset->done = true;
+    }
+    assetChanged.wait(lock, [&]()
+                      { return asset->done; });
+    return asset;
+}
+
+bool AssetLoader::takeImage(const string &path, Image &image)
+{
+    Asset *asset = wait(path);
+    if (!asset)
+        return image.loadFromFile(path);
+    if (!asset->ok)
+        return false;
+
+    image = asset->image;
+    asset->image = Image(); // The caller has its own copy now
+    return true;
+}
+
+bool AssetLoader::takeFile(const string &path, vector<char> &bytes)
+{
+    Asset *asset = wait(path);
+    if (!asset)
+        return readFile(path, bytes);
+    if (!asset->ok)
+        return false;
+
+    bytes.swap(asset->bytes);
+    return true;
+}
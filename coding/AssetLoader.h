@@ -0,0 +1,60 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+using namespace sf;
+
+// Reads and decodes asset files on a few worker threads while the main thread
+// goes on creating the window. Only the CPU side happens here: images come back
+// decoded, and textures are created from them by the caller on the thread that
+// owns the graphics context. Assets are requested by path and collected by path;
+// collecting one that is still loading waits for just that asset.
+class AssetLoader
+{
+private:
+    struct Asset
+    {
+        string path;
+        bool isImage;
+        Image image;
+        vector<char> bytes;
+        bool done;
+        bool ok;
+    };
+
+    map<string, unique_ptr<Asset>> assets; // Stable addresses while workers fill them in
+    deque<Asset *> queue;
+    mutex assetMutex;
+    condition_variable assetChanged;
+    vector<thread> workers;
+    bool stopping;
+
+    Asset *request(const string &path, bool isImage);
+    Asset *wait(const string &path);
+    void work();
+
+public:
+    // threads 0 picks one per core, at most four (there are only a dozen files)
+    explicit AssetLoader(int threads = 0);
+    ~AssetLoader();
+
+    void requestImage(const string &path);
+    void requestFile(const string &path);
+
+    // Block until the asset is loaded and hand it over (so each is taken once); false if it
+    // could not be read or decoded. Assets that were never requested load on the calling thread.
+    bool takeImage(const string &path, Image &image);
+    bool takeFile(const string &path, vector<char> &bytes);
+};
+
+#endif // ASSETLOADER_H
@@ -0,0 +1,307 @@
+#include "BoardImageRenderer.h"
+#include "ChessBoard.h" // PIECE_SCALE, SCALE_FACTOR
+#include "Fen.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <cctype>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+using namespace std;
+using namespace sf;
+
+BoardImageRenderer::BoardImageRenderer()
+    : gpu(false), ready(false), squareSize(0), pieceScale(1),
+      board(8, vector<int>(8, 0))
+{
+}
+
+// Helper function to tell whether a graphics context can be created at all.
+// SFML aborts instead of failing when X11 has no display to connect to.
+static bool displayAvailable()
+{
+#if defined(_WIN32) || defined(__APPLE__)
+    return true;
+#else
+    const char *display = getenv("DISPLAY");
+    return display && *display;
+#endif
+}
+
+bool BoardImageRenderer::initialize(const string &pieceDirectory, unsigned int squareSize, bool forceCpu)
+{
+    if (squareSize == 0)
+        return false;
+
+    this->squareSize = squareSize;
+    pieceScale = PIECE_SCALE * SCALE_FACTOR; // Same proportions as the game window
+    gpu = !forceCpu && displayAvailable();
+
+    if (!atlas.loadImages(pieceDirectory))
+        return false;
+
+    // Cells exactly as wide as a drawn piece, so pieces are copied 1:1 rather than resampled
+    unsigned int cellSize = max(1u, static_cast<unsigned int>(squareSize * pieceScale + 0.5f));
+
+    if (gpu && !target.create(8 * squareSize, 8 * squareSize))
+    {
+        cerr << "RenderTexture not available, rendering boards on the CPU" << endl;
+        gpu = false;
+    }
+    if (!atlas.build(cellSize, false, gpu))
+        return false;
+
+    if (gpu)
+    {
+        renderer.setAtlas(&atlas, pieceScale);
+    }
+    else
+    {
+        pixels.assign(8 * squareSize * 8 * squareSize * 4, 0);
+    }
+
+    ready = true;
+    return true;
+}
+
+bool BoardImageRenderer::render(const vector<vector<int>> &board, Image &image)
+{
+    if (!ready)
+        return false;
+
+    if (!gpu)
+    {
+        rasterize(board, image);
+        return true;
+    }
+
+    // Only the squares that differ from the previous position are rebuilt
+    static const vector<pair<int, int>> noMoves;
+    renderer.update(board, static_cast<float>(squareSize), -1, -1, noMoves);
+    target.clear(Color::Black);
+    target.draw(renderer);
+    target.display();
+    image = target.getTexture().copyToImage();
+    return true;
+}
+
+bool BoardImageRenderer::renderFen(const string &fen, Image &image)
+{
+    if (!Fen::parsePlacement(fen, board))
+        return false;
+    return render(board, image);
+}
+
+void BoardImageRenderer::rasterize(const vector<vector<int>> &board, Image &image)
+{
+    unsigned int size = 8 * squareSize;
+
+    // Squares
+    for (int y = 0; y < 8; y++)
+    {
+        for (int x = 0; x < 8; x++)
+        {
+            Color color = BoardRenderer::squareColor(x, y);
+            for (unsigned int py = y * squareSize; py < (y + 1) * squareSize; py++)
+            {
+                Uint8 *row = &pixels[(py * size + x * squareSize) * 4];
+                for (unsigned int px = 0; px < squareSize; px++, row += 4)
+                {
+                    row[0] = color.r;
+                    row[1] = color.g;
+                    row[2] = color.b;
+                    row[3] = 255;
+                }
+            }
+        }
+    }
+
+    // Pieces, alpha blended from the atlas image and centred on their squares
+    const Image &source = atlas.getImage();
+    const Uint8 *sourcePixels = source.getPixelsPtr();
+    unsigned int sourceWidth = source.getSize().x;
+    for (int x = 0; x < 8; x++)
+    {
+        for (int y = 0; y < 8; y++)
+        {
+            int index = PieceAtlas::pieceIndex(board[x][y]);
+            if (index < 0)
+                continue;
+
+            const IntRect &rect = atlas.getRect(index);
+            int left = x * static_cast<int>(squareSize) + (static_cast<int>(squareSize) - rect.width) / 2;
+            int top = y * static_cast<int>(squareSize) + (static_cast<int>(squareSize) - rect.height) / 2;
+            for (int sy = 0; sy < rect.height; sy++)
+            {
+                int py = top + sy;
+                if (py < 0 || py >= static_cast<int>(size))
+                    continue;
+                const Uint8 *from = sourcePixels + ((rect.top + sy) * sourceWidth + rect.left) * 4;
+                for (int sx = 0; sx < rect.width; sx++, from += 4)
+                {
+                    int px = left + sx;
+                    if (from[3] == 0 || px < 0 || px >= static_cast<int>(size))
+                        continue;
+                    Uint8 *to = &pixels[(py * size + px) * 4];
+                    unsigned int alpha = from[3];
+                    to[0] = static_cast<Uint8>((from[0] * alpha + to[0] * (255 - alpha)) / 255);
+                    to[1] = static_cast<Uint8>((from[1] * alpha + to[1] * (255 - alpha)) / 255);
+                    to[2] = static_cast<Uint8>((from[2] * alpha + to[2] * (255 - alpha)) / 255);
+                }
+            }
+        }
+    }
+
+    image.create(size, size, pixels.data());
+}
+
+int BoardImageRenderer::runCommandLine(int argc, char *argv[])
+{
+    unsigned int squareSize = 64; // 512 pixel boards
+    string outDirectory = ".";
+    bool forceCpu = false;
+    int threads = 0;
+    vector<string> fens;
+    vector<string> files;
+
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue)
+            squareSize = max(8, atoi(argv[++i])) / 8;
+        else if (arg == "--out" && hasValue)
+            outDirectory = argv[++i];
+        else if (arg == "--cpu")
+            forceCpu = true;
+        else if (arg == "--threads" && hasValue)
+            threads = atoi(argv[++i]);
+        else if (arg == "--fen" && hasValue)
+            fens.push_back(argv[++i]);
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            cerr << "Unknown render option: " << arg << endl;
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+
+    for (const string &path : files)
+    {
+        ifstream file(path);
+        if (!file.is_open())
+        {
+            cerr << "Could not open position file: " << path << endl;
+            return 1;
+        }
+        string line;
+        while (getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (line.empty() || line[0] == '#')
+                continue;
+            fens.push_back(line);
+        }
+    }
+
+    if (fens.empty())
+    {
+        cerr << "No positions to render (use --fen or give a file with one FEN per line)" << endl;
+        return 1;
+    }
+
+    BoardImageRenderer renderer;
+    if (!renderer.initialize("coding/images", squareSize, forceCpu))
+        return 1;
+
+    // PNG encoding costs more than drawing, so it runs on worker threads while the
+    // main thread (which owns the graphics context) keeps rendering
+    if (threads <= 0)
+        threads = max(1, static_cast<int>(thread::hardware_concurrency()) - 1);
+    const size_t maxQueued = static_cast<size_t>(threads) * 4; // Bounds the memory held in images
+    deque<pair<string, Image>> queue;
+    mutex queueMutex;
+    condition_variable queueChanged;
+    bool finished = false;
+    size_t failures = 0;
+
+    auto encode = [&]()
+    {
+        while (true)
+        {
+            pair<string, Image> job;
+            {
+                unique_lock<mutex> lock(queueMutex);
+                queueChanged.wait(lock, [&]()
+                                  { return finished || !queue.empty(); });
+                if (queue.empty())
+                    return;
+                job = move(queue.front());
+                queue.pop_front();
+            }
+            queueChanged.notify_all();
+            if (!job.second.saveToFile(job.first))
+            {
+                lock_guard<mutex> lock(queueMutex);
+                failures++;
+            }
+        }
+    };
+    vector<thread> encoders;
+    for (int t = 0; t < threads; t++)
+    {
+        encoders.emplace_back(encode);
+    }
+
+    auto start = chrono::steady_clock::now();
+    size_t rendered = 0;
+    Image image;
+    for (size_t i = 0; i < fens.size(); i++)
+    {
+        if (!renderer.renderFen(fens[i], image))
+        {
+            cerr << "Skipping malformed FEN on position " << i + 1 << ": " << fens[i] << endl;
+            continue;
+        }
+        rendered++;
+
+        stringstream path;
+        path << outDirectory << "/position_" << setw(6) << setfill('0') << i + 1 << ".png";
+        unique_lock<mutex> lock(queueMutex);
+        queueChanged.wait(lock, [&]()
+                          { return queue.size() < maxQueued; });
+        queue.emplace_back(path.str(), move(image));
+        lock.unlock();
+        queueChanged.notify_all();
+    }
+
+    {
+        lock_guard<mutex> lock(queueMutex);
+        finished = true;
+    }
+    queueChanged.notify_all();
+    for (thread &encoder : encoders)
+    {
+        encoder.join();
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Rendered " << rendered << " positions (" << renderer.getImageSize() << "px, "
+         << (renderer.isUsingGpu() ? "GPU" : "CPU") << ") in " << fixed << setprecision(2) << seconds << " s";
+    if (seconds > 0)
+        cout << ", " << static_cast<int>(rendered / seconds) << " positions/s";
+    cout << endl;
+    if (failures > 0)
+        cerr << failures << " images could not be written to " << outDirectory << endl;
+
+    return rendered == fens.size() && failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,54 @@
+#ifndef BOARDIMAGERENDERER_H
+#define BOARDIMAGERENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include "PieceAtlas.h"
+#include "BoardRenderer.h"
+
+using namespace std;
+using namespace sf;
+
+// Draws positions to images without a window, for diagrams in game reports.
+// One atlas and one render target are created up front and reused for every
+// position, so a batch costs one board update and one read-back per image.
+// Without a display (or with forceCpu) the board is rasterized on the CPU from
+// the atlas image instead; the atlas is built at the drawn piece size, so both
+// paths copy pieces 1:1 and give the same picture.
+class BoardImageRenderer
+{
+private:
+    PieceAtlas atlas;
+    BoardRenderer renderer;
+    RenderTexture target;
+    bool gpu;
+    bool ready;
+    unsigned int squareSize;
+    float pieceScale;
+    vector<vector<int>> board; // Scratch board for renderFen
+    vector<Uint8> pixels;      // Scratch RGBA buffer for the CPU path
+
+    void rasterize(const vector<vector<int>> &board, Image &image);
+
+public:
+    BoardImageRenderer();
+
+    // Load the piece images and set up the render target for squareSize pixel squares
+    bool initialize(const string &pieceDirectory, unsigned int squareSize, bool forceCpu = false);
+
+    // board[x][y] as in ChessBoard (y = 0 is rank 8)
+    bool render(const vector<vector<int>> &board, Image &image);
+    bool renderFen(const string &fen, Image &image);
+
+    bool isUsingGpu() const { return gpu; }
+    unsigned int getImageSize() const { return 8 * squareSize; }
+
+    // Command line entry: --render [--size PX] [--out DIR] [--cpu] [--threads N]
+    //                     [--fen FEN] [positions.fen ...]
+    // --size is the board width in pixels (default 512). Input files hold one FEN or EPD
+    // per line; images are written as DIR/position_000001.png ...
+    static int runCommandLine(int argc, char *argv[]);
+};
+
+#endif // BOARDIMAGERENDERER_H
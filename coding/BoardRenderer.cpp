@@ -0,0 +1,329 @@
+#include "BoardRenderer.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+using namespace sf;
+
+// Board colours (green + white board)
+static const Color LIGHT_SQUARE(244, 244, 244);
+static const Color DARK_SQUARE(105, 146, 62);
+static const Color SELECTED_SQUARE(247, 247, 105); // Yellow highlight
+static const Color MOVE_INDICATOR(50, 50, 50, 180); // Empty square - gray circle
+static const Color CAPTURE_INDICATOR(255, 0, 0, 150); // Opponent's piece - red circle
+
+static const int CIRCLE_SEGMENTS = 24;
+
+// Animation timing
+static const float ANIMATION_STEP = 1.0f / 120.0f; // Fixed update step in seconds
+static const float MOVE_DURATION = 0.15f;          // Seconds for a piece to reach its square
+
+BoardRenderer::BoardRenderer()
+    : vertices(Triangles), pieces(Triangles), atlas(nullptr), pieceScale(1),
+      squareSize(0), selectedX(-1), selectedY(-1), flipped(false), dirty(true), piecesDirty(true), rebuilds(0),
+      tweenCount(0), accumulator(0)
+{
+    for (int x = 0; x < 8; x++)
+    {
+        for (int y = 0; y < 8; y++)
+        {
+            cells[x][y] = 0;
+        }
+    }
+}
+
+bool BoardRenderer::update(const vector<vector<int>> &board, float squareSize,
+                           int selectedX, int selectedY, const vector<pair<int, int>> &validMoves)
+{
+    if (squareSize != this->squareSize)
+    {
+        dirty = piecesDirty = true;
+    }
+    if (selectedX != this->selectedX || selectedY != this->selectedY || validMoves != moves)
+    {
+        dirty = true;
+    }
+
+    // Indicators depend on which squares are occupied, so a move on the board invalidates both layers
+    for (int x = 0; x < 8; x++)
+    {
+        for (int y = 0; y < 8; y++)
+        {
+            if (cells[x][y] != board[x][y])
+            {
+                cells[x][y] = board[x][y];
+                dirty = piecesDirty = true;
+            }
+        }
+    }
+
+    if (!dirty && !piecesDirty)
+        return false;
+
+    this->squareSize = squareSize;
+    this->selectedX = selectedX;
+    this->selectedY = selectedY;
+    moves = validMoves;
+    if (dirty)
+        rebuild();
+    if (piecesDirty)
+        rebuildPieces();
+    return true;
+}
+
+void BoardRenderer::setFlipped(bool flipped)
+{
+    if (flipped != this->flipped)
+    {
+        this->flipped = flipped;
+        dirty = piecesDirty = true;
+    }
+}
+
+Vector2f BoardRenderer::toScreen(float x, float y) const
+{
+    if (flipped)
+    {
+        x = 7 - x;
+        y = 7 - y;
+    }
+    return Vector2f(x * squareSize, y * squareSize);
+}
+
+void BoardRenderer::setAtlas(const PieceAtlas *pieceAtlas, float pieceScale)
+{
+    atlas = pieceAtlas;
+    this->pieceScale = pieceScale;
+    piecesDirty = true;
+}
+
+Color BoardRenderer::squareColor(int x, int y)
+{
+    return (x + y) % 2 == 0 ? LIGHT_SQUARE : DARK_SQUARE;
+}
+
+void BoardRenderer::rebuild()
+{
+    // clear() keeps the capacity, so rebuilding does not reallocate
+    vertices.clear();
+
+    for (int x = 0; x < 8; x++)
+    {
+        for (int y = 0; y < 8; y++)
+        {
+            Color color = squareColor(x, y); // Flipping keeps the colour pattern
+            if (x == selectedX && y == selectedY)
+            {
+                color = SELECTED_SQUARE;
+            }
+            Vector2f corner = toScreen(x, y);
+            addRect(corner.x, corner.y, squareSize, squareSize, color);
+        }
+    }
+
+    for (const auto &move : moves)
+    {
+        Vector2f corner = toScreen(move.first, move.second);
+        float centerX = corner.x + squareSize / 2;
+        float centerY = corner.y + squareSize / 2;
+        if (cells[move.first][move.second] == 0)
+        {
+            addCircle(centerX, centerY, squareSize / 4, MOVE_INDICATOR);
+        }
+        else
+        {
+            addCircle(centerX, centerY, squareSize / 3, CAPTURE_INDICATOR);
+        }
+    }
+
+    dirty = false;
+    rebuilds++;
+}
+
+void BoardRenderer::animateMove(const vector<vector<int>> &board, int fromX, int fromY, int toX, int toY,
+                                int capturedX, int capturedY)
+{
+    if (tweenCount == MAX_TWEENS)
+    {
+        // Out of slots: let the oldest animation land immediately
+        for (int i = 1; i < tweenCount; i++)
+        {
+            tweens[i - 1] = tweens[i];
+        }
+        tweenCount--;
+    }
+
+    if (capturedX < 0)
+    {
+        capturedX = toX;
+        capturedY = toY;
+    }
+
+    PieceTween &tween = tweens[tweenCount++];
+    tween.piece = board[fromX][fromY];
+    tween.toX = toX;
+    tween.toY = toY;
+    tween.from = Vector2f(fromX, fromY);
+    tween.to = Vector2f(toX, toY);
+    tween.captured = board[capturedX][capturedY];
+    tween.capturedX = capturedX;
+    tween.capturedY = capturedY;
+    tween.progress = 0;
+    piecesDirty = true;
+}
+
+bool BoardRenderer::advance(float seconds)
+{
+    if (tweenCount == 0)
+        return false;
+
+    // Fixed steps keep the motion identical whatever the frame rate; a long stall
+    // (window drag, engine search) is clamped instead of replayed step by step
+    accumulator += min(seconds, 0.25f);
+    while (accumulator >= ANIMATION_STEP)
+    {
+        accumulator -= ANIMATION_STEP;
+        for (int i = 0; i < tweenCount; i++)
+        {
+            tweens[i].progress = min(1.0f, tweens[i].progress + ANIMATION_STEP / MOVE_DURATION);
+        }
+    }
+
+    // Drop finished tweens in place
+    int remaining = 0;
+    for (int i = 0; i < tweenCount; i++)
+    {
+        if (tweens[i].progress < 1.0f)
+        {
+            tweens[remaining++] = tweens[i];
+        }
+    }
+    tweenCount = remaining;
+    if (tweenCount == 0)
+    {
+        accumulator = 0;
+    }
+
+    piecesDirty = true;
+    return true; // Also true on the frame the last tween lands, so it gets drawn in place
+}
+
+void BoardRenderer::finishAnimations()
+{
+    if (tweenCount > 0)
+    {
+        tweenCount = 0;
+        accumulator = 0;
+        piecesDirty = true;
+    }
+}
+
+bool BoardRenderer::isHidden(int x, int y) const
+{
+    for (int i = 0; i < tweenCount; i++)
+    {
+        if (tweens[i].toX == x && tweens[i].toY == y)
+            return true;
+    }
+    return false;
+}
+
+void BoardRenderer::rebuildPieces()
+{
+    // clear() keeps the capacity, so rebuilding every animation frame does not allocate
+    pieces.clear();
+    if (atlas)
+    {
+        float width = squareSize * pieceScale;
+        for (int x = 0; x < 8; x++)
+        {
+            for (int y = 0; y < 8; y++)
+            {
+                if (cells[x][y] != 0 && !isHidden(x, y))
+                {
+                    Vector2f corner = toScreen(x, y);
+                    atlas->appendPiece(pieces, cells[x][y], corner.x + squareSize / 2, corner.y + squareSize / 2, width);
+                }
+            }
+        }
+
+        // Captured pieces fade out underneath the pieces moving onto them
+        for (int i = 0; i < tweenCount; i++)
+        {
+            const PieceTween &tween = tweens[i];
+            if (tween.captured != 0)
+            {
+                Color fade(255, 255, 255, static_cast<Uint8>(255 * (1.0f - tween.progress)));
+                Vector2f corner = toScreen(tween.capturedX, tween.capturedY);
+                atlas->appendPiece(pieces, tween.captured, corner.x + squareSize / 2, corner.y + squareSize / 2,
+                                   width, fade);
+            }
+        }
+
+        for (int i = 0; i < tweenCount; i++)
+        {
+            const PieceTween &tween = tweens[i];
+            float t = tween.progress * tween.progress * (3 - 2 * tween.progress); // Ease in and out
+            Vector2f position = tween.from + (tween.to - tween.from) * t;
+            Vector2f corner = toScreen(position.x, position.y);
+            atlas->appendPiece(pieces, tween.piece, corner.x + squareSize / 2, corner.y + squareSize / 2, width);
+        }
+    }
+
+    piecesDirty = false;
+    rebuilds++;
+}
+
+void BoardRenderer::addRect(float x, float y, float width, float height, const Color &color)
+{
+    Vertex topLeft(Vector2f(x, y), color);
+    Vertex topRight(Vector2f(x + width, y), color);
+    Vertex bottomRight(Vector2f(x + width, y + height), color);
+    Vertex bottomLeft(Vector2f(x, y + height), color);
+
+    vertices.append(topLeft);
+    vertices.append(topRight);
+    vertices.append(bottomRight);
+    vertices.append(topLeft);
+    vertices.append(bottomRight);
+    vertices.append(bottomLeft);
+}
+
+void BoardRenderer::addCircle(float centerX, float centerY, float radius, const Color &color)
+{
+    const float step = 2 * 3.14159265f / CIRCLE_SEGMENTS;
+    Vertex center(Vector2f(centerX, centerY), color);
+    for (int i = 0; i < CIRCLE_SEGMENTS; i++)
+    {
+        vertices.append(center);
+        vertices.append(Vertex(Vector2f(centerX + radius * cos(i * step), centerY + radius * sin(i * step)), color));
+        vertices.append(Vertex(Vector2f(centerX + radius * cos((i + 1) * step), centerY + radius * sin((i + 1) * step)), color));
+    }
+}
+
+void BoardRenderer::appendGeometry(VertexArray &squares, VertexArray &pieceVertices, Vector2f offset) const
+{
+    for (size_t i = 0; i < vertices.getVertexCount(); i++)
+    {
+        Vertex vertex = vertices[i];
+        vertex.position += offset;
+        squares.append(vertex);
+    }
+    for (size_t i = 0; i < pieces.getVertexCount(); i++)
+    {
+        Vertex vertex = pieces[i];
+        vertex.position += offset;
+        pieceVertices.append(vertex);
+    }
+}
+
+void BoardRenderer::draw(RenderTarget &target, RenderStates states) const
+{
+    target.draw(vertices, states);
+
+    if (atlas && pieces.getVertexCount() > 0)
+    {
+        states.texture = &atlas->getTexture();
+        target.draw(pieces, states);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef BOARDRENDERER_H
+#define BOARDRENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "PieceAtlas.h"
+
+using namespace std;
+using namespace sf;
+
+// Draws the board squares, the selected-square highlight and the valid move
+// indicators from one cached vertex array, and all pieces from a second one
+// textured with the piece atlas: two draw calls per board. The geometry is only
+// rebuilt when the square size, selection, move list or board changes, or on
+// every frame while a move is sliding into place.
+class BoardRenderer : public Drawable
+{
+private:
+    VertexArray vertices; // Triangles: 64 squares, then move indicators on top
+    VertexArray pieces;   // Triangles textured from the atlas
+    const PieceAtlas *atlas;
+    float pieceScale;     // Piece width as a fraction of the square
+
+    // Inputs the cached geometry was built from
+    float squareSize;
+    int selectedX;
+    int selectedY;
+    vector<pair<int, int>> moves;
+    int cells[8][8];
+    bool flipped; // Black at the bottom
+    bool dirty;
+    bool piecesDirty;
+    unsigned int rebuilds;
+
+    // A piece sliding from one square to another (positions in squares)
+    struct PieceTween
+    {
+        int piece;          // Drawn while moving; a promoting pawn stays a pawn until it lands
+        int toX, toY;       // The board already holds the result here, hidden until the tween ends
+        Vector2f from;
+        Vector2f to;
+        int captured;       // Piece fading out on the capture square, 0 if none
+        int capturedX, capturedY;
+        float progress;     // 0 to 1
+    };
+
+    static const int MAX_TWEENS = 4; // A move plus a castling rook, with room for a reply
+    PieceTween tweens[MAX_TWEENS];   // Fixed storage, so animating never allocates
+    int tweenCount;
+    float accumulator;               // Time not yet consumed by fixed steps
+
+    void rebuild();
+    void rebuildPieces();
+    bool isHidden(int x, int y) const;
+    Vector2f toScreen(float x, float y) const; // Board square to its top-left corner
+    void addRect(float x, float y, float width, float height, const Color &color);
+    void addCircle(float centerX, float centerY, float radius, const Color &color);
+
+    virtual void draw(RenderTarget &target, RenderStates states) const;
+
+public:
+    BoardRenderer();
+
+    // Bring the cached geometry up to date; returns true if it had to be rebuilt
+    bool update(const vector<vector<int>> &board, float squareSize,
+                int selectedX, int selectedY, const vector<pair<int, int>> &validMoves);
+    void invalidate() { dirty = piecesDirty = true; }
+
+    // Animate a move that is about to be applied to the board (call before the board changes).
+    // capturedX/Y is the square of a captured piece if it differs from the target (en passant).
+    void animateMove(const vector<vector<int>> &board, int fromX, int fromY, int toX, int toY,
+                     int capturedX = -1, int capturedY = -1);
+    // Advance animations with fixed time steps; returns true while something is moving
+    bool advance(float seconds);
+    bool isAnimating() const { return tweenCount > 0; }
+    void finishAnimations();
+    void setAtlas(const PieceAtlas *pieceAtlas, float pieceScale);
+
+    // Draw the board from Black's side; board coordinates stay the same for callers
+    void setFlipped(bool flipped);
+    bool isFlipped() const { return flipped; }
+
+    // Copy the cached geometry, moved by offset, into shared arrays so several boards
+    // can be drawn with one draw call per array (see MultiBoardView)
+    void appendGeometry(VertexArray &squares, VertexArray &pieceVertices, Vector2f offset) const;
+
+    size_t getVertexCount() const { return vertices.getVertexCount() + pieces.getVertexCount(); }
+    size_t getDrawCallCount() const { return atlas && pieces.getVertexCount() > 0 ? 2 : 1; }
+    unsigned int getRebuildCount() const { return rebuilds; }
+
+    static Color squareColor(int x, int y); // Light or dark, as drawn
+};
+
+#endif // BOARDRENDERER_H
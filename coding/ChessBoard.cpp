@@ -3,10 +3,14 @@
 #include <iostream>
 #include "GameLogic.h"
 #include "ChessBoard.h"
+#include "GameAnalyzer.h"
+#include "Zobrist.h"
 #include <fstream>
 #include <algorithm>
 #include <random>
 #include <chrono>
+#include <cstdio>
+#include <cstdint>
 #include <direct.h>   // For _getcwd
 #include <stdlib.h>   // For MAX_PATH
 #include <sys/stat.h> // For stat and file checking
@@ -14,6 +18,32 @@
 using namespace std;
 using namespace sf;
 
+static const int IDLE_POLL_MS = 8; // Sleep between polls while nothing needs redrawing
+static const char *POSITION_INDEX_FILE = "games.cpi"; // Built with --index
+static const size_t EXPLORER_MOVES = 8;               // Moves listed in the explorer panel
+static const char *GAME_ARCHIVE_FILE = "games.cga";   // Every finished game, see --archive
+
+// Helper function to get where the running game's files are kept
+static string workingFilePath(const string &name)
+{
+    char cwd[1024];
+    if (_getcwd(cwd, sizeof(cwd)) == NULL)
+    {
+        cerr << "Error getting current directory" << endl;
+        return name;
+    }
+    return string(cwd) + "/" + name;
+}
+
+// Taken during static initialization, before main runs
+static const chrono::steady_clock::time_point launchTime = chrono::steady_clock::now();
+
+// Helper function for the startup timing report
+static long long millisecondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+}
+
 // Define the global variables here (declared as extern in ChessBoard.h)
 int WINDOW_WIDTH = 700;  // Reduced from 773
 int WINDOW_HEIGHT = 700; // Reduced from 773
@@ -36,10 +66,30 @@ ChessBoard::ChessBoard() : window(VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Chess
                            serverPort(50000),
                            waitingForOpponent(false),
                            opponentConnected(false),
-                           waitingForMove(false)
+                           waitingForMove(false),
+                           pgnWriter(workingFilePath("temp_game.pgn"), workingFilePath(GAME_ARCHIVE_FILE)),
+                           pgnMovesPosted(0),
+                           pgnResult("*"),
+                           redrawNeeded(true),
+                           showHud(false),
+                           showExplorer(false),
+                           explorerOpened(false),
+                           explorerPly(SIZE_MAX)
 {
     // Initialize SQUARE_SIZE based on initial window dimensions
-    SQUARE_SIZE = WINDOW_WIDTH / static_cast<float>(BOARD_SIZE);
+    SQUARE_SIZE = std::min(WINDOW_WIDTH, WINDOW_HEIGHT) / static_cast<float>(BOARD_SIZE);
+    updateLayout();
+
+    // Menus redraw every frame; don't let them run faster than the screen
+    window.setFramerateLimit(60);
+
+    // Decode the menu assets and the piece images on the loader threads; run() and
+    // loadTexture() collect them and create the textures here on the main thread
+    assets.requestImage("coding/images/mainscreen.jpg");
+    assets.requestFile("coding/font/Arial.ttf");
+    assets.requestImage("coding/images/logo.png");
+    PieceAtlas::requestImages("coding/images", assets);
+    SoundBank::requestFiles("coding/sounds", assets);
 }
 
 vector<vector<int>> &ChessBoard::getMatrix()
@@ -47,6 +97,22 @@ vector<vector<int>> &ChessBoard::getMatrix()
     return board;
 }
 
+bool ChessBoard::setStartFen(const string &fen)
+{
+    FenPosition position;
+    string error;
+    if (!Fen::parse(fen, position, error))
+    {
+        cerr << "Invalid FEN: " << error << endl;
+        return false;
+    }
+    startPosition = position;
+    startFen = Fen::write(position);
+    if (startFen == Fen::START)
+        startFen.clear();
+    return true;
+}
+
 void ChessBoard::setPiece(int x, int y, int value)
 {
     if (x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE)
@@ -66,29 +132,17 @@ int ChessBoard::getPiece(int x, int y) const
 
 bool ChessBoard::loadTexture()
 {
-    string pieceNames[6] = {"Pawn", "Rook", "Knight", "Bishop", "Queen", "King"};
-
-    for (int i = 0; i < 6; i++)
+    // The images are read once; later games reuse the atlas
+    if (!pieceAtlas.isLoaded() && !pieceAtlas.loadImages("coding/images", &assets))
     {
-        if (!blackpieces[i].loadFromFile("coding/images/black" + pieceNames[i] + ".png"))
-        {
-            cout << "Failed to load black " << pieceNames[i] << " texture" << endl;
-            return false;
-        }
-        if (!whitepieces[i].loadFromFile("coding/images/white" + pieceNames[i] + ".png"))
-        {
-            cout << "Failed to load white " << pieceNames[i] << " texture" << endl;
-            return false;
-        }
-
-        blackSprites[i].setTexture(blackpieces[i]);
-        // float scale = (SQUARE_SIZE * PIECE_SCALE) / blackSprites[i].getTexture()->getSize().x; // Scaling moved
-        // blackSprites[i].setScale(scale * SCALE_FACTOR, scale * SCALE_FACTOR); // Scaling moved
-
-        whiteSprites[i].setTexture(whitepieces[i]);
-        // scale = (SQUARE_SIZE * PIECE_SCALE) / whiteSprites[i].getTexture()->getSize().x; // Scaling moved
-        // whiteSprites[i].setScale(scale * SCALE_FACTOR, scale * SCALE_FACTOR); // Scaling moved
+        return false;
+    }
+    float pieceWidth = layout.squarePixels * PIECE_SCALE * SCALE_FACTOR;
+    if (pieceAtlas.getCellSize() == 0 && !pieceAtlas.build(PieceAtlas::cellSizeFor(pieceWidth)))
+    {
+        return false;
     }
+    boardRenderer.setAtlas(&pieceAtlas, PIECE_SCALE * SCALE_FACTOR);
     return true;
 }
 
@@ -98,6 +152,13 @@ void ChessBoard::initBoard()
     // Positive for white, negative for black
     // 6: Rook, 7: Bishop, 8: Knight, 9: King, 10: Pawn, 11: Queen
 
+    // A position given with --fen replaces the standard setup
+    if (!startFen.empty())
+    {
+        board = startPosition.board;
+        return;
+    }
+
     // Clear the board first
     for (int i = 0; i < 8; i++)
     {
@@ -141,108 +202,166 @@ void ChessBoard::initBoard()
     board[7][7] = 6;  // White rook
 }
 
-void ChessBoard::initializePieces()
+void ChessBoard::playMoveAnimations()
+{
+    Clock clock;
+    while (boardRenderer.isAnimating() && window.isOpen())
+    {
+        boardRenderer.advance(clock.restart().asSeconds());
+        window.clear(Color::Black);
+        drawBoard();
+        window.display(); // Paced by the frame rate limit
+    }
+}
+
+void ChessBoard::drawBoard(int selectedX, int selectedY, const vector<pair<int, int>> &validMoves)
+{
+    // Only rebuilds its vertices when something it shows has changed
+    boardRenderer.update(board, SQUARE_SIZE, selectedX, selectedY, validMoves);
+    window.draw(boardRenderer);
+    FrameProfiler::instance().addDrawCalls(boardRenderer.getDrawCallCount(), boardRenderer.getVertexCount());
+}
+
+void ChessBoard::drawHud()
+{
+    // Drawn in window pixels so it stays readable whatever the board view is scaled to
+    View boardView = window.getView();
+    Vector2u windowSize = window.getSize();
+    window.setView(View(FloatRect(0, 0, windowSize.x, windowSize.y)));
+
+    hudText.setFont(font);
+    hudText.setCharacterSize(14);
+    hudText.setFillColor(Color::White);
+    hudText.setString(FrameProfiler::instance().report());
+    hudText.setPosition(8, 6);
+
+    FloatRect bounds = hudText.getGlobalBounds();
+    hudBackground.setPosition(0, 0);
+    hudBackground.setSize(Vector2f(bounds.left + bounds.width + 8, bounds.top + bounds.height + 8));
+    hudBackground.setFillColor(Color(0, 0, 0, 170));
+
+    window.draw(hudBackground);
+    window.draw(hudText);
+    FrameProfiler::instance().addDrawCalls(2, 0);
+    window.setView(boardView);
+}
+
+void ChessBoard::updateExplorer()
 {
-    // Initialize the 2D array (8x8) with empty sprites first
-    pieceSprites.resize(BOARD_SIZE, vector<Sprite>(BOARD_SIZE));
+    if (explorerPly == moveHistory.size())
+        return;
+    explorerPly = moveHistory.size();
 
-    // Clear all sprites
-    for (int x = 0; x < BOARD_SIZE; x++)
+    string report;
+    vector<PositionMoveStats> moves;
+    if (!positionIndex.isOpen())
+    {
+        report = string("No position index: build ") + POSITION_INDEX_FILE + " with --index";
+    }
+    else
     {
-        for (int y = 0; y < BOARD_SIZE; y++)
+        string uciMoves;
+        for (const string &move : moveHistory)
         {
-            pieceSprites[x][y] = Sprite(); // Empty sprite
+            uciMoves += (uciMoves.empty() ? "" : " ") + move;
         }
+        uint64_t key = Zobrist::hashUciMoves(uciMoves, startPosition.board, startPosition.whiteToMove,
+                                             startPosition.castlingRights, startPosition.enPassantCol);
+        if (!positionIndex.lookup(key, moves))
+            report = "Position not in the index";
     }
 
-    // Initialize pieces based on board values
-    for (int x = 0; x < BOARD_SIZE; x++)
+    if (!moves.empty())
     {
-        for (int y = 0; y < BOARD_SIZE; y++)
+        uint32_t total = 0;
+        for (const PositionMoveStats &move : moves)
         {
-            int pieceValue = board[x][y];
-            if (pieceValue != 0)
-            {
-                bool isWhite = pieceValue > 0;
-                int absValue = abs(pieceValue);
-                int spriteIndex = -1;
-
-                // Map piece value to sprite index
-                switch (absValue)
-                {
-                case 10:
-                    spriteIndex = 0;
-                    break; // Pawn
-                case 6:
-                    spriteIndex = 1;
-                    break; // Rook
-                case 8:
-                    spriteIndex = 2;
-                    break; // Knight
-                case 7:
-                    spriteIndex = 3;
-                    break; // Bishop
-                case 11:
-                    spriteIndex = 4;
-                    break; // Queen
-                case 9:
-                    spriteIndex = 5;
-                    break; // King
-                }
-
-                if (spriteIndex != -1)
-                {
-                    pieceSprites[x][y] = isWhite ? whiteSprites[spriteIndex] : blackSprites[spriteIndex];
-                }
-            }
+            total += move.games;
+        }
+        report = to_string(total) + " games    white / draw / black";
+        for (size_t i = 0; i < moves.size() && i < EXPLORER_MOVES; i++)
+        {
+            const PositionMoveStats &move = moves[i];
+            string san = logic.moveToSan(move.fromX(), move.fromY(), move.toX(), move.toY(),
+                                         move.promotion() != 0 ? move.promotion() : 11);
+            char line[96];
+            snprintf(line, sizeof(line), "\n%-7s %7u    %3.0f%% / %3.0f%% / %3.0f%%", san.c_str(), move.games,
+                     100.0 * move.whiteWins / move.games, 100.0 * move.draws / move.games,
+                     100.0 * move.blackWins / move.games);
+            report += line;
         }
     }
+    explorerText.setString(report);
 }
 
-void ChessBoard::drawPiece(Sprite sprite, int x, int y)
-{
-    sprite.setPosition(x * SQUARE_SIZE + (SQUARE_SIZE - sprite.getGlobalBounds().width) / 2,
-                       y * SQUARE_SIZE + (SQUARE_SIZE - sprite.getGlobalBounds().height) / 2);
-    window.draw(sprite);
-}
-
-void ChessBoard::drawPieces()
+void ChessBoard::drawExplorer()
 {
-    for (int x = 0; x < BOARD_SIZE; ++x)
+    if (!explorerOpened)
     {
-        for (int y = 0; y < BOARD_SIZE; ++y)
-        {
-            // Check if there's a piece at this position
-            if (pieceSprites[x][y].getTexture() != nullptr)
-            {
-                drawPiece(pieceSprites[x][y], x, y);
-            }
-        }
+        explorerOpened = true;
+        positionIndex.open(POSITION_INDEX_FILE);
     }
+    updateExplorer();
+
+    // In window pixels like the HUD, along the bottom edge
+    View boardView = window.getView();
+    Vector2u windowSize = window.getSize();
+    window.setView(View(FloatRect(0, 0, windowSize.x, windowSize.y)));
+
+    explorerText.setFont(font);
+    explorerText.setCharacterSize(14);
+    explorerText.setFillColor(Color::White);
+    FloatRect bounds = explorerText.getLocalBounds();
+    float top = windowSize.y - bounds.top - bounds.height - 14;
+    explorerText.setPosition(8, top);
+
+    explorerBackground.setPosition(0, top - 6);
+    explorerBackground.setSize(Vector2f(bounds.left + bounds.width + 16, windowSize.y - top + 6));
+    explorerBackground.setFillColor(Color(0, 0, 0, 170));
+
+    window.draw(explorerBackground);
+    window.draw(explorerText);
+    FrameProfiler::instance().addDrawCalls(2, 0);
+    window.setView(boardView);
 }
 
 void ChessBoard::run()
 {
     // Load menu background
-    if (!menuTexture.loadFromFile("coding/images/mainscreen.jpg"))
+    Image menuImage;
+    if (!assets.takeImage("coding/images/mainscreen.jpg", menuImage) || !menuTexture.loadFromImage(menuImage))
     {
         cout << "Failed to load menu background!" << endl;
         return;
     }
     menuSprite.setTexture(menuTexture);
 
-    // Scale the menu background to fit the window
+    // Scale the menu background to the logical area once; the view handles window resizes
     float scaleX = static_cast<float>(WINDOW_WIDTH) / menuTexture.getSize().x;
     float scaleY = static_cast<float>(WINDOW_HEIGHT) / menuTexture.getSize().y;
     menuSprite.setScale(scaleX, scaleY);
 
     // Load font for buttons
-    if (!font.loadFromFile("coding/font/Arial.ttf"))
+    if (!assets.takeFile("coding/font/Arial.ttf", fontData) || !font.loadFromMemory(fontData.data(), fontData.size()))
     {
         cout << "Failed to load font!" << endl;
         return;
     }
 
+    // Sounds are decoded once here; moves only pick a voice and play
+    sounds.load("coding/sounds", &assets);
+
+    // Set window icon, once for the menus and the game
+    Image icon;
+    if (!assets.takeImage("coding/images/logo.png", icon))
+    {
+        cout << "Failed to load window icon!" << endl;
+    }
+    else
+    {
+        window.setIcon(icon.getSize().x, icon.getSize().y, icon.getPixelsPtr());
+    }
+
     // Show menu first
     if (!showMenu())
     {
@@ -250,21 +369,14 @@ void ChessBoard::run()
         return;
     }
 
-    // Initialize Stockfish if needed
+    modeChosen = chrono::steady_clock::now();
+
+    // Stockfish was started in the background when the mode was picked; the board
+    // comes up right away and the first engine move waits for it if necessary
     if (currentMode == GameMode::VsComputer)
     {
-        engine = make_unique<StockfishEngine>();
-        if (!engine->initialize())
-        {
-            cout << "Failed to initialize Stockfish engine. Reverting to two-player mode." << endl;
-            currentMode = GameMode::TwoPlayer;
-        }
-        else
-        {
-            engine->setDifficulty(static_cast<int>(computerDifficulty));
-            moveHistory.clear();
-            currentPosition = "";
-        }
+        moveHistory.clear();
+        currentPosition = "";
     }
     // For LAN games, network initialization is handled in showNetworkOptions
 
@@ -273,72 +385,47 @@ void ChessBoard::run()
 
     // If user selected start, run the game
     runGame();
-}
 
-bool ChessBoard::showMenu()
-{
-    // Set window icon
-    Image icon;
-    if (!icon.loadFromFile("coding/images/logo.png"))
+    if (waitForEngine())
     {
-        cout << "Failed to load window icon!" << endl;
+        const EngineHealth &health = engine->getHealth();
+        cout << "Engine health: " << health.restarts << " restarts (" << health.totalRestartMs << " ms), "
+             << health.timeouts << " stopped searches, " << health.pings << " pings (last "
+             << health.lastPingMs << " ms, max " << health.maxPingMs << " ms)" << endl;
     }
-    else
+
+    // Keep engine results for the next session
+    if (engine && positionCache.size() > 0)
     {
-        window.setIcon(icon.getSize().x, icon.getSize().y, icon.getPixelsPtr());
+        positionCache.saveToFile("engine_cache.bin");
     }
+}
 
+bool ChessBoard::showMenu()
+{
     // Create buttons
     float buttonHeight = 60;
     float buttonSpacing = 20;
     float totalHeight = 4 * buttonHeight + 3 * buttonSpacing;
     float startY = WINDOW_HEIGHT / 2 - totalHeight / 2;
 
-    RectangleShape twoPlayerButton(Vector2f(300, buttonHeight));
-    twoPlayerButton.setPosition(WINDOW_WIDTH / 2 - 150, startY);
-    twoPlayerButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape vsComputerButton(Vector2f(300, buttonHeight));
-    vsComputerButton.setPosition(WINDOW_WIDTH / 2 - 150, startY + buttonHeight + buttonSpacing);
-    vsComputerButton.setFillColor(Color(50, 50, 50, 200));
+    // Background, buttons and labels are rendered once and drawn as one sprite
+    menuLayer.setFont(font);
+    menuLayer.clear();
+    menuLayer.setBackground(menuSprite);
 
-    RectangleShape hostLANButton(Vector2f(300, buttonHeight));
-    hostLANButton.setPosition(WINDOW_WIDTH / 2 - 150, startY + 2 * (buttonHeight + buttonSpacing));
-    hostLANButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape joinLANButton(Vector2f(300, buttonHeight));
-    joinLANButton.setPosition(WINDOW_WIDTH / 2 - 150, startY + 3 * (buttonHeight + buttonSpacing));
-    joinLANButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape exitButton(Vector2f(300, buttonHeight));
-    exitButton.setPosition(WINDOW_WIDTH / 2 - 150, startY + 4 * (buttonHeight + buttonSpacing));
-    exitButton.setFillColor(Color(50, 50, 50, 200));
-
-    float fontSize = 30;
-    Text twoPlayerText("Play Two-Player", font, fontSize);
-    twoPlayerText.setPosition(WINDOW_WIDTH / 2 - twoPlayerText.getLocalBounds().width / 2,
-                              twoPlayerButton.getPosition().y + (buttonHeight - twoPlayerText.getLocalBounds().height) / 2);
-    twoPlayerText.setFillColor(Color::White);
-
-    Text vsComputerText("Play vs Computer", font, fontSize);
-    vsComputerText.setPosition(WINDOW_WIDTH / 2 - vsComputerText.getLocalBounds().width / 2,
-                               vsComputerButton.getPosition().y + (buttonHeight - vsComputerText.getLocalBounds().height) / 2);
-    vsComputerText.setFillColor(Color::White);
-
-    Text hostLANText("Host LAN Game", font, fontSize);
-    hostLANText.setPosition(WINDOW_WIDTH / 2 - hostLANText.getLocalBounds().width / 2,
-                            hostLANButton.getPosition().y + (buttonHeight - hostLANText.getLocalBounds().height) / 2);
-    hostLANText.setFillColor(Color::White);
-
-    Text joinLANText("Join LAN Game", font, fontSize);
-    joinLANText.setPosition(WINDOW_WIDTH / 2 - joinLANText.getLocalBounds().width / 2,
-                            joinLANButton.getPosition().y + (buttonHeight - joinLANText.getLocalBounds().height) / 2);
-    joinLANText.setFillColor(Color::White);
-
-    Text exitText("Exit Game", font, fontSize);
-    exitText.setPosition(WINDOW_WIDTH / 2 - exitText.getLocalBounds().width / 2,
-                         exitButton.getPosition().y + (buttonHeight - exitText.getLocalBounds().height) / 2);
-    exitText.setFillColor(Color::White);
+    const string labels[5] = {"Play Two-Player", "Play vs Computer", "Host LAN Game", "Join LAN Game", "Exit Game"};
+    int buttons[5];
+    unsigned int fontSize = 30;
+    for (int i = 0; i < 5; i++)
+    {
+        FloatRect button(WINDOW_WIDTH / 2 - 150, startY + i * (buttonHeight + buttonSpacing), 300, buttonHeight);
+        buttons[i] = menuLayer.addPanel(button, Color(50, 50, 50, 200));
+        menuLayer.addCenteredLabel(labels[i], fontSize, Color::White, button);
+    }
+    const int twoPlayerButton = buttons[0], vsComputerButton = buttons[1], hostLANButton = buttons[2],
+              joinLANButton = buttons[3], exitButton = buttons[4];
+    bool firstFrame = true;
 
     while (window.isOpen())
     {
@@ -351,24 +438,31 @@ bool ChessBoard::showMenu()
                 return false;
             }
 
+            if (event.type == Event::Resized)
+            {
+                updateLayout();
+            }
+
             if (event.type == Event::MouseButtonPressed)
             {
-                Vector2i mousePos = Mouse::getPosition(window);
-                if (twoPlayerButton.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                Vector2f mousePos = window.mapPixelToCoords(Vector2i(event.mouseButton.x, event.mouseButton.y));
+                int clicked = menuLayer.findPanel(mousePos);
+                if (clicked == twoPlayerButton)
                 {
                     currentMode = GameMode::TwoPlayer;
                     return true; // Start game
                 }
-                else if (vsComputerButton.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                else if (clicked == vsComputerButton)
                 {
                     currentMode = GameMode::VsComputer;
+                    startEngine(); // Starts while the player picks a colour and difficulty
                     if (!showComputerOptions())
                     {
                         return false; // User cancelled
                     }
                     return true; // Start game with computer
                 }
-                else if (hostLANButton.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                else if (clicked == hostLANButton)
                 {
                     currentMode = GameMode::LANHost;
                     playerIsWhite = true; // Host always plays as white
@@ -378,7 +472,7 @@ bool ChessBoard::showMenu()
                     }
                     return true; // Start LAN game as host
                 }
-                else if (joinLANButton.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                else if (clicked == joinLANButton)
                 {
                     currentMode = GameMode::LANClient;
                     playerIsWhite = false; // Client always plays as black
@@ -388,34 +482,32 @@ bool ChessBoard::showMenu()
                     }
                     return true; // Start LAN game as client
                 }
-                else if (exitButton.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                else if (clicked == exitButton)
                 {
                     return false; // Exit game
                 }
             }
         }
 
-        // Highlight buttons on hover
-        Vector2i mousePos = Mouse::getPosition(window);
-        twoPlayerButton.setFillColor(twoPlayerButton.getGlobalBounds().contains(mousePos.x, mousePos.y) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
-        vsComputerButton.setFillColor(vsComputerButton.getGlobalBounds().contains(mousePos.x, mousePos.y) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
-        hostLANButton.setFillColor(hostLANButton.getGlobalBounds().contains(mousePos.x, mousePos.y) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
-        joinLANButton.setFillColor(joinLANButton.getGlobalBounds().contains(mousePos.x, mousePos.y) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
-        exitButton.setFillColor(exitButton.getGlobalBounds().contains(mousePos.x, mousePos.y) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
+        // Highlight buttons on hover; the layer only re-renders when the hovered button changes
+        int hovered = menuLayer.findPanel(window.mapPixelToCoords(Mouse::getPosition(window)));
+        for (int i = 0; i < 5; i++)
+        {
+            menuLayer.setPanelColor(buttons[i], buttons[i] == hovered ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
+        }
+
+        // Re-rendered at the new resolution after a resize, otherwise a no-op
+        menuLayer.setArea(FloatRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT), layout.pixelScale);
 
         window.clear();
-        window.draw(menuSprite);
-        window.draw(twoPlayerButton);
-        window.draw(vsComputerButton);
-        window.draw(hostLANButton);
-        window.draw(joinLANButton);
-        window.draw(exitButton);
-        window.draw(twoPlayerText);
-        window.draw(vsComputerText);
-        window.draw(hostLANText);
-        window.draw(joinLANText);
-        window.draw(exitText);
+        window.draw(menuLayer);
         window.display();
+
+        if (firstFrame)
+        {
+            firstFrame = false;
+            cout << "Startup: menu ready " << millisecondsSince(launchTime) << " ms after launch" << endl;
+        }
     }
 
     return false;
@@ -423,12 +515,7 @@ bool ChessBoard::showMenu()
 
 bool ChessBoard::showComputerOptions()
 {
-    // Get the same scaling factors as used in the main menu
-    float scaleX = static_cast<float>(WINDOW_WIDTH) / menuTexture.getSize().x;
-    float scaleY = static_cast<float>(WINDOW_HEIGHT) / menuTexture.getSize().y;
-    menuSprite.setScale(scaleX, scaleY);
-
-    // Calculate scalable positions based on window dimensions
+    // Positions are in the logical space; the view scales them to the window
     centerX = WINDOW_WIDTH / 2.0f;
     centerY = WINDOW_HEIGHT / 2.0f;
     buttonWidth = WINDOW_WIDTH * 0.2f;
@@ -438,14 +525,25 @@ bool ChessBoard::showComputerOptions()
     difficultyY = centerY + verticalOffset + buttonHeight + verticalSpacing * 3;
     backButtonY = difficultyY + buttonHeight + verticalSpacing * 3;
 
-    // Create buttons and text for computer options
-    RectangleShape colorWhiteButton(Vector2f(buttonWidth, buttonHeight));
-    colorWhiteButton.setPosition(centerX - buttonWidth - (WINDOW_WIDTH * 0.02f), centerY + verticalOffset);
-    colorWhiteButton.setFillColor(Color(50, 50, 50, 200));
+    // Prepare font sizes
+    unsigned int largeFontSize = WINDOW_HEIGHT * 0.04f;
+    unsigned int mediumFontSize = WINDOW_HEIGHT * 0.035f;
+    unsigned int smallFontSize = WINDOW_HEIGHT * 0.025f; // Smaller for 5 buttons
+
+    const Color buttonColor(50, 50, 50, 200);
+    const Color selectedColor(100, 200, 100, 220);
+    const Color hoverColor(70, 70, 70, 220);
 
-    RectangleShape colorBlackButton(Vector2f(buttonWidth, buttonHeight));
-    colorBlackButton.setPosition(centerX + (WINDOW_WIDTH * 0.02f), centerY + verticalOffset);
-    colorBlackButton.setFillColor(Color(50, 50, 50, 200));
+    // Everything on this screen is rendered once into the menu layer and drawn as one sprite
+    menuLayer.setFont(font);
+    menuLayer.clear();
+    menuLayer.setBackground(menuSprite);
+
+    // Color buttons
+    FloatRect whiteBox(centerX - buttonWidth - (WINDOW_WIDTH * 0.02f), centerY + verticalOffset, buttonWidth, buttonHeight);
+    FloatRect blackBox(centerX + (WINDOW_WIDTH * 0.02f), centerY + verticalOffset, buttonWidth, buttonHeight);
+    int colorWhiteButton = menuLayer.addPanel(whiteBox, buttonColor);
+    int colorBlackButton = menuLayer.addPanel(blackBox, buttonColor);
 
     // Difficulty Buttons (5 buttons with adjusted width)
     float difficultyButtonWidth = WINDOW_WIDTH * 0.1f; // Smaller buttons to fit 5
@@ -453,147 +551,36 @@ bool ChessBoard::showComputerOptions()
     float totalDifficultyWidth = 5 * difficultyButtonWidth + 4 * horizontalSpacing;
     float firstDifficultyX = centerX - totalDifficultyWidth / 2.0f;
 
-    RectangleShape easyButton(Vector2f(difficultyButtonWidth, buttonHeight));
-    easyButton.setPosition(firstDifficultyX, difficultyY);
-    easyButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape kindaEasyButton(Vector2f(difficultyButtonWidth, buttonHeight));
-    kindaEasyButton.setPosition(firstDifficultyX + difficultyButtonWidth + horizontalSpacing, difficultyY);
-    kindaEasyButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape mediumButton(Vector2f(difficultyButtonWidth, buttonHeight));
-    mediumButton.setPosition(firstDifficultyX + 2 * (difficultyButtonWidth + horizontalSpacing), difficultyY);
-    mediumButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape kindaMediumButton(Vector2f(difficultyButtonWidth, buttonHeight));
-    kindaMediumButton.setPosition(firstDifficultyX + 3 * (difficultyButtonWidth + horizontalSpacing), difficultyY);
-    kindaMediumButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape hardButton(Vector2f(difficultyButtonWidth, buttonHeight));
-    hardButton.setPosition(firstDifficultyX + 4 * (difficultyButtonWidth + horizontalSpacing), difficultyY);
-    hardButton.setFillColor(Color(50, 50, 50, 200));
-
-    RectangleShape backButton(Vector2f(buttonWidth, buttonHeight));
-    backButton.setPosition(centerX - buttonWidth / 2, backButtonY);
-    backButton.setFillColor(Color(50, 50, 50, 200));
-
-    // Prepare font sizes
-    float largeFontSize = WINDOW_HEIGHT * 0.04f;
-    float mediumFontSize = WINDOW_HEIGHT * 0.035f;
-    float smallFontSize = WINDOW_HEIGHT * 0.025f; // Smaller for 5 buttons
-
-    // Button texts
-    chooseColorText.setFont(font);
-    chooseColorText.setString("Choose your color:");
-    chooseColorText.setCharacterSize(largeFontSize);
-    chooseColorText.setPosition(centerX - chooseColorText.getLocalBounds().width / 2,
-                                centerY + verticalOffset - buttonHeight);
-    chooseColorText.setFillColor(Color::White);
-
-    whiteText.setFont(font);
-    whiteText.setString("White");
-    whiteText.setCharacterSize(mediumFontSize);
-    whiteText.setPosition(colorWhiteButton.getPosition().x + (buttonWidth - whiteText.getLocalBounds().width) / 2,
-                          colorWhiteButton.getPosition().y + (buttonHeight - whiteText.getLocalBounds().height) / 2);
-    whiteText.setFillColor(Color::White);
-
-    blackText.setFont(font);
-    blackText.setString("Black");
-    blackText.setCharacterSize(mediumFontSize);
-    blackText.setPosition(colorBlackButton.getPosition().x + (buttonWidth - blackText.getLocalBounds().width) / 2,
-                          colorBlackButton.getPosition().y + (buttonHeight - blackText.getLocalBounds().height) / 2);
-    blackText.setFillColor(Color::White);
-
-    difficultyText.setFont(font);
-    difficultyText.setString("Choose difficulty:");
-    difficultyText.setCharacterSize(largeFontSize);
-    difficultyText.setPosition(centerX - difficultyText.getLocalBounds().width / 2,
-                               difficultyY - buttonHeight);
-    difficultyText.setFillColor(Color::White);
-
-    // Button texts for difficulty levels
-    Text easyText("Easy", font, smallFontSize);
-    easyText.setPosition(easyButton.getPosition().x + (difficultyButtonWidth - easyText.getLocalBounds().width) / 2,
-                         easyButton.getPosition().y + (buttonHeight - easyText.getLocalBounds().height) / 2);
-    easyText.setFillColor(Color::White);
-
-    Text kindaEasyText("K-Easy", font, smallFontSize);
-    kindaEasyText.setPosition(kindaEasyButton.getPosition().x + (difficultyButtonWidth - kindaEasyText.getLocalBounds().width) / 2,
-                              kindaEasyButton.getPosition().y + (buttonHeight - kindaEasyText.getLocalBounds().height) / 2);
-    kindaEasyText.setFillColor(Color::White);
-
-    Text mediumText("Medium", font, smallFontSize);
-    mediumText.setPosition(mediumButton.getPosition().x + (difficultyButtonWidth - mediumText.getLocalBounds().width) / 2,
-                           mediumButton.getPosition().y + (buttonHeight - mediumText.getLocalBounds().height) / 2);
-    mediumText.setFillColor(Color::White);
-
-    Text kindaMediumText("K-Medium", font, smallFontSize);
-    kindaMediumText.setPosition(kindaMediumButton.getPosition().x + (difficultyButtonWidth - kindaMediumText.getLocalBounds().width) / 2,
-                                kindaMediumButton.getPosition().y + (buttonHeight - kindaMediumText.getLocalBounds().height) / 2);
-    kindaMediumText.setFillColor(Color::White);
-
-    Text hardText("Hard", font, smallFontSize);
-    hardText.setPosition(hardButton.getPosition().x + (difficultyButtonWidth - hardText.getLocalBounds().width) / 2,
-                         hardButton.getPosition().y + (buttonHeight - hardText.getLocalBounds().height) / 2);
-    hardText.setFillColor(Color::White);
-
-    backText.setFont(font);
-    backText.setString("Back");
-    backText.setCharacterSize(mediumFontSize);
-    backText.setPosition(backButton.getPosition().x + (buttonWidth - backText.getLocalBounds().width) / 2,
-                         backButton.getPosition().y + (buttonHeight - backText.getLocalBounds().height) / 2);
-    backText.setFillColor(Color::White);
-
-    // Function to reset difficulty button colors
-    auto resetDifficultyColors = [&]()
-    {
-        easyButton.setFillColor(Color(50, 50, 50, 200));
-        kindaEasyButton.setFillColor(Color(50, 50, 50, 200));
-        mediumButton.setFillColor(Color(50, 50, 50, 200));
-        kindaMediumButton.setFillColor(Color(50, 50, 50, 200));
-        hardButton.setFillColor(Color(50, 50, 50, 200));
-    };
-
-    // Highlight current selections
-    if (playerIsWhite)
-    {
-        colorWhiteButton.setFillColor(Color(100, 200, 100, 220));
-    }
-    else
+    const string difficultyLabels[5] = {"Easy", "K-Easy", "Medium", "K-Medium", "Hard"};
+    const ComputerDifficulty difficulties[5] = {ComputerDifficulty::Easy, ComputerDifficulty::kindaEasy,
+                                                ComputerDifficulty::Medium, ComputerDifficulty::kindaMedium,
+                                                ComputerDifficulty::Hard};
+    int difficultyButtons[5];
+    for (int i = 0; i < 5; i++)
     {
-        colorBlackButton.setFillColor(Color(100, 200, 100, 220));
+        FloatRect box(firstDifficultyX + i * (difficultyButtonWidth + horizontalSpacing), difficultyY,
+                      difficultyButtonWidth, buttonHeight);
+        difficultyButtons[i] = menuLayer.addPanel(box, buttonColor);
+        menuLayer.addCenteredLabel(difficultyLabels[i], smallFontSize, Color::White, box);
     }
 
-    resetDifficultyColors(); // Start with default colors
-    switch (computerDifficulty)
-    {
-    case ComputerDifficulty::Easy:
-        easyButton.setFillColor(Color(100, 200, 100, 220));
-        break;
-    case ComputerDifficulty::kindaEasy:
-        kindaEasyButton.setFillColor(Color(100, 200, 100, 220));
-        break;
-    case ComputerDifficulty::Medium:
-        mediumButton.setFillColor(Color(100, 200, 100, 220));
-        break;
-    case ComputerDifficulty::kindaMedium:
-        kindaMediumButton.setFillColor(Color(100, 200, 100, 220));
-        break;
-    case ComputerDifficulty::Hard:
-        hardButton.setFillColor(Color(100, 200, 100, 220));
-        break;
-    }
+    FloatRect backBox(centerX - buttonWidth / 2, backButtonY, buttonWidth, buttonHeight);
+    int backButton = menuLayer.addPanel(backBox, buttonColor);
+
+    // Headings and button texts
+    FloatRect chooseColorBounds = menuLayer.measure("Choose your color:", largeFontSize);
+    menuLayer.addLabel("Choose your color:", largeFontSize, Color::White,
+                       Vector2f(centerX - chooseColorBounds.width / 2, centerY + verticalOffset - buttonHeight));
+    menuLayer.addCenteredLabel("White", mediumFontSize, Color::White, whiteBox);
+    menuLayer.addCenteredLabel("Black", mediumFontSize, Color::White, blackBox);
 
-    bool needsRedraw = false;
+    FloatRect difficultyBounds = menuLayer.measure("Choose difficulty:", largeFontSize);
+    menuLayer.addLabel("Choose difficulty:", largeFontSize, Color::White,
+                       Vector2f(centerX - difficultyBounds.width / 2, difficultyY - buttonHeight));
+    menuLayer.addCenteredLabel("Back", mediumFontSize, Color::White, backBox);
 
     while (window.isOpen())
     {
-        if (needsRedraw)
-        {
-            // Rebuild UI with new dimensions
-            return showComputerOptions();
-        }
-
         Event event;
         while (window.pollEvent(event))
         {
@@ -607,112 +594,56 @@ bool ChessBoard::showComputerOptions()
             {
                 // Get mouse position relative to the window
                 Vector2f mousePosF = window.mapPixelToCoords(Mouse::getPosition(window));
+                int clicked = menuLayer.findPanel(mousePosF);
 
                 // Color selection
-                if (colorWhiteButton.getGlobalBounds().contains(mousePosF))
+                if (clicked == colorWhiteButton)
                 {
                     playerIsWhite = true;
-                    colorWhiteButton.setFillColor(Color(100, 200, 100, 220));
-                    colorBlackButton.setFillColor(Color(50, 50, 50, 200));
                 }
-                else if (colorBlackButton.getGlobalBounds().contains(mousePosF))
+                else if (clicked == colorBlackButton)
                 {
                     playerIsWhite = false;
-                    colorBlackButton.setFillColor(Color(100, 200, 100, 220));
-                    colorWhiteButton.setFillColor(Color(50, 50, 50, 200));
-                }
-                // Difficulty selection
-                else if (easyButton.getGlobalBounds().contains(mousePosF))
-                {
-                    computerDifficulty = ComputerDifficulty::Easy;
-                    resetDifficultyColors();
-                    easyButton.setFillColor(Color(100, 200, 100, 220));
-                }
-                else if (kindaEasyButton.getGlobalBounds().contains(mousePosF))
-                {
-                    computerDifficulty = ComputerDifficulty::kindaEasy;
-                    resetDifficultyColors();
-                    kindaEasyButton.setFillColor(Color(100, 200, 100, 220));
-                }
-                else if (mediumButton.getGlobalBounds().contains(mousePosF))
-                {
-                    computerDifficulty = ComputerDifficulty::Medium;
-                    resetDifficultyColors();
-                    mediumButton.setFillColor(Color(100, 200, 100, 220));
-                }
-                else if (kindaMediumButton.getGlobalBounds().contains(mousePosF))
-                {
-                    computerDifficulty = ComputerDifficulty::kindaMedium;
-                    resetDifficultyColors();
-                    kindaMediumButton.setFillColor(Color(100, 200, 100, 220));
-                }
-                else if (hardButton.getGlobalBounds().contains(mousePosF))
-                {
-                    computerDifficulty = ComputerDifficulty::Hard;
-                    resetDifficultyColors();
-                    hardButton.setFillColor(Color(100, 200, 100, 220));
                 }
                 // Back button
-                else if (backButton.getGlobalBounds().contains(mousePosF))
+                else if (clicked == backButton)
                 {
                     return true; // Return to main menu with options selected
                 }
+                // Difficulty selection
+                else
+                {
+                    for (int i = 0; i < 5; i++)
+                    {
+                        if (clicked == difficultyButtons[i])
+                        {
+                            computerDifficulty = difficulties[i];
+                        }
+                    }
+                }
             }
 
-            // Handle window resize events
+            // Only the view changes; the layout above is in logical units
             if (event.type == Event::Resized)
             {
-                // Update view to match new window size
-                FloatRect visibleArea(0, 0, event.size.width, event.size.height);
-                window.setView(View(visibleArea));
-
-                // Update window dimensions
-                WINDOW_WIDTH = event.size.width;
-                WINDOW_HEIGHT = event.size.height;
-
-                // Scale menu background
-                scaleX = static_cast<float>(WINDOW_WIDTH) / menuTexture.getSize().x;
-                scaleY = static_cast<float>(WINDOW_HEIGHT) / menuTexture.getSize().y;
-                menuSprite.setScale(scaleX, scaleY);
-
-                // Set flag to redraw UI
-                needsRedraw = true;
+                updateLayout();
             }
         }
 
-        // Get mouse position in world coordinates for hover effects
-        Vector2f mousePosF = window.mapPixelToCoords(Mouse::getPosition(window));
-
-        // Highlight back button on hover
-        if (backButton.getGlobalBounds().contains(mousePosF))
+        // Highlight current selections and the back button on hover; the layer is only
+        // rendered again when one of these colours actually changes
+        menuLayer.setPanelColor(colorWhiteButton, playerIsWhite ? selectedColor : buttonColor);
+        menuLayer.setPanelColor(colorBlackButton, playerIsWhite ? buttonColor : selectedColor);
+        for (int i = 0; i < 5; i++)
         {
-            backButton.setFillColor(Color(70, 70, 70, 220));
-        }
-        else
-        {
-            backButton.setFillColor(Color(50, 50, 50, 200));
+            menuLayer.setPanelColor(difficultyButtons[i], computerDifficulty == difficulties[i] ? selectedColor : buttonColor);
         }
+        Vector2f mousePosF = window.mapPixelToCoords(Mouse::getPosition(window));
+        menuLayer.setPanelColor(backButton, menuLayer.findPanel(mousePosF) == backButton ? hoverColor : buttonColor);
+        menuLayer.setArea(FloatRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT), layout.pixelScale);
 
         window.clear();
-        window.draw(menuSprite);
-        window.draw(chooseColorText);
-        window.draw(colorWhiteButton);
-        window.draw(colorBlackButton);
-        window.draw(whiteText);
-        window.draw(blackText);
-        window.draw(difficultyText);
-        window.draw(easyButton);
-        window.draw(kindaEasyButton);
-        window.draw(mediumButton);
-        window.draw(kindaMediumButton);
-        window.draw(hardButton);
-        window.draw(easyText);
-        window.draw(kindaEasyText);
-        window.draw(mediumText);
-        window.draw(kindaMediumText);
-        window.draw(hardText);
-        window.draw(backButton);
-        window.draw(backText);
+        window.draw(menuLayer);
         window.display();
     }
 
@@ -721,63 +652,125 @@ bool ChessBoard::showComputerOptions()
 
 bool ChessBoard::showGameOverWindow(bool whiteWinner)
 {
+    // The background board is static from here on; put any moving piece in place
+    boardRenderer.finishAnimations();
+    sounds.play(SoundEffect::GameEnd);
+
     // Get current view to match scaling
     View currentView = window.getView();
+    float panelWidth = 0, panelHeight = 0, fontScaleFactor = 1;
+    int analysisButton = -1, newGameButton = -1;
 
-    // Semi-transparent overlay using current view dimensions
-    RectangleShape overlay(Vector2f(currentView.getSize().x, currentView.getSize().y));
-    overlay.setPosition(currentView.getCenter() - currentView.getSize() / 2.f);
-    overlay.setFillColor(Color(0, 0, 0, 180)); // Semi-transparent black
-
-    // Game over panel - scaled to match viewport
-    float panelWidth = currentView.getSize().x * 0.5f;
-    float panelHeight = currentView.getSize().y * 0.4f;
-    RectangleShape panel(Vector2f(panelWidth, panelHeight));
-    panel.setPosition(
-        currentView.getCenter().x - panelWidth / 2,
-        currentView.getCenter().y - panelHeight / 2);
-    panel.setFillColor(Color(50, 50, 50, 250));
-
-    // Scale fonts based on view size
-    float fontScaleFactor = std::min(currentView.getSize().x, currentView.getSize().y) / 773.0f;
-
-    // Winner text
-    Text winnerText;
-    winnerText.setFont(font);
-    winnerText.setString(whiteWinner ? "White Wins!" : "Black Wins!");
-    winnerText.setCharacterSize(static_cast<unsigned int>(40 * fontScaleFactor));
-    winnerText.setFillColor(Color::White);
-    winnerText.setPosition(
-        currentView.getCenter().x - winnerText.getLocalBounds().width / 2,
-        panel.getPosition().y + panelHeight * 0.1f);
-
-    // Analysis button
-    float buttonWidth = panelWidth * 0.75f;
-    float buttonHeight = panelHeight * 0.2f;
-    RectangleShape analysisButton(Vector2f(buttonWidth, buttonHeight));
-    analysisButton.setPosition(
-        currentView.getCenter().x - buttonWidth / 2,
-        panel.getPosition().y + panelHeight * 0.4f);
-    analysisButton.setFillColor(Color(70, 70, 70, 220));
-
-    Text analysisText("Proceed to Analysis", font, static_cast<unsigned int>(25 * fontScaleFactor));
-    analysisText.setPosition(
-        currentView.getCenter().x - analysisText.getLocalBounds().width / 2,
-        analysisButton.getPosition().y + (buttonHeight - analysisText.getLocalBounds().height) / 2 - 5);
-    analysisText.setFillColor(Color::White);
-
-    // New game button
-    RectangleShape newGameButton(Vector2f(buttonWidth, buttonHeight));
-    newGameButton.setPosition(
-        currentView.getCenter().x - buttonWidth / 2,
-        panel.getPosition().y + panelHeight * 0.7f);
-    newGameButton.setFillColor(Color(70, 70, 70, 220));
-
-    Text newGameText("Play Another Game", font, static_cast<unsigned int>(25 * fontScaleFactor));
-    newGameText.setPosition(
-        currentView.getCenter().x - newGameText.getLocalBounds().width / 2,
-        newGameButton.getPosition().y + (buttonHeight - newGameText.getLocalBounds().height) / 2 - 5);
-    newGameText.setFillColor(Color::White);
+    // Overlay, panel, buttons and texts all live in the menu layer, which is laid out
+    // again (and so rendered again) only when the window is resized
+    auto layoutGameOver = [&]()
+    {
+        Vector2f viewSize = currentView.getSize();
+        Vector2f viewOrigin = currentView.getCenter() - viewSize / 2.f;
+
+        menuLayer.setFont(font);
+        menuLayer.setArea(FloatRect(viewOrigin, viewSize), layout.pixelScale);
+        menuLayer.clear();
+
+        // Semi-transparent overlay using current view dimensions
+        menuLayer.addPanel(FloatRect(viewOrigin, viewSize), Color(0, 0, 0, 180));
+
+        // Game over panel - scaled to match viewport
+        panelWidth = viewSize.x * 0.5f;
+        panelHeight = viewSize.y * 0.4f;
+        FloatRect panel(currentView.getCenter().x - panelWidth / 2, currentView.getCenter().y - panelHeight / 2,
+                        panelWidth, panelHeight);
+        menuLayer.addPanel(panel, Color(50, 50, 50, 250));
+
+        // Scale fonts based on view size
+        fontScaleFactor = std::min(viewSize.x, viewSize.y) / 773.0f;
+
+        // Winner text
+        string winner = whiteWinner ? "White Wins!" : "Black Wins!";
+        unsigned int winnerSize = static_cast<unsigned int>(40 * fontScaleFactor);
+        menuLayer.addLabel(winner, winnerSize, Color::White,
+                           Vector2f(currentView.getCenter().x - menuLayer.measure(winner, winnerSize).width / 2,
+                                    panel.top + panelHeight * 0.1f));
+
+        // Analysis and new game buttons
+        float buttonWidth = panelWidth * 0.75f;
+        float buttonHeight = panelHeight * 0.2f;
+        unsigned int buttonFontSize = static_cast<unsigned int>(25 * fontScaleFactor);
+        FloatRect analysisBox(currentView.getCenter().x - buttonWidth / 2, panel.top + panelHeight * 0.4f,
+                              buttonWidth, buttonHeight);
+        FloatRect newGameBox(currentView.getCenter().x - buttonWidth / 2, panel.top + panelHeight * 0.7f,
+                             buttonWidth, buttonHeight);
+        analysisButton = menuLayer.addPanel(analysisBox, Color(70, 70, 70, 220));
+        newGameButton = menuLayer.addPanel(newGameBox, Color(70, 70, 70, 220));
+        menuLayer.addCenteredLabel("Proceed to Analysis", buttonFontSize, Color::White, analysisBox, -5);
+        menuLayer.addCenteredLabel("Play Another Game", buttonFontSize, Color::White, newGameBox, -5);
+    };
+    layoutGameOver();
+
+    // Starts the analysis viewer on the game's PGN, and on the native analysis if a path is given
+    auto launchViewer = [&](const string &analysisPath)
+    {
+        // Create a temporary file to pass the PGN to the electron app
+        char cwd[1024];
+        if (_getcwd(cwd, sizeof(cwd)) != NULL)
+        {
+            // Get the PGN file path
+            string pgnFilePath = string(cwd) + "/temp_game.pgn";
+            string analysisArgument = analysisPath.empty() ? "" : " \"" + analysisPath + "\"";
+
+            // Create a simple batch file to launch the analyzer
+            string tempBatPath = string(cwd) + "\\temp_launch.bat";
+            ofstream batFile(tempBatPath);
+            if (batFile.is_open())
+            {
+                batFile << "@echo off\n";
+                batFile << "cd \"" << cwd << "\\chessAnalysis\"\n";
+                batFile << "node_modules\\.bin\\electron . \"" << pgnFilePath << "\"" << analysisArgument << "\n";
+                batFile.close();
+
+                // Launch the batch file
+                string cmd = "start \"Chess Analyzer\" \"" + tempBatPath + "\"";
+                system(cmd.c_str());
+            }
+            else
+            {
+                // Fallback to direct command if batch file creation fails
+                string cmd = "start cmd /c \"cd \"" + string(cwd) + "\\chessAnalysis\" && node_modules\\.bin\\electron . \"" + pgnFilePath + "\"" + analysisArgument + "\"";
+                system(cmd.c_str());
+            }
+
+            // Show a message to the user about the analysis tool
+            RectangleShape infoPanel(Vector2f(panelWidth, panelHeight * 0.3f));
+            infoPanel.setPosition(
+                currentView.getCenter().x - panelWidth / 2,
+                currentView.getCenter().y - panelHeight * 0.15f);
+            infoPanel.setFillColor(Color(50, 100, 50, 250));
+
+            Text infoText("Launching Chess Analyzer. Please wait while it loads...", font, static_cast<unsigned int>(16 * fontScaleFactor));
+            infoText.setPosition(
+                currentView.getCenter().x - infoText.getLocalBounds().width / 2,
+                infoPanel.getPosition().y + (infoPanel.getSize().y - infoText.getLocalBounds().height) / 2);
+            infoText.setFillColor(Color::White);
+
+            window.draw(infoPanel);
+            window.draw(infoText);
+            window.display();
+
+            // Wait for a moment so the user can see the message
+            sf::sleep(sf::seconds(3));
+        }
+        else
+        {
+            cerr << "Error getting current directory" << endl;
+        }
+    };
+
+    // Shown over the panel while the game is analysed
+    RectangleShape progressPanel;
+    progressPanel.setFillColor(Color(50, 100, 50, 250));
+    Text progressText("", font);
+    progressText.setFillColor(Color::White);
+    size_t progressShown = SIZE_MAX;
 
     while (window.isOpen())
     {
@@ -786,6 +779,7 @@ bool ChessBoard::showGameOverWindow(bool whiteWinner)
         {
             if (event.type == Event::Closed)
             {
+                cancelGameAnalysis();
                 window.close();
                 return false;
             }
@@ -796,74 +790,27 @@ bool ChessBoard::showGameOverWindow(bool whiteWinner)
                 Vector2f mousePos = window.mapPixelToCoords(Vector2i(event.mouseButton.x, event.mouseButton.y));
 
                 // Check if analysis button was clicked
-                if (analysisButton.getGlobalBounds().contains(mousePos))
+                if (menuLayer.findPanel(mousePos) == analysisButton && !gameAnalysis.valid())
                 {
-                    // Generate PGN from the game and update the file
+                    // Generate PGN from the game and wait until the file is complete
                     updatePgnFile();
+                    pgnWriter.flush();
 
-                    // Create a temporary file to pass the PGN to the electron app
-                    char cwd[1024];
-                    if (_getcwd(cwd, sizeof(cwd)) != NULL)
-                    {
-                        // Get the PGN file path
-                        string pgnFilePath = string(cwd) + "/temp_game.pgn";
-
-                        // Create a simple batch file to launch the analyzer
-                        string tempBatPath = string(cwd) + "\\temp_launch.bat";
-                        ofstream batFile(tempBatPath);
-                        if (batFile.is_open())
-                        {
-                            batFile << "@echo off\n";
-                            batFile << "cd \"" << cwd << "\\chessAnalysis\"\n";
-                            batFile << "node_modules\\.bin\\electron . \"" << pgnFilePath << "\"\n";
-                            batFile.close();
-
-                            // Launch the batch file
-                            string cmd = "start \"Chess Analyzer\" \"" + tempBatPath + "\"";
-                            system(cmd.c_str());
-                        }
-                        else
-                        {
-                            // Fallback to direct command if batch file creation fails
-                            string cmd = "start cmd /c \"cd \"" + string(cwd) + "\\chessAnalysis\" && node_modules\\.bin\\electron . \"" + pgnFilePath + "\"\"";
-                            system(cmd.c_str());
-                        }
-
-                        // Show a message to the user about the analysis tool
-                        RectangleShape infoPanel(Vector2f(panelWidth, panelHeight * 0.3f));
-                        infoPanel.setPosition(
-                            currentView.getCenter().x - panelWidth / 2,
-                            currentView.getCenter().y - panelHeight * 0.15f);
-                        infoPanel.setFillColor(Color(50, 100, 50, 250));
-
-                        Text infoText("Launching Chess Analyzer. Please wait while it loads...", font, static_cast<unsigned int>(16 * fontScaleFactor));
-                        infoText.setPosition(
-                            currentView.getCenter().x - infoText.getLocalBounds().width / 2,
-                            infoPanel.getPosition().y + (infoPanel.getSize().y - infoText.getLocalBounds().height) / 2);
-                        infoText.setFillColor(Color::White);
-
-                        window.draw(infoPanel);
-                        window.draw(infoText);
-                        window.display();
-
-                        // Wait for a moment so the user can see the message
-                        sf::sleep(sf::seconds(3));
-                    }
-                    else
+                    // Native engine evaluation of every position in the background; the
+                    // viewer is launched once it is done, and this window runs meanwhile
+                    if (!startGameAnalysis())
                     {
-                        cerr << "Error getting current directory" << endl;
+                        launchViewer("");
+                        return false; // Close the game over window but keep the main window open
                     }
-
-                    return false; // Close the game over window but keep the main window open
                 }
 
                 // Check if new game button was clicked
-                if (newGameButton.getGlobalBounds().contains(mousePos))
+                if (menuLayer.findPanel(mousePos) == newGameButton)
                 {
                     // Reset the game completely
-                    initBoard();                // Reset board array to starting position
-                    initializePieces();         // Reset all piece sprites
-                    updateBoardAndPieceSizes(); // Ensure pieces are properly scaled
+                    cancelGameAnalysis();
+                    initBoard(); // Reset board array to starting position
                     gameOver = false;
                     return true;
                 }
@@ -872,96 +819,52 @@ bool ChessBoard::showGameOverWindow(bool whiteWinner)
             // Handle window resize
             if (event.type == Event::Resized)
             {
-                // Update the view
-                updateBoardAndPieceSizes();
-                currentView = window.getView();
-
-                // Update all UI elements based on new view
-                overlay.setSize(Vector2f(currentView.getSize().x, currentView.getSize().y));
-                overlay.setPosition(currentView.getCenter() - currentView.getSize() / 2.f);
-
-                panelWidth = currentView.getSize().x * 0.5f;
-                panelHeight = currentView.getSize().y * 0.4f;
-                panel.setSize(Vector2f(panelWidth, panelHeight));
-                panel.setPosition(
-                    currentView.getCenter().x - panelWidth / 2,
-                    currentView.getCenter().y - panelHeight / 2);
-
-                fontScaleFactor = std::min(currentView.getSize().x, currentView.getSize().y) / 773.0f;
-
-                winnerText.setCharacterSize(static_cast<unsigned int>(40 * fontScaleFactor));
-                winnerText.setPosition(
-                    currentView.getCenter().x - winnerText.getLocalBounds().width / 2,
-                    panel.getPosition().y + panelHeight * 0.1f);
-
-                buttonWidth = panelWidth * 0.75f;
-                buttonHeight = panelHeight * 0.2f;
-
-                analysisButton.setSize(Vector2f(buttonWidth, buttonHeight));
-                analysisButton.setPosition(
-                    currentView.getCenter().x - buttonWidth / 2,
-                    panel.getPosition().y + panelHeight * 0.4f);
-
-                analysisText.setCharacterSize(static_cast<unsigned int>(25 * fontScaleFactor));
-                analysisText.setPosition(
-                    currentView.getCenter().x - analysisText.getLocalBounds().width / 2,
-                    analysisButton.getPosition().y + (buttonHeight - analysisText.getLocalBounds().height) / 2 - 5);
-
-                newGameButton.setSize(Vector2f(buttonWidth, buttonHeight));
-                newGameButton.setPosition(
-                    currentView.getCenter().x - buttonWidth / 2,
-                    panel.getPosition().y + panelHeight * 0.7f);
-
-                newGameText.setCharacterSize(static_cast<unsigned int>(25 * fontScaleFactor));
-                newGameText.setPosition(
-                    currentView.getCenter().x - newGameText.getLocalBounds().width / 2,
-                    newGameButton.getPosition().y + (buttonHeight - newGameText.getLocalBounds().height) / 2 - 5);
+                // The logical view is unchanged; only the layer's resolution follows the window
+                updateLayout();
+                layoutGameOver();
+                progressShown = SIZE_MAX;
             }
         }
 
-        // Highlight buttons on hover
-        Vector2f mousePos = window.mapPixelToCoords(Mouse::getPosition(window));
-
-        if (analysisButton.getGlobalBounds().contains(mousePos))
+        // The viewer starts once the native analysis is done
+        if (gameAnalysis.valid() && gameAnalysis.wait_for(chrono::seconds(0)) == future_status::ready)
         {
-            analysisButton.setFillColor(Color(100, 100, 100, 220));
-        }
-        else
-        {
-            analysisButton.setFillColor(Color(70, 70, 70, 220));
+            launchViewer(writeGameAnalysis());
+            return false; // Close the game over window but keep the main window open
         }
 
-        if (newGameButton.getGlobalBounds().contains(mousePos))
-        {
-            newGameButton.setFillColor(Color(100, 100, 100, 220));
-        }
-        else
-        {
-            newGameButton.setFillColor(Color(70, 70, 70, 220));
-        }
+        // Highlight buttons on hover
+        Vector2f mousePos = window.mapPixelToCoords(Mouse::getPosition(window));
+        int hovered = menuLayer.findPanel(mousePos);
+        menuLayer.setPanelColor(analysisButton, hovered == analysisButton ? Color(100, 100, 100, 220) : Color(70, 70, 70, 220));
+        menuLayer.setPanelColor(newGameButton, hovered == newGameButton ? Color(100, 100, 100, 220) : Color(70, 70, 70, 220));
 
         // Keep rendering the game in the background
-        // Draw the game board (copied from runGame)
-        for (int x = 0; x < BOARD_SIZE; x++)
+        drawBoard();
+
+        // Draw overlay and game over elements
+        window.draw(menuLayer);
+
+        // Analysis progress, laid out again only when the count moves on
+        if (gameAnalysis.valid())
         {
-            for (int y = 0; y < BOARD_SIZE; y++)
+            size_t done = gameAnalyzer->getProgress();
+            if (done != progressShown)
             {
-                RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-                square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-                square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62));
-                window.draw(square);
+                progressShown = done;
+                progressText.setCharacterSize(static_cast<unsigned int>(16 * fontScaleFactor));
+                progressText.setString("Analysing position " + to_string(min(done + 1, gameAnalyzer->getPositionCount())) +
+                                       " of " + to_string(gameAnalyzer->getPositionCount()) + "...");
+                progressPanel.setSize(Vector2f(panelWidth, panelHeight * 0.15f));
+                progressPanel.setPosition(currentView.getCenter().x - panelWidth / 2,
+                                          currentView.getCenter().y + panelHeight / 2 - progressPanel.getSize().y);
+                progressText.setPosition(
+                    currentView.getCenter().x - progressText.getLocalBounds().width / 2,
+                    progressPanel.getPosition().y + (progressPanel.getSize().y - progressText.getLocalBounds().height) / 2);
             }
+            window.draw(progressPanel);
+            window.draw(progressText);
         }
-        drawPieces();
-
-        // Draw overlay and game over elements
-        window.draw(overlay);
-        window.draw(panel);
-        window.draw(winnerText);
-        window.draw(analysisButton);
-        window.draw(analysisText);
-        window.draw(newGameButton);
-        window.draw(newGameText);
 
         window.display();
     }
@@ -971,29 +874,17 @@ bool ChessBoard::showGameOverWindow(bool whiteWinner)
 
 void ChessBoard::runGame()
 {
-    // Set window icon
-    Image icon;
-    if (!icon.loadFromFile("coding/images/logo.png"))
-    {
-        cout << "Failed to load window icon!" << endl;
-    }
-    else
-    {
-        window.setIcon(icon.getSize().x, icon.getSize().y, icon.getPixelsPtr());
-    }
-
     initBoard();
     if (!loadTexture())
     {
         cout << "Failed to load textures!" << endl;
         return;
     }
-    initializePieces();
 
-    // Initial calculation of sizes and scales
-    updateBoardAndPieceSizes();
+    // Initial view and atlas resolution for the current window size
+    updateLayout();
 
-    GameLogic logic(getMatrix(), *this);
+    logic.setPosition(startPosition);
     bool pieceSelected = false;
     int selectedX = -1, selectedY = -1;
 
@@ -1001,82 +892,63 @@ void ChessBoard::runGame()
 
     // Draw the initial board state to ensure the window is rendered
     window.clear(Color::Black);
-    for (int x = 0; x < BOARD_SIZE; x++)
-    {
-        for (int y = 0; y < BOARD_SIZE; y++)
-        {
-            RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-            square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-            square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62));
-            window.draw(square);
-        }
-    }
-    drawPieces();
+    drawBoard();
     window.display();
-
-    // Add a small delay to ensure the window is fully rendered
-    sf::sleep(sf::milliseconds(500));
+    cout << "Startup: first board frame " << millisecondsSince(modeChosen) << " ms after mode selection" << endl;
 
     // Initialize the PGN file at the start of the game
     updatePgnFile();
 
-    // If playing as black against computer, make the first move for the computer (white)
-    if (currentMode == GameMode::VsComputer && !playerIsWhite)
+    // If the computer has the first move (it plays White, or the start position has its side to move), make it
+    if (currentMode == GameMode::VsComputer && whiteTurn != playerIsWhite)
     {
-        makeComputerMove();
-        whiteTurn = false; // Now it's player's (black) turn
+        if (makeComputerMove())
+        {
+            whiteTurn = !whiteTurn; // Now it's the player's turn
+        }
 
         // Redraw the board after the computer's move
         window.clear(Color::Black);
-        for (int x = 0; x < BOARD_SIZE; x++)
-        {
-            for (int y = 0; y < BOARD_SIZE; y++)
-            {
-                RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-                square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-                square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62));
-                window.draw(square);
-            }
-        }
-        drawPieces();
+        drawBoard();
         window.display();
     }
 
     // For LAN games, show waiting message if needed
-    Text waitingText;
+    statusLayer.clear();
     if ((currentMode == GameMode::LANHost || currentMode == GameMode::LANClient) && waitingForOpponent)
     {
-        waitingText.setFont(font);
-        waitingText.setString("Waiting for opponent to connect...");
-        waitingText.setCharacterSize(WINDOW_HEIGHT * 0.03f);
-        waitingText.setPosition(WINDOW_WIDTH / 2 - waitingText.getLocalBounds().width / 2,
-                                WINDOW_HEIGHT * 0.1f);
-        waitingText.setFillColor(Color::Yellow);
-
-        window.draw(waitingText);
+        // Rendered once into a texture that only covers the message
+        string waitingMessage = "Waiting for opponent to connect...";
+        unsigned int waitingSize = WINDOW_HEIGHT * 0.03f;
+        statusLayer.setFont(font);
+        FloatRect bounds = statusLayer.measure(waitingMessage, waitingSize);
+        Vector2f position(WINDOW_WIDTH / 2 - bounds.width / 2, WINDOW_HEIGHT * 0.1f);
+        statusLayer.setArea(FloatRect(position.x, position.y, bounds.left + bounds.width + 2, bounds.top + bounds.height + 2),
+                            layout.pixelScale);
+        statusLayer.addLabel(waitingMessage, waitingSize, Color::Yellow, position);
+
+        window.draw(statusLayer);
         window.display();
     }
 
     vector<pair<int, int>> validMoves;
-    // Create circle shapes for valid move indicators
-    CircleShape moveIndicator(SQUARE_SIZE / 4);
-    moveIndicator.setOrigin(moveIndicator.getRadius(), moveIndicator.getRadius());
-    // Red circle for capture moves
-    CircleShape captureIndicator(SQUARE_SIZE / 3);
-    captureIndicator.setFillColor(Color(255, 0, 0, 150)); // Red semi-transparent
-    captureIndicator.setOrigin(captureIndicator.getRadius(), captureIndicator.getRadius());
+    size_t checkedMoveCount = static_cast<size_t>(-1); // Moves on the board when checkmate was last tested
+    Clock frameClock;                                  // Time step for piece animations
+    requestRedraw();
 
     while (window.isOpen())
     {
         // Handle network messages for LAN games
         if ((currentMode == GameMode::LANHost || currentMode == GameMode::LANClient) && network)
         {
-            handleNetworkMessages();
+            {
+                ScopedTimer timer(FramePhase::Network);
+                handleNetworkMessages();
+            }
 
-            // Update waiting text if needed
+            // While waiting for an opponent, only keep the window responsive
             if (waitingForOpponent)
             {
-                // Process events to keep the window responsive
                 Event event;
                 while (window.pollEvent(event))
                 {
@@ -1085,142 +957,110 @@ void ChessBoard::runGame()
                         window.close();
                         return;
                     }
-                }
-
-                // Clear the window and draw the board first
-                window.clear(Color::Black);
-                for (int x = 0; x < BOARD_SIZE; x++)
-                {
-                    for (int y = 0; y < BOARD_SIZE; y++)
+                    if (event.type != Event::MouseMoved)
                     {
-                        RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-                        square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-                        square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62));
-                        window.draw(square);
+                        requestRedraw();
                     }
                 }
-                drawPieces();
-
-                // Draw waiting message
-                waitingText.setString("Waiting for opponent to connect...");
-                waitingText.setPosition(WINDOW_WIDTH / 2 - waitingText.getLocalBounds().width / 2,
-                                        WINDOW_HEIGHT * 0.1f);
             }
         }
 
-        // Check for checkmate at start of each loop
-        if (!gameOver)
+        // Check for checkmate whenever a move was made (locally, by the engine or over the network)
+        bool mated = false;
+        if (!gameOver && algebraicMoves.size() != checkedMoveCount)
         {
-            if (logic.checkMate(whiteTurn))
-            {
-                gameOver = true;
-                whiteWon = !whiteTurn; // If it's white's turn and they're in checkmate, black won
+            ScopedTimer timer(FramePhase::Logic);
+            checkedMoveCount = algebraicMoves.size();
+            mated = logic.checkMate(whiteTurn);
+        }
+        if (mated)
+        {
+            gameOver = true;
+            whiteWon = !whiteTurn; // If it's white's turn and they're in checkmate, black won
+            updatePgnFile(); // The PGN gets its result before a new game can replace it
 
-                // Send game over message for network games
-                if ((currentMode == GameMode::LANHost || currentMode == GameMode::LANClient) && network && opponentConnected)
+            // Send game over message for network games
+            if ((currentMode == GameMode::LANHost || currentMode == GameMode::LANClient) && network && opponentConnected)
+            {
+                NetworkMessage gameOverMsg(MessageType::GameOver, whiteWon ? "white" : "black");
+                if (currentMode == GameMode::LANHost)
                 {
-                    NetworkMessage gameOverMsg(MessageType::GameOver, whiteWon ? "white" : "black");
-                    if (currentMode == GameMode::LANHost)
-                    {
-                        network->sendToAllClients(gameOverMsg);
-                    }
-                    else
-                    {
-                        network->sendToServer(gameOverMsg);
-                    }
+                    network->sendToAllClients(gameOverMsg);
                 }
-
-                // Show game over screen
-                bool continueGame = showGameOverWindow(whiteWon);
-                if (continueGame)
+                else
                 {
-                    // Reset the game completely
-                    resetGame();
+                    network->sendToServer(gameOverMsg);
+                }
+            }
 
-                    // Reset local game state variables
-                    pieceSelected = false;
-                    selectedX = -1;
-                    selectedY = -1;
-                    validMoves.clear();
+            // Show game over screen
+            bool continueGame = showGameOverWindow(whiteWon);
+            if (continueGame)
+            {
+                // Reset the game completely
+                resetGame();
 
-                    // Reset game logic
-                    logic.reset();
+                // Reset local game state variables
+                pieceSelected = false;
+                selectedX = -1;
+                selectedY = -1;
+                validMoves.clear();
 
-                    // If playing as black, we need to redraw after the computer's first move
-                    if (currentMode == GameMode::VsComputer && !playerIsWhite)
-                    {
-                        // Redraw the board after the computer's move
-                        window.clear(Color::Black);
-                        for (int x = 0; x < BOARD_SIZE; x++)
-                        {
-                            for (int y = 0; y < BOARD_SIZE; y++)
-                            {
-                                RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-                                square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-                                square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62));
-                                window.draw(square);
-                            }
-                        }
-                        drawPieces();
-                        window.display();
-                    }
-                    continue;
-                }
-                else
+                // Reset game logic to the start position
+                logic.setPosition(startPosition);
+
+                // If playing as black, we need to redraw after the computer's first move
+                if (currentMode == GameMode::VsComputer && !playerIsWhite)
                 {
-                    window.close();
-                    return;
+                    // Redraw the board after the computer's move
+                    window.clear(Color::Black);
+                    drawBoard();
+                    window.display();
                 }
+                continue;
+            }
+            else
+            {
+                window.close();
+                return;
             }
         }
 
         Event event;
         while (window.pollEvent(event))
         {
+            ScopedTimer eventTimer(FramePhase::Events);
+
+            // Only pointer movement leaves the picture unchanged
+            if (event.type != Event::MouseMoved)
+            {
+                requestRedraw();
+            }
+
             if (event.type == Event::Closed)
             {
                 window.close();
             }
-            // Handle window resizing
+            // F3 toggles the frame timing overlay
+            else if (event.type == Event::KeyPressed && event.key.code == Keyboard::F3)
+            {
+                showHud = !showHud;
+            }
+            // F4 toggles the opening explorer
+            else if (event.type == Event::KeyPressed && event.key.code == Keyboard::F4)
+            {
+                showExplorer = !showExplorer;
+            }
+            // F turns the board around
+            else if (event.type == Event::KeyPressed && event.key.code == Keyboard::F)
+            {
+                boardRenderer.setFlipped(!boardRenderer.isFlipped());
+            }
+            // Handle window resizing: the board is drawn in logical units, so only the
+            // view's viewport (and possibly the atlas resolution) changes
             else if (event.type == Event::Resized)
             {
-                // Recalculate sizes and scales
-                updateBoardAndPieceSizes();
-
-                // Set the view to the board size
-                float boardPixelSize = BOARD_SIZE * SQUARE_SIZE;
-                View view(FloatRect(0, 0, boardPixelSize, boardPixelSize));
-
-                // Calculate viewport to center the board and maintain aspect ratio
-                float windowWidth = static_cast<float>(event.size.width);
-                float windowHeight = static_cast<float>(event.size.height);
-                float viewportX = 0, viewportY = 0, viewportWidth = 1.0, viewportHeight = 1.0;
-
-                if (windowWidth > boardPixelSize)
-                { // Letterbox (wider than tall)
-                    viewportWidth = boardPixelSize / windowWidth;
-                    viewportX = (1.0f - viewportWidth) / 2.0f;
-                }
-                else if (windowHeight > boardPixelSize)
-                { // Pillarbox (taller than wide)
-                    viewportHeight = boardPixelSize / windowHeight;
-                    viewportY = (1.0f - viewportHeight) / 2.0f;
-                }
-                // If window is smaller than board in one dimension, the view still scales it down,
-                // but we adjust the viewport if the *other* dimension is larger.
-                else if (windowWidth < boardPixelSize && windowHeight > windowWidth)
-                {                                                                                      // Taller than wide aspect, but board wider than window
-                    viewportHeight = (boardPixelSize / boardPixelSize) * (windowWidth / windowHeight); // Aspect ratio correction
-                    viewportY = (1.0f - viewportHeight) / 2.0f;
-                }
-                else if (windowHeight < boardPixelSize && windowWidth > windowHeight)
-                {                                                                                     // Wider than tall aspect, but board taller than window
-                    viewportWidth = (boardPixelSize / boardPixelSize) * (windowHeight / windowWidth); // Aspect ratio correction
-                    viewportX = (1.0f - viewportWidth) / 2.0f;
-                }
-
-                view.setViewport(FloatRect(viewportX, viewportY, viewportWidth, viewportHeight));
-                window.setView(view);
+                updateLayout();
             }
             else if (event.type == Event::MouseButtonPressed)
             {
@@ -1239,6 +1079,13 @@ void ChessBoard::runGame()
                     boardX = std::max(0, std::min(BOARD_SIZE - 1, boardX));
                     boardY = std::max(0, std::min(BOARD_SIZE - 1, boardY));
 
+                    // Screen squares to board squares when Black is at the bottom
+                    if (boardRenderer.isFlipped())
+                    {
+                        boardX = BOARD_SIZE - 1 - boardX;
+                        boardY = BOARD_SIZE - 1 - boardY;
+                    }
+
                     cout << "Clicked Board: [" << boardX << "][" << boardY
                          << "] Mapped Coords: (" << worldPos.x << "," << worldPos.y
                          << ") Value: " << getPiece(boardX, boardY) << endl;
@@ -1255,6 +1102,7 @@ void ChessBoard::runGame()
                         if ((whiteTurn && getPiece(boardX, boardY) > 0) ||
                             (!whiteTurn && getPiece(boardX, boardY) < 0))
                         {
+                            ScopedTimer timer(FramePhase::Logic);
                             selectedX = boardX;
                             selectedY = boardY;
                             pieceSelected = true;
@@ -1296,22 +1144,27 @@ void ChessBoard::runGame()
 
                         if (isValid)
                         {
+                            // Record move in UCI format for Stockfish (and for post-game analysis in every mode),
+                            // before the move so a promoting pawn is still on the board
+                            string uciMove = moveToUci(selectedX, selectedY, boardX, boardY);
+
                             // Make the player move
-                            logic.movePiece(selectedX, selectedY, boardX, boardY);
+                            {
+                                ScopedTimer timer(FramePhase::Logic);
+                                logic.movePiece(selectedX, selectedY, boardX, boardY);
+                            }
 
                             // Update PGN file after each move
                             updatePgnFile();
 
-                            // Record move in UCI format for Stockfish
+                            moveHistory.push_back(uciMove);
                             if (currentMode == GameMode::VsComputer)
                             {
-                                string uciMove = moveToUci(selectedX, selectedY, boardX, boardY);
                                 if (!currentPosition.empty())
                                 {
                                     currentPosition += " ";
                                 }
                                 currentPosition += uciMove;
-                                moveHistory.push_back(uciMove);
                             }
                             // Send move to opponent for network games
                             else if ((currentMode == GameMode::LANHost || currentMode == GameMode::LANClient) && network && opponentConnected)
@@ -1329,6 +1182,7 @@ void ChessBoard::runGame()
                             {
                                 gameOver = true;
                                 whiteWon = whiteTurn; // Current player won
+                                updatePgnFile();
 
                                 // Show game over screen
                                 bool continueGame = showGameOverWindow(whiteWon);
@@ -1343,25 +1197,15 @@ void ChessBoard::runGame()
                                     selectedY = -1;
                                     validMoves.clear();
 
-                                    // Reset game logic
-                                    logic.reset();
+                                    // Reset game logic to the start position
+                                    logic.setPosition(startPosition);
 
                                     // If playing as black, we need to redraw after the computer's first move
                                     if (currentMode == GameMode::VsComputer && !playerIsWhite)
                                     {
                                         // Redraw the board after the computer's move
                                         window.clear(Color::Black);
-                                        for (int x = 0; x < BOARD_SIZE; x++)
-                                        {
-                                            for (int y = 0; y < BOARD_SIZE; y++)
-                                            {
-                                                RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-                                                square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-                                                square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62));
-                                                window.draw(square);
-                                            }
-                                        }
-                                        drawPieces();
+                                        drawBoard();
                                         window.display();
                                     }
                                     continue;
@@ -1377,8 +1221,12 @@ void ChessBoard::runGame()
                             if (!gameOver && currentMode == GameMode::VsComputer &&
                                 ((whiteTurn && !playerIsWhite) || (!whiteTurn && playerIsWhite)))
                             {
-                                makeComputerMove();
-                                whiteTurn = !whiteTurn; // Switch turns
+                                // Let the player's move land before the engine blocks the loop
+                                playMoveAnimations();
+                                if (makeComputerMove())
+                                {
+                                    whiteTurn = !whiteTurn; // Switch turns
+                                }
 
                                 // Update PGN file after computer move
                                 updatePgnFile();
@@ -1388,6 +1236,7 @@ void ChessBoard::runGame()
                                 {
                                     gameOver = true;
                                     whiteWon = whiteTurn; // Computer won
+                                    updatePgnFile();
 
                                     // Show game over screen
                                     bool continueGame = showGameOverWindow(whiteWon);
@@ -1402,25 +1251,15 @@ void ChessBoard::runGame()
                                         selectedY = -1;
                                         validMoves.clear();
 
-                                        // Reset game logic
-                                        logic.reset();
+                                        // Reset game logic to the start position
+                                        logic.setPosition(startPosition);
 
                                         // If playing as black, we need to redraw after the computer's first move
                                         if (currentMode == GameMode::VsComputer && !playerIsWhite)
                                         {
                                             // Redraw the board after the computer's move
                                             window.clear(Color::Black);
-                                            for (int x = 0; x < BOARD_SIZE; x++)
-                                            {
-                                                for (int y = 0; y < BOARD_SIZE; y++)
-                                                {
-                                                    RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-                                                    square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-                                                    square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62));
-                                                    window.draw(square);
-                                                }
-                                            }
-                                            drawPieces();
+                                            drawBoard();
                                             window.display();
                                         }
                                         continue;
@@ -1471,248 +1310,129 @@ void ChessBoard::runGame()
             }
         }
 
-        // Update the PGN file periodically to ensure it's always current
-        static Clock pgnUpdateClock;
-        if (pgnUpdateClock.getElapsedTime().asSeconds() > 5.0f) // Update every 5 seconds
+        // Moving pieces need a new frame until they land
+        if (boardRenderer.advance(frameClock.restart().asSeconds()))
         {
-            updatePgnFile();
-            pgnUpdateClock.restart();
+            requestRedraw();
         }
 
-        window.clear(Color::Black); // Clear with black for letter/pillarboxing
-        // Draw board
-        for (int x = 0; x < BOARD_SIZE; x++)
+        // Keep the overlay's numbers moving a few times a second
+        if (showHud && hudClock.getElapsedTime().asSeconds() > 0.25f)
         {
-            for (int y = 0; y < BOARD_SIZE; y++)
-            {
-                RectangleShape square(Vector2f(SQUARE_SIZE, SQUARE_SIZE));
-                square.setPosition(x * SQUARE_SIZE, y * SQUARE_SIZE);
-
-                // Highlight selected piece
-                if (pieceSelected && x == selectedX && y == selectedY)
-                {
-                    square.setFillColor(Color(247, 247, 105)); // Yellow highlight
-                }
-                else
-                {
-                    square.setFillColor((x + y) % 2 == 0 ? Color(244, 244, 244) : Color(105, 146, 62)); // green + white board
-                }
-                window.draw(square);
-            }
+            hudClock.restart();
+            requestRedraw();
         }
 
-        // Draw waiting message for network games if needed
-        if ((currentMode == GameMode::LANHost || currentMode == GameMode::LANClient) &&
-            (waitingForOpponent || waitingForMove) && !gameOver)
+        if (!redrawNeeded)
         {
-            window.draw(waitingText);
+            // Idle: nothing changed, so don't redraw. SFML 2.5's waitEvent can't time out and
+            // network messages arrive outside the event queue, so sleep briefly and poll again.
+            sf::sleep(sf::milliseconds(IDLE_POLL_MS));
+            continue;
         }
+        redrawNeeded = false;
 
-        // Draw valid move indicators
-        for (const auto &move : validMoves)
         {
-            int x = move.first;
-            int y = move.second;
-            float centerX = x * SQUARE_SIZE + SQUARE_SIZE / 2;
-            float centerY = y * SQUARE_SIZE + SQUARE_SIZE / 2;
+            ScopedTimer timer(FramePhase::Draw);
+            window.clear(Color::Black); // Clear with black for letter/pillarboxing
+            // Board, selection highlight, move indicators and pieces come from cached vertex arrays
+            drawBoard(pieceSelected ? selectedX : -1, pieceSelected ? selectedY : -1, validMoves);
+
+            // Draw waiting message for network games if needed
+            if ((currentMode == GameMode::LANHost || currentMode == GameMode::LANClient) &&
+                (waitingForOpponent || waitingForMove) && !gameOver)
+            {
+                statusLayer.setArea(statusLayer.getArea(), layout.pixelScale);
+                window.draw(statusLayer);
+                FrameProfiler::instance().addDrawCalls(1, 0);
+            }
 
-            if (getPiece(x, y) == 0)
+            if (showExplorer)
             {
-                // Empty square - gray circle
-                moveIndicator.setFillColor(Color(50, 50, 50, 180));
-                moveIndicator.setPosition(centerX, centerY);
-                window.draw(moveIndicator);
+                drawExplorer();
             }
-            else
+            if (showHud)
             {
-                // Opponent's piece - red circle
-                captureIndicator.setPosition(centerX, centerY);
-                window.draw(captureIndicator);
+                drawHud();
             }
         }
-        drawPieces();
-        window.display();
+
+        {
+            ScopedTimer timer(FramePhase::Present);
+            window.display();
+        }
+        FrameProfiler::instance().endFrame();
     }
 }
 
 // Method to update the PGN file with the current game state
 void ChessBoard::updatePgnFile()
 {
-    // Get current date in YYYY.MM.DD format
-    time_t now = time(0);
-    tm *ltm = localtime(&now);
-    string date = to_string(1900 + ltm->tm_year) + "." +
-                  (ltm->tm_mon + 1 < 10 ? "0" : "") + to_string(ltm->tm_mon + 1) + "." +
-                  (ltm->tm_mday < 10 ? "0" : "") + to_string(ltm->tm_mday);
+    ScopedTimer timer(FramePhase::Pgn);
 
-    // Determine the result based on the game state
-    string result = "*";
-    if (!algebraicMoves.empty())
+    // Only what changed since the last call is handed to the writer thread;
+    // nothing here waits for the disk
+    for (; pgnMovesPosted < algebraicMoves.size(); pgnMovesPosted++)
     {
-        if (gameOver)
-        {
-            result = whiteWon ? "1-0" : "0-1";
-        }
+        pgnWriter.addMove(algebraicMoves[pgnMovesPosted]);
     }
 
-    // Create PGN header
-    string pgn = "[Event \"Chess Game\"]\n";
-    pgn += "[Site \"Local Game\"]\n";
-    pgn += "[Date \"" + date + "\"]\n";
-    pgn += "[Round \"1\"]\n";
-    pgn += "[White \"Player 1\"]\n";
-    pgn += "[Black \"Player 2\"]\n";
-    pgn += "[Result \"" + result + "\"]\n\n";
-
-    // Add moves with proper formatting
-    int lineLength = 0;
-    for (size_t i = 0; i < algebraicMoves.size(); i++)
-    {
-        string moveText;
-        if (i % 2 == 0)
-        {
-            moveText = to_string(i / 2 + 1) + ". " + algebraicMoves[i] + " ";
-        }
-        else
-        {
-            moveText = algebraicMoves[i] + " ";
-        }
-
-        // Handle line wrapping for better readability
-        if (lineLength + moveText.length() > 80)
-        {
-            pgn += "\n";
-            lineLength = 0;
-        }
-
-        pgn += moveText;
-        lineLength += moveText.length();
-    }
-
-    // Add result at the end
-    pgn += result;
-
-    // Get current working directory
-    char cwd[1024];
-    if (_getcwd(cwd, sizeof(cwd)) == NULL)
+    // Determine the result based on the game state
+    string result = "*";
+    if (!algebraicMoves.empty() && gameOver)
     {
-        cerr << "Error getting current directory" << endl;
-        return;
+        result = whiteWon ? "1-0" : "0-1";
     }
-
-    // Create the PGN file path
-    string pgnFilePath = string(cwd) + "/temp_game.pgn";
-
-    // Try to open the file with exclusive access
-    ofstream pgnFile(pgnFilePath, ios::out | ios::trunc);
-    if (!pgnFile.is_open())
+    if (result != pgnResult)
     {
-        cerr << "Warning: Could not open PGN file for writing. It may be in use by another process." << endl;
-
-        // Try with a different filename
-        string altPgnFilePath = string(cwd) + "/temp_game_new.pgn";
-        ofstream altPgnFile(altPgnFilePath, ios::out | ios::trunc);
-        if (altPgnFile.is_open())
-        {
-            altPgnFile << pgn;
-            altPgnFile.close();
-            cout << "PGN written to alternate file: " << altPgnFilePath << endl;
-
-            // Try to rename the file
-            if (remove(pgnFilePath.c_str()) == 0)
-            {
-                if (rename(altPgnFilePath.c_str(), pgnFilePath.c_str()) != 0)
-                {
-                    cerr << "Error renaming PGN file" << endl;
-                }
-            }
-        }
-        else
-        {
-            cerr << "Error: Could not open alternate PGN file for writing" << endl;
-        }
-        return;
+        pgnWriter.setResult(result);
+        pgnResult = result;
     }
-
-    // Write the PGN to the file
-    pgnFile << pgn;
-    pgnFile.close();
-    cout << "PGN file updated successfully" << endl;
 }
 
 // New method to calculate sizes and scales
-void ChessBoard::updateBoardAndPieceSizes()
+void ChessBoard::updateLayout()
 {
-    Vector2u windowSize = window.getSize();
-    float minDimension = std::min(windowSize.x, windowSize.y);
-    SQUARE_SIZE = minDimension / static_cast<float>(BOARD_SIZE);
-
-    // Update scales for the template sprites
-    for (int i = 0; i < 6; ++i)
+    // Fit the logical area into the window, keeping its aspect ratio (letter/pillarboxing)
+    layout.windowSize = window.getSize();
+    float windowWidth = static_cast<float>(max(1u, layout.windowSize.x));
+    float windowHeight = static_cast<float>(max(1u, layout.windowSize.y));
+    layout.pixelScale = std::min(windowWidth / WINDOW_WIDTH, windowHeight / WINDOW_HEIGHT);
+    float width = WINDOW_WIDTH * layout.pixelScale;
+    float height = WINDOW_HEIGHT * layout.pixelScale;
+    layout.offset = Vector2f((windowWidth - width) / 2, (windowHeight - height) / 2);
+    layout.viewport = FloatRect(layout.offset.x / windowWidth, layout.offset.y / windowHeight,
+                                width / windowWidth, height / windowHeight);
+    layout.squarePixels = SQUARE_SIZE * layout.pixelScale;
+
+    logicalView.reset(FloatRect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT));
+    logicalView.setViewport(layout.viewport);
+    window.setView(logicalView);
+
+    // Board geometry stays in logical units; only re-pack the atlas when pieces are
+    // shown at a noticeably different size on screen
+    unsigned int cellSize = PieceAtlas::cellSizeFor(layout.squarePixels * PIECE_SCALE * SCALE_FACTOR);
+    if (pieceAtlas.isLoaded() && cellSize != pieceAtlas.getCellSize() && pieceAtlas.build(cellSize))
     {
-        if (blackSprites[i].getTexture())
-        { // Check if texture exists
-            float scale = (SQUARE_SIZE * PIECE_SCALE) / blackSprites[i].getTexture()->getSize().x;
-            blackSprites[i].setScale(scale * SCALE_FACTOR, scale * SCALE_FACTOR);
-        }
-        if (whiteSprites[i].getTexture())
-        { // Check if texture exists
-            float scale = (SQUARE_SIZE * PIECE_SCALE) / whiteSprites[i].getTexture()->getSize().x;
-            whiteSprites[i].setScale(scale * SCALE_FACTOR, scale * SCALE_FACTOR);
-        }
-    }
-
-    // Update scales for the actual sprites on the board
-    for (int x = 0; x < BOARD_SIZE; ++x)
-    {
-        for (int y = 0; y < BOARD_SIZE; ++y)
-        {
-            int pieceValue = getPiece(x, y);
-            if (pieceValue != 0)
-            {
-                int index = -1;
-                bool isWhite = pieceValue > 0;
-                int absValue = abs(pieceValue);
-
-                // Map piece value to sprite index (adjust based on your piece values)
-                switch (absValue)
-                {
-                case 10:
-                    index = 0;
-                    break; // Pawn
-                case 6:
-                    index = 1;
-                    break; // Rook
-                case 8:
-                    index = 2;
-                    break; // Knight (Assuming 8)
-                case 7:
-                    index = 3;
-                    break; // Bishop
-                case 11:
-                    index = 4;
-                    break; // Queen
-                case 9:
-                    index = 5;
-                    break; // King
-                }
-
-                if (index != -1)
-                {
-                    Sprite &targetSprite = isWhite ? whiteSprites[index] : blackSprites[index];
-                    pieceSprites[x][y].setScale(targetSprite.getScale()); // Apply scale from template
-                }
-            }
-        }
+        boardRenderer.setAtlas(&pieceAtlas, PIECE_SCALE * SCALE_FACTOR);
     }
 }
 
 void ChessBoard::resetGame()
 {
+    boardRenderer.finishAnimations();
+
+    // LAN opponents always start from the standard position
+    if (!startFen.empty() && (currentMode == GameMode::LANHost || currentMode == GameMode::LANClient))
+    {
+        cout << "LAN games start from the standard position, --fen is ignored" << endl;
+        startPosition = FenPosition();
+        startFen.clear();
+    }
+
     // Reset board to initial state
     initBoard();
-    initializePieces();
-    updateBoardAndPieceSizes();
+    logic.setPosition(startPosition);
 
     // Reset game state
     gameOver = false;
@@ -1722,9 +1442,15 @@ void ChessBoard::resetGame()
     moveHistory.clear();
     algebraicMoves.clear();
     currentPosition = "";
+    explorerPly = SIZE_MAX; // Same move count, but a new game
 
-    // Always start with white's turn
-    whiteTurn = true;
+    // The PGN file starts over with the new game
+    pgnWriter.newGame(startFen);
+    pgnMovesPosted = 0;
+    pgnResult = "*";
+
+    // White starts unless the start position says otherwise
+    whiteTurn = startPosition.whiteToMove;
 
     // For network games, set waiting state based on player color
     if (currentMode == GameMode::LANHost || currentMode == GameMode::LANClient)
@@ -1735,4 +1461,6 @@ void ChessBoard::resetGame()
 
     // Note: If playing as black against computer, the first move for the computer (white)
     // will be handled in runGame() to ensure the window is fully rendered
+
+    requestRedraw();
 }
\ No newline at end of file
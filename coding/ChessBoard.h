@@ -9,8 +9,21 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <functional>
+#include <chrono>
+#include <future>
 #include "NetworkManager.h"
 #include "GameLogic.h" // Add GameLogic header
+#include "UciInfoParser.h"
+#include "PositionCache.h"
+#include "PieceAtlas.h"
+#include "BoardRenderer.h"
+#include "FrameProfiler.h"
+#include "TextCache.h"
+#include "AssetLoader.h"
+#include "SoundBank.h"
+#include "PgnWriter.h"
+#include "PositionIndex.h"
 
 // Include Windows headers specifically for StockfishEngine class definition
 #ifdef _WIN32
@@ -46,6 +59,43 @@ enum class ComputerDifficulty
     Hard = 20 // Skill Level 20
 };
 
+// One line of engine analysis (MultiPV gives several per position)
+struct EngineLine
+{
+    string move; // First move of the line
+    bool hasScore;
+    bool scoreIsMate;
+    int score; // Centipawns or moves to mate, side to move's point of view
+    int depth;
+    string pv;
+
+    EngineLine() : hasScore(false), scoreIsMate(false), score(0), depth(0) {}
+};
+
+// Evaluation of the position before ply 'ply' of a game (ply 0 is the start position)
+struct PlyEvaluation
+{
+    int ply;
+    bool whiteToMove;
+    string playedMove;        // Move played from this position, empty for the final position
+    vector<EngineLine> lines; // Best line first; empty if the side to move is mated or stalemated
+};
+
+// Watchdog counters for one engine process
+struct EngineHealth
+{
+    int restarts;          // Processes replaced after a crash or hang
+    int timeouts;          // Searches that missed their deadline and were stopped
+    int pings;             // isready round trips
+    double lastPingMs;
+    double maxPingMs;
+    double lastRestartMs;  // Time to bring a replacement process up
+    double totalRestartMs;
+
+    EngineHealth() : restarts(0), timeouts(0), pings(0), lastPingMs(0), maxPingMs(0),
+                     lastRestartMs(0), totalRestartMs(0) {}
+};
+
 class StockfishEngine
 {
 private:
@@ -61,36 +111,108 @@ private:
     bool initialized;
     int skillLevel;
 
+    // Live search info
+    UciLineBuffer outputBuffer;                                        // Engine output waiting to be split into lines
+    vector<pair<int, function<void(const UciInfo &)>>> infoCallbacks; // Subscribers to "info" lines
+    int nextInfoCallbackId;
+    vector<EngineLine> searchLines; // Latest exact score per MultiPV line of the current search
+    bool readyReceived;             // Set when "readyok" arrives
+
+    PositionCache *cache; // Shared results of earlier searches, may be null
+
+    // Watchdog
+    vector<pair<string, string>> options;       // Options set so far, replayed after a restart
+    chrono::steady_clock::time_point lastOutput; // When the engine last said anything
+    EngineHealth health;
+
+    bool ensureResponsive(); // Ping an idle engine and restart it if it is dead or hung
+    bool runSearch(const string &positionCmd, const string &goCmd, int timeoutMs, string &bestMove);
+    bool processOutput(const string &output, string &bestMove); // Dispatch complete lines, true once bestmove arrives
+    bool writeCommand(const string &command);                   // Send without waiting for a reply
+    bool waitForBestMove(int timeoutMs, string &bestMove);
+    bool waitForReady(int timeoutMs);
+    bool waitForToken(const string &token, int timeoutMs, string &response); // Raw output until token, during the handshake
+
 public:
     StockfishEngine();
     ~StockfishEngine();
 
     bool initialize();
     void setDifficulty(int level);
-    string getBestMove(const string &position, int moveTime = 1000);
+    // position is space separated UCI moves from startFen, or from the start position if it is empty
+    string getBestMove(const string &position, int moveTime = 1000, const string &startFen = "");
+
+    // Evaluate every position of a game (given as UCI moves from the start position)
+    // in one engine session at full strength. limitValue is a depth, node count or
+    // time in ms depending on limit. onPosition, if given, is called with the number of
+    // positions done after each one; returning false stops the analysis there.
+    vector<PlyEvaluation> analyzeGame(const vector<string> &moves, SearchLimit limit = SearchLimit::Depth,
+                                      int limitValue = 14, int multiPv = 2,
+                                      const function<bool(size_t)> &onPosition = nullptr);
+
+    // Lower-level analysis session: beginAnalysis, any number of analyzePosition calls
+    // (space separated UCI moves from startFen, or from the start position), then endAnalysis
+    bool beginAnalysis(int multiPv);
+    bool analyzePosition(const string &moves, SearchLimit limit, int limitValue, vector<EngineLine> &lines,
+                         const string &startFen = "");
+    void endAnalysis();
+    void setOption(const string &name, const string &value);
+
+    // Watchdog: liveness checks, isready round trip and process restart
+    bool isAlive() const;
+    bool ping(int timeoutMs = 2000);
+    bool restart();
+    const EngineHealth &getHealth() const { return health; }
+
     string sendCommand(const string &command);
     void close();
     bool isInitialized() const { return initialized; }
+
+    // Subscribe to search updates while getBestMove runs; returns an id for removeInfoCallback
+    int addInfoCallback(function<void(const UciInfo &)> callback);
+    void removeInfoCallback(int id);
+
+    void setCache(PositionCache *positionCache) { cache = positionCache; }
+};
+
+// Where the logical scene lands in the window, recomputed once per resize.
+// Everything is drawn in a fixed WINDOW_WIDTH x WINDOW_HEIGHT logical space
+// through one sf::View; a resize only changes that view's viewport.
+struct WindowLayout
+{
+    Vector2u windowSize; // Pixels
+    FloatRect viewport;  // Letterboxed logical area, as a fraction of the window
+    Vector2f offset;     // Top-left of the logical area in window pixels
+    float pixelScale;    // Window pixels per logical unit, also the text raster scale
+    float squarePixels;  // On-screen size of a board square, for the atlas resolution
 };
 
+class GameAnalyzer; // GameAnalyzer.h includes this header
+
 class ChessBoard
 {
 private:
+    AssetLoader assets; // Decodes images and the font off the main thread at startup
     RenderWindow window;
     vector<vector<int>> board;
-    GameLogic logic; // Add GameLogic member
-    Texture blackpieces[6];
-    Texture whitepieces[6];
-    Sprite blackSprites[6];
-    Sprite whiteSprites[6];
-    vector<vector<Sprite>> pieceSprites; // 2D array for piece sprites
+    GameLogic logic; // Rules state of the running game; every move, whoever makes it, goes through it
+    PieceAtlas pieceAtlas;       // All twelve piece images in one texture
+    BoardRenderer boardRenderer; // Cached squares, highlight, move indicators and pieces
+    SoundBank sounds;            // Move, capture, check ... effects, decoded at startup
     Texture menuTexture;
     Sprite menuSprite;
+    vector<char> fontData; // Font::loadFromMemory reads from this for as long as the font lives
     Font font;
-    float SQUARE_SIZE; // Make SQUARE_SIZE a member variable
+    TextCache menuLayer;   // Menu and game over screens, drawn as one sprite
+    TextCache statusLayer; // Status line over the board
+    float SQUARE_SIZE; // Logical square size, fixed; the view scales it to the window
+    WindowLayout layout;
+    View logicalView;
     bool gameOver;     // Flag to indicate if game is over
     bool whiteWon;     // Flag to indicate if white won
     bool whiteTurn;    // Added whiteTurn variable to track turns
+    FenPosition startPosition; // Where every game starts: the standard start unless set with --fen
+    string startFen;           // startPosition as FEN for the engine and the PGN, empty for the standard start
 
     // Stockfish integration
     GameMode currentMode;
@@ -100,6 +222,13 @@ private:
     string currentPosition;
     vector<string> moveHistory;    // For UCI format moves
     vector<string> algebraicMoves; // For algebraic notation moves (PGN format)
+    UciInfo engineInfo;            // Latest search info from the engine (pv is not kept here)
+    string enginePv;               // Principal variation that came with engineInfo
+    PositionCache positionCache;   // Engine results shared across searches and games
+    future<bool> engineStartup;    // Valid while Stockfish starts in the background
+    chrono::steady_clock::time_point modeChosen; // For the startup timing report
+    shared_ptr<GameAnalyzer> gameAnalyzer;        // Analysis of the finished game, shared with its thread
+    future<bool> gameAnalysis;                   // Valid while that analysis runs or waits to be written
 
     // Network game variables
     unique_ptr<NetworkManager> network;
@@ -109,6 +238,33 @@ private:
     bool opponentConnected;
     bool waitingForMove;
 
+    // PGN of the running game, kept on disk by a background thread
+    PgnWriter pgnWriter;
+    size_t pgnMovesPosted; // algebraicMoves already handed to the writer
+    string pgnResult;      // Result last handed to the writer
+
+    // Frame scheduling: runGame only redraws after something changed
+    bool redrawNeeded;
+    void requestRedraw() { redrawNeeded = true; }
+
+    // Frame timing overlay, toggled with F3
+    bool showHud;
+    Text hudText;
+    RectangleShape hudBackground;
+    Clock hudClock; // Paces HUD refreshes while nothing else changes
+    void drawHud();
+
+    // Opening explorer, toggled with F4: how the games of a position index went on
+    // from the current position. The lookup runs once per position, not per frame
+    PositionIndex positionIndex;
+    bool showExplorer;
+    bool explorerOpened; // The index file has been looked for
+    size_t explorerPly;  // moveHistory size the panel was filled for, SIZE_MAX to refill
+    Text explorerText;
+    RectangleShape explorerBackground;
+    void updateExplorer();
+    void drawExplorer();
+
     // For menu
     float centerX;
     float centerY;
@@ -130,11 +286,17 @@ private:
     bool showNetworkOptions(bool isHost);
     bool showGameOverWindow(bool whiteWinner); // Method to show game over window
     void runGame();
-    void updateBoardAndPieceSizes(); // Declaration for the new function
-    void makeComputerMove();
-    string boardToFen() const;
+    void updateLayout(); // After a resize: view, viewport and atlas resolution
+    bool makeComputerMove(); // False if no move was played, e.g. Stockfish could not be started
+    void startEngine();   // Start Stockfish on a background thread
+    bool waitForEngine(); // Finish the startup if needed; false if there is no usable engine
+    string boardToFen() const; // The piece placement field of the current board
     string moveToUci(int fromX, int fromY, int toX, int toY) const;
     void applyUciMove(const string &uciMove);
+    void onEngineInfo(const UciInfo &info);
+    bool startGameAnalysis();    // On worker threads; false if there are no moves to analyse
+    string writeGameAnalysis();  // Once it is done: the viewer's report, empty if it is incomplete
+    void cancelGameAnalysis();   // Stop after the searches under way and wait for them
     void resetGame();
 
     // Network methods
@@ -150,17 +312,29 @@ private:
 
 public:
     ChessBoard();
-    vector<vector<Sprite>> &getPieceSprites() { return pieceSprites; }
     vector<vector<int>> &getMatrix();
     void setPiece(int x, int y, int value);
     void initBoard();
     int getPiece(int x, int y) const;
     bool loadTexture();
-    void initializePieces();
-    void drawPieces();
-    void drawPiece(Sprite sprite, int x, int y);
+    void playMoveAnimations(); // Draw frames until every moving piece has landed
+    void drawBoard(int selectedX = -1, int selectedY = -1,
+                   const vector<pair<int, int>> &validMoves = vector<pair<int, int>>());
     void run();
+
+    // Start games from a FEN position instead of the standard start (not for LAN
+    // games); false, with the reason on cerr, if the FEN is malformed
+    bool setStartFen(const string &fen);
+
     void addAlgebraicMove(const string &move) { algebraicMoves.push_back(move); }
+
+    // Called by GameLogic just before a piece moves on the board
+    void animateMove(int fromX, int fromY, int toX, int toY, int capturedX = -1, int capturedY = -1)
+    {
+        boardRenderer.animateMove(board, fromX, fromY, toX, toY, capturedX, capturedY);
+        requestRedraw();
+    }
+    void playSound(SoundEffect effect) { sounds.play(effect); }
 };
 
 #endif // CHESSBOARD_H
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "ChessBoard.h"
 #include "GameLogic.h"
+#include "GameAnalyzer.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
@@ -23,6 +24,12 @@ string ChessBoard::moveToUci(int fromX, int fromY, int toX, int toY) const
     uciMove += toFile;
     uciMove += toRank;
 
+    // Pawns reaching the last rank always become queens on this board
+    if (abs(getPiece(fromX, fromY)) == 10 && (toY == 0 || toY == BOARD_SIZE - 1))
+    {
+        uciMove += 'q';
+    }
+
     return uciMove;
 }
 
@@ -45,9 +52,26 @@ void ChessBoard::applyUciMove(const string &uciMove)
         return;
     }
 
-    // Execute the move
-    GameLogic logic(board, *this);
-    logic.movePiece(fromX, fromY, toX, toY);
+    // The engine may underpromote; the board queens unless told otherwise
+    int promotion = 11;
+    if (uciMove.length() > 4)
+    {
+        switch (uciMove[4])
+        {
+        case 'r':
+            promotion = 6;
+            break;
+        case 'b':
+            promotion = 7;
+            break;
+        case 'n':
+            promotion = 8;
+            break;
+        }
+    }
+
+    // Execute the move on the game's own logic, which knows about castling rights and en passant
+    logic.movePiece(fromX, fromY, toX, toY, promotion);
 
     // Update PGN file after computer move
     updatePgnFile();
@@ -62,12 +86,69 @@ void ChessBoard::applyUciMove(const string &uciMove)
     moveHistory.push_back(uciMove);
 }
 
-void ChessBoard::makeComputerMove()
+void ChessBoard::onEngineInfo(const UciInfo &info)
 {
-    if (!engine || !engine->isInitialized() || gameOver)
+    // Only track the main line when the engine reports several
+    if (info.multiPv != 1)
         return;
 
+    engineInfo = info;
+    enginePv = info.pvString();
+    engineInfo.pv = nullptr; // Points into the engine's buffer, only valid during the callback
+    engineInfo.pvLength = 0;
+}
+
+void ChessBoard::startEngine()
+{
+    if (engine)
+        return; // Already started
+
+    // The UCI handshake and reading the cache file need neither the window nor the
+    // board, so they run on their own thread while the menus and the board come up
+    engine = make_unique<StockfishEngine>();
+    StockfishEngine *starting = engine.get();
+    auto start = [this, starting]()
+    {
+        if (!starting->initialize())
+            return false;
+        positionCache.loadFromFile("engine_cache.bin");
+        return true;
+    };
+    engineStartup = async(launch::async, start);
+}
+
+bool ChessBoard::waitForEngine()
+{
+    if (engineStartup.valid())
+    {
+        if (engineStartup.get())
+        {
+            engine->setDifficulty(static_cast<int>(computerDifficulty));
+            engine->addInfoCallback([this](const UciInfo &info)
+                                    { onEngineInfo(info); });
+            engine->setCache(&positionCache);
+        }
+        else
+        {
+            cout << "Failed to initialize Stockfish engine. Reverting to two-player mode." << endl;
+            engine.reset();
+            currentMode = GameMode::TwoPlayer;
+        }
+    }
+    return engine && engine->isInitialized();
+}
+
+bool ChessBoard::makeComputerMove()
+{
+    if (gameOver)
+        return false;
+
+    ScopedTimer timer(FramePhase::Engine);
+    if (!waitForEngine())
+        return false; // The game carries on as a two-player game, with the same side to move
+
     cout << "Computer is thinking..." << endl;
+    engineInfo.clear();
 
     // Calculate difficulty-based move time (in milliseconds)
     int moveTime = 100; // Default 100ms
@@ -91,91 +172,88 @@ void ChessBoard::makeComputerMove()
     }
 
     // Get best move from Stockfish
-    string bestMove = engine->getBestMove(currentPosition, moveTime);
+    string bestMove = engine->getBestMove(currentPosition, moveTime, startFen);
 
     if (bestMove.empty())
     {
         cout << "Engine failed to find a move!" << endl;
-        return;
+        return false;
     }
 
     cout << "Computer plays: " << bestMove << endl;
 
     // Apply the move
     applyUciMove(bestMove);
+    return true;
 }
 
-string ChessBoard::boardToFen() const
+bool ChessBoard::startGameAnalysis()
 {
-    stringstream fen;
+    if (moveHistory.empty())
+        return false;
 
-    // Board position
-    for (int y = 0; y < 8; ++y)
-    {
-        int emptyCount = 0;
+    // Spread the positions over one engine per core instead of the single game engine,
+    // away from the window thread so the game over screen keeps running
+    gameAnalyzer = make_shared<GameAnalyzer>();
+    gameAnalyzer->addGame(moveHistory, startFen);
+    shared_ptr<GameAnalyzer> analyzer = gameAnalyzer;
+    gameAnalysis = async(launch::async, [analyzer]()
+                         { return analyzer->run(SearchLimit::Depth, 14, 2); });
+    return true;
+}
 
-        for (int x = 0; x < 8; ++x)
-        {
-            int piece = board[x][y];
-
-            if (piece == 0)
-            {
-                emptyCount++;
-            }
-            else
-            {
-                if (emptyCount > 0)
-                {
-                    fen << emptyCount;
-                    emptyCount = 0;
-                }
-
-                char pieceLetter;
-
-                switch (abs(piece))
-                {
-                case 6:
-                    pieceLetter = 'r';
-                    break; // Rook
-                case 7:
-                    pieceLetter = 'b';
-                    break; // Bishop
-                case 8:
-                    pieceLetter = 'n';
-                    break; // Knight
-                case 9:
-                    pieceLetter = 'k';
-                    break; // King
-                case 10:
-                    pieceLetter = 'p';
-                    break; // Pawn
-                case 11:
-                    pieceLetter = 'q';
-                    break; // Queen
-                default:
-                    pieceLetter = '?';
-                    break; // Unknown
-                }
-
-                if (piece > 0)
-                { // White piece
-                    pieceLetter = toupper(pieceLetter);
-                }
-
-                fen << pieceLetter;
-            }
-        }
+string ChessBoard::writeGameAnalysis()
+{
+    bool complete = gameAnalysis.get();
+    const vector<PlyEvaluation> &evaluations = gameAnalyzer->getResults()[0];
 
-        if (emptyCount > 0)
-        {
-            fen << emptyCount;
-        }
+    ofstream report("temp_game_analysis.txt", ios::out | ios::trunc);
+    if (report.is_open())
+    {
+        GameAnalyzer::writeReport(report, evaluations);
+    }
+    else
+    {
+        cerr << "Could not write analysis report" << endl;
+    }
 
-        if (y < 7)
+    // The viewer takes the evaluations instead of running its own engine, but only a
+    // whole game's worth; otherwise it analyses the game itself
+    string viewerPath;
+    char cwd[1024];
+    if (_getcwd(cwd, sizeof(cwd)) != NULL)
+    {
+        viewerPath = string(cwd) + "/temp_game_analysis.json";
+    }
+    if (!complete)
+    {
+        cout << "Analysis incomplete, the analyzer will evaluate the game itself" << endl;
+        viewerPath.clear();
+    }
+    if (!viewerPath.empty())
+    {
+        ofstream viewerReport(viewerPath, ios::out | ios::trunc);
+        GameAnalyzer::writeViewerJson(viewerReport, evaluations);
+        if (!viewerReport)
         {
-            fen << '/';
+            cerr << "Could not write " << viewerPath << endl;
+            viewerPath.clear();
         }
     }
+    gameAnalyzer.reset();
+    return viewerPath;
+}
 
-    return fen.str();
-}
\ No newline at end of file
+void ChessBoard::cancelGameAnalysis()
+{
+    if (!gameAnalysis.valid())
+        return;
+    gameAnalyzer->cancel();
+    gameAnalysis.get();
+    gameAnalyzer.reset();
+}
+
+string ChessBoard::boardToFen() const
+{
+    return Fen::writePlacement(board);
+}
@@ -13,12 +13,7 @@ using namespace sf;
 
 bool ChessBoard::showNetworkOptions(bool isHost)
 {
-    // Get the same scaling factors as used in the main menu
-    float scaleX = static_cast<float>(WINDOW_WIDTH) / menuTexture.getSize().x;
-    float scaleY = static_cast<float>(WINDOW_HEIGHT) / menuTexture.getSize().y;
-    menuSprite.setScale(scaleX, scaleY);
-
-    // Calculate scalable positions based on window dimensions
+    // Positions are in the logical space; the view scales them to the window
     float centerX = WINDOW_WIDTH / 2.0f;
     float centerY = WINDOW_HEIGHT / 2.0f;
     float buttonWidth = WINDOW_WIDTH * 0.3f;
@@ -141,6 +136,11 @@ bool ChessBoard::showNetworkOptions(bool isHost)
                 return false;
             }
 
+            if (event.type == Event::Resized)
+            {
+                updateLayout();
+            }
+
             // Handle text input
             if (event.type == Event::TextEntered)
             {
@@ -176,10 +176,10 @@ bool ChessBoard::showNetworkOptions(bool isHost)
 
             if (event.type == Event::MouseButtonPressed)
             {
-                Vector2i mousePos = Mouse::getPosition(window);
+                Vector2f mousePos = window.mapPixelToCoords(Vector2i(event.mouseButton.x, event.mouseButton.y));
 
                 // Check if IP address box is clicked
-                if (ipAddressBox.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                if (ipAddressBox.getGlobalBounds().contains(mousePos))
                 {
                     ipAddressFocused = true;
                     portFocused = false;
@@ -187,7 +187,7 @@ bool ChessBoard::showNetworkOptions(bool isHost)
                     cursorVisible = true;
                 }
                 // Check if port box is clicked
-                else if (portBox.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                else if (portBox.getGlobalBounds().contains(mousePos))
                 {
                     ipAddressFocused = false;
                     portFocused = true;
@@ -195,7 +195,7 @@ bool ChessBoard::showNetworkOptions(bool isHost)
                     cursorVisible = true;
                 }
                 // Check if start button is clicked
-                else if (startButton.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                else if (startButton.getGlobalBounds().contains(mousePos))
                 {
                     // Try to parse port
                     try
@@ -264,7 +264,7 @@ bool ChessBoard::showNetworkOptions(bool isHost)
                     }
                 }
                 // Check if back button is clicked
-                else if (backButton.getGlobalBounds().contains(mousePos.x, mousePos.y))
+                else if (backButton.getGlobalBounds().contains(mousePos))
                 {
                     return false;
                 }
@@ -297,9 +297,9 @@ bool ChessBoard::showNetworkOptions(bool isHost)
         }
 
         // Highlight buttons on hover
-        Vector2i mousePos = Mouse::getPosition(window);
-        startButton.setFillColor(startButton.getGlobalBounds().contains(mousePos.x, mousePos.y) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
-        backButton.setFillColor(backButton.getGlobalBounds().contains(mousePos.x, mousePos.y) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
+        Vector2f mousePos = window.mapPixelToCoords(Mouse::getPosition(window));
+        startButton.setFillColor(startButton.getGlobalBounds().contains(mousePos) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
+        backButton.setFillColor(backButton.getGlobalBounds().contains(mousePos) ? Color(70, 70, 70, 220) : Color(50, 50, 50, 200));
 
         // Highlight focused input box
         ipAddressBox.setOutlineColor(ipAddressFocused ? Color::Yellow : Color::White);
@@ -417,6 +417,7 @@ void ChessBoard::handleNetworkMessages()
             {
                 NetworkMessage message = network->getNextMessage();
                 onNetworkMessage(message);
+                requestRedraw(); // Moves and connection changes are visible on the board
             }
             catch (const exception &e)
             {
@@ -469,9 +470,6 @@ void ChessBoard::processNetworkMove(const string &moveData)
             return;
         }
 
-        // Apply move
-        GameLogic logic(getMatrix(), *this);
-
         // Check if the move is valid
         if (!logic.isValidMove(fromX, fromY, toX, toY))
         {
@@ -479,7 +477,9 @@ void ChessBoard::processNetworkMove(const string &moveData)
             return;
         }
 
+        string uciMove = moveToUci(fromX, fromY, toX, toY); // While the moving piece is still on its square
         logic.movePiece(fromX, fromY, toX, toY);
+        moveHistory.push_back(uciMove);
 
         // Update PGN file after network move
         updatePgnFile();
@@ -569,6 +569,7 @@ void ChessBoard::onNetworkMessage(const NetworkMessage &message)
             cout << "Game over: " << message.data << endl;
             gameOver = true;
             whiteWon = message.data == "white";
+            updatePgnFile(); // Record the result the opponent announced
             break;
 
         case MessageType::Error:
@@ -0,0 +1,331 @@
+#include "Fen.h"
+#include "Zobrist.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+const char *Fen::START = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+static const char PIECE_LETTERS[] = "rbnkpq"; // Piece values 6 to 11
+
+FenPosition::FenPosition()
+    : whiteToMove(true), castlingRights(Zobrist::AllCastling), enPassantCol(-1),
+      halfmoveClock(0), fullmoveNumber(1)
+{
+    Zobrist::setStartPosition(board);
+}
+
+const string *EpdRecord::operation(const char *opcode) const
+{
+    for (const auto &op : operations)
+    {
+        if (op.first == opcode)
+            return &op.second;
+    }
+    return nullptr;
+}
+
+bool Fen::parsePlacement(const string &placement, vector<vector<int>> &board)
+{
+    board.assign(8, vector<int>(8, 0));
+
+    int x = 0, y = 0;
+    for (char c : placement)
+    {
+        if (c == ' ')
+            break; // End of the placement field
+        if (c == '/')
+        {
+            if (x != 8)
+                return false;
+            x = 0;
+            y++;
+            continue;
+        }
+        if (y > 7)
+            return false;
+        if (c >= '1' && c <= '8')
+        {
+            x += c - '0';
+            if (x > 8)
+                return false;
+            continue;
+        }
+
+        const char *letter = strchr(PIECE_LETTERS, tolower(static_cast<unsigned char>(c)));
+        if (!letter || !*letter || x > 7)
+            return false;
+        int piece = 6 + static_cast<int>(letter - PIECE_LETTERS);
+        board[x][y] = isupper(static_cast<unsigned char>(c)) ? piece : -piece; // White pieces are positive
+        x++;
+    }
+
+    return y == 7 && x == 8;
+}
+
+string Fen::writePlacement(const vector<vector<int>> &board)
+{
+    string placement;
+    for (int y = 0; y < 8; y++)
+    {
+        int emptyCount = 0;
+        for (int x = 0; x < 8; x++)
+        {
+            int piece = board[x][y];
+            if (piece == 0)
+            {
+                emptyCount++;
+                continue;
+            }
+            if (emptyCount > 0)
+            {
+                placement += static_cast<char>('0' + emptyCount);
+                emptyCount = 0;
+            }
+            int type = abs(piece) - 6;
+            char letter = type >= 0 && type < 6 ? PIECE_LETTERS[type] : '?';
+            placement += piece > 0 ? static_cast<char>(toupper(letter)) : letter;
+        }
+        if (emptyCount > 0)
+            placement += static_cast<char>('0' + emptyCount);
+        if (y < 7)
+            placement += '/';
+    }
+    return placement;
+}
+
+// Helper function to read a move clock field; false unless it is a whole non-negative number
+static bool readClock(const string &field, int &value)
+{
+    if (field.empty() || field.size() > 6 || field.find_first_not_of("0123456789") != string::npos)
+        return false;
+    value = atoi(field.c_str());
+    return true;
+}
+
+// Helper function to read the four position fields every FEN and EPD line starts with
+static bool parsePositionFields(istringstream &fields, FenPosition &position, string &error)
+{
+    string placement, side, castling, enPassant;
+    if (!(fields >> placement >> side >> castling >> enPassant))
+    {
+        error = "fewer than four fields";
+        return false;
+    }
+
+    if (!Fen::parsePlacement(placement, position.board))
+    {
+        error = "bad piece placement '" + placement + "'";
+        return false;
+    }
+    int kings[2] = {0, 0};
+    for (int x = 0; x < 8; x++)
+    {
+        for (int y = 0; y < 8; y++)
+        {
+            int piece = position.board[x][y];
+            if (abs(piece) == 9)
+                kings[piece > 0]++;
+            if (abs(piece) == 10 && (y == 0 || y == 7))
+            {
+                error = "pawn on the first or last rank";
+                return false;
+            }
+        }
+    }
+    if (kings[0] != 1 || kings[1] != 1)
+    {
+        error = "each side needs exactly one king";
+        return false;
+    }
+
+    if (side != "w" && side != "b")
+    {
+        error = "side to move must be w or b";
+        return false;
+    }
+    position.whiteToMove = side == "w";
+
+    position.castlingRights = 0;
+    if (castling != "-")
+    {
+        for (char c : castling)
+        {
+            const char *letters = "KQkq";
+            const char *letter = strchr(letters, c);
+            if (!letter || !*letter)
+            {
+                error = "bad castling rights '" + castling + "'";
+                return false;
+            }
+            position.castlingRights |= 1 << (letter - letters); // Same order as the Zobrist bits
+        }
+    }
+
+    // A right needs its king and rook at home; anything else could not castle anyway
+    const vector<vector<int>> &board = position.board;
+    if (board[4][7] != 9)
+        position.castlingRights &= ~(Zobrist::WhiteKingside | Zobrist::WhiteQueenside);
+    if (board[7][7] != 6)
+        position.castlingRights &= ~Zobrist::WhiteKingside;
+    if (board[0][7] != 6)
+        position.castlingRights &= ~Zobrist::WhiteQueenside;
+    if (board[4][0] != -9)
+        position.castlingRights &= ~(Zobrist::BlackKingside | Zobrist::BlackQueenside);
+    if (board[7][0] != -6)
+        position.castlingRights &= ~Zobrist::BlackKingside;
+    if (board[0][0] != -6)
+        position.castlingRights &= ~Zobrist::BlackQueenside;
+
+    position.enPassantCol = -1;
+    if (enPassant != "-")
+    {
+        // The square behind a pawn of the side that just moved: rank 6 if White is to move
+        char rank = position.whiteToMove ? '6' : '3';
+        if (enPassant.size() != 2 || enPassant[0] < 'a' || enPassant[0] > 'h' || enPassant[1] != rank)
+        {
+            error = "bad en passant square '" + enPassant + "'";
+            return false;
+        }
+        position.enPassantCol = enPassant[0] - 'a';
+    }
+
+    position.halfmoveClock = 0;
+    position.fullmoveNumber = 1;
+    return true;
+}
+
+bool Fen::parse(const string &fen, FenPosition &position, string &error)
+{
+    istringstream fields(fen);
+    if (!parsePositionFields(fields, position, error))
+        return false;
+
+    string halfmove, fullmove, extra;
+    if (fields >> halfmove && !readClock(halfmove, position.halfmoveClock))
+    {
+        error = "bad halfmove clock '" + halfmove + "'";
+        return false;
+    }
+    if (fields >> fullmove && (!readClock(fullmove, position.fullmoveNumber) || position.fullmoveNumber == 0))
+    {
+        error = "bad fullmove number '" + fullmove + "'";
+        return false;
+    }
+    if (fields >> extra)
+    {
+        error = "unexpected text after the move clocks";
+        return false;
+    }
+    return true;
+}
+
+string Fen::write(const FenPosition &position)
+{
+    string fen = writePlacement(position.board);
+    fen += position.whiteToMove ? " w " : " b ";
+
+    string castling;
+    const char *letters = "KQkq";
+    for (int i = 0; i < 4; i++)
+    {
+        if (position.castlingRights & (1 << i))
+            castling += letters[i];
+    }
+    fen += castling.empty() ? "-" : castling;
+
+    if (position.enPassantCol >= 0 && position.enPassantCol < 8)
+    {
+        fen += ' ';
+        fen += static_cast<char>('a' + position.enPassantCol);
+        fen += position.whiteToMove ? '6' : '3';
+    }
+    else
+        fen += " -";
+
+    fen += " " + to_string(position.halfmoveClock) + " " + to_string(position.fullmoveNumber);
+    return fen;
+}
+
+bool Fen::parseEpd(const string &line, EpdRecord &record, string &error)
+{
+    istringstream fields(line);
+    if (!parsePositionFields(fields, record.position, error))
+        return false;
+
+    // Operations: an opcode, then its operand up to a semicolon outside quotes
+    record.operations.clear();
+    string rest = fields.eof() ? "" : line.substr(static_cast<size_t>(fields.tellg()));
+    size_t i = 0;
+    while (i < rest.size())
+    {
+        while (i < rest.size() && isspace(static_cast<unsigned char>(rest[i])))
+            i++;
+        if (i == rest.size())
+            break;
+
+        size_t opcodeStart = i;
+        while (i < rest.size() && !isspace(static_cast<unsigned char>(rest[i])) && rest[i] != ';')
+            i++;
+        string opcode = rest.substr(opcodeStart, i - opcodeStart);
+
+        string operand;
+        bool quoted = false;
+        for (; i < rest.size() && (quoted || rest[i] != ';'); i++)
+        {
+            if (rest[i] == '"')
+                quoted = !quoted;
+            operand += rest[i];
+        }
+        i++; // The semicolon; some suites leave out the last one
+
+        size_t first = operand.find_first_not_of(" \t");
+        size_t last = operand.find_last_not_of(" \t\r");
+        operand = first == string::npos ? "" : operand.substr(first, last - first + 1);
+        if (operand.size() >= 2 && operand.front() == '"' && operand.back() == '"')
+            operand = operand.substr(1, operand.size() - 2);
+        record.operations.emplace_back(opcode, operand);
+    }
+
+    const string *clock = record.operation("hmvc");
+    if (clock && !readClock(*clock, record.position.halfmoveClock))
+    {
+        error = "bad hmvc operand '" + *clock + "'";
+        return false;
+    }
+    clock = record.operation("fmvn");
+    if (clock && (!readClock(*clock, record.position.fullmoveNumber) || record.position.fullmoveNumber == 0))
+    {
+        error = "bad fmvn operand '" + *clock + "'";
+        return false;
+    }
+    return true;
+}
+
+bool Fen::readEpdFile(const string &path, vector<EpdRecord> &records)
+{
+    ifstream in(path);
+    if (!in.is_open())
+    {
+        cerr << "Could not open EPD file: " << path << endl;
+        return false;
+    }
+
+    string line, error;
+    EpdRecord record;
+    for (size_t number = 1; getline(in, line); number++)
+    {
+        if (line.find_first_not_of(" \t\r") == string::npos || line[0] == '#')
+            continue;
+        if (parseEpd(line, record, error))
+            records.push_back(record);
+        else
+            cerr << path << " line " << number << ": " << error << ", skipped" << endl;
+    }
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef FEN_H
+#define FEN_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace std;
+
+// A position as FEN describes it, in the board[x][y] layout (y = 0 is the 8th rank,
+// positive values are white pieces)
+struct FenPosition
+{
+    vector<vector<int>> board;
+    bool whiteToMove;
+    int castlingRights; // Zobrist castling bits
+    int enPassantCol;   // File of the square a pawn just passed over moving two, -1 if none
+    int halfmoveClock;  // Plies since the last capture or pawn move
+    int fullmoveNumber; // Starts at 1 and goes up after each Black move
+
+    FenPosition(); // The standard start position
+};
+
+// One line of an EPD test suite: the first four FEN fields, then operations such as
+// bm (best moves), am (avoid moves), id and c0 ... c9
+struct EpdRecord
+{
+    FenPosition position;
+    vector<pair<string, string>> operations; // Opcode and operand; quoted operands without their quotes
+
+    const string *operation(const char *opcode) const; // Null if the record has no such operation
+};
+
+class Fen
+{
+public:
+    static const char *START; // The standard start position
+
+    // A whole FEN; the two move clocks may be left out. False, with the reason in
+    // error, if it is malformed. Castling rights whose king or rook is not on its
+    // home square are dropped
+    static bool parse(const string &fen, FenPosition &position, string &error);
+    static string write(const FenPosition &position);
+
+    // The piece placement field alone; parsing stops at the first space
+    static bool parsePlacement(const string &placement, vector<vector<int>> &board);
+    static string writePlacement(const vector<vector<int>> &board);
+
+    // An EPD line; the hmvc and fmvn operations set the clocks
+    static bool parseEpd(const string &line, EpdRecord &record, string &error);
+
+    // Every record of an EPD file; malformed lines are reported and skipped.
+    // False if the file could not be read
+    static bool readEpdFile(const string &path, vector<EpdRecord> &records);
+};
+
+#endif // FEN_H
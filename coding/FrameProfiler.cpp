@@ -0,0 +1,159 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+
+FrameProfiler::FrameProfiler()
+    : historyCount(0), historyNext(0), activePhase(-1), drawCalls(0), vertices(0),
+      lastDrawCalls(0), lastVertices(0), framesThisSecond(0), framesPerSecond(0),
+      secondStart(chrono::steady_clock::now())
+{
+    for (int i = 0; i < PHASES; i++)
+    {
+        current[i] = 0;
+    }
+    for (int i = 0; i <= PHASES; i++)
+    {
+        for (int j = 0; j < HISTORY; j++)
+        {
+            history[i][j] = 0;
+        }
+    }
+}
+
+FrameProfiler &FrameProfiler::instance()
+{
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+void FrameProfiler::chargeActive(chrono::steady_clock::time_point now)
+{
+    if (activePhase >= 0)
+    {
+        current[activePhase] += chrono::duration<double, milli>(now - activeSince).count();
+    }
+    activeSince = now;
+}
+
+int FrameProfiler::enter(FramePhase phase)
+{
+    chargeActive(chrono::steady_clock::now());
+    int previous = activePhase;
+    activePhase = static_cast<int>(phase);
+    return previous;
+}
+
+void FrameProfiler::leave(int previousPhase)
+{
+    chargeActive(chrono::steady_clock::now());
+    activePhase = previousPhase;
+}
+
+void FrameProfiler::addDrawCalls(size_t calls, size_t vertexCount)
+{
+    drawCalls += calls;
+    vertices += vertexCount;
+}
+
+void FrameProfiler::endFrame()
+{
+    chargeActive(chrono::steady_clock::now());
+
+    double total = 0;
+    for (int i = 0; i < PHASES; i++)
+    {
+        history[i][historyNext] = current[i];
+        total += current[i];
+        current[i] = 0;
+    }
+    history[PHASES][historyNext] = total;
+    historyNext = (historyNext + 1) % HISTORY;
+    historyCount = min(historyCount + 1, static_cast<int>(HISTORY));
+
+    lastDrawCalls = drawCalls;
+    lastVertices = vertices;
+    drawCalls = 0;
+    vertices = 0;
+
+    framesThisSecond++;
+    auto now = chrono::steady_clock::now();
+    if (now - secondStart >= chrono::seconds(1))
+    {
+        framesPerSecond = framesThisSecond;
+        framesThisSecond = 0;
+        secondStart = now;
+    }
+}
+
+double FrameProfiler::getLast(FramePhase phase) const
+{
+    if (historyCount == 0)
+        return 0;
+    return history[static_cast<int>(phase)][(historyNext + HISTORY - 1) % HISTORY];
+}
+
+double FrameProfiler::percentileOf(const double *values, int count, double percent)
+{
+    if (count == 0)
+        return 0;
+
+    // Select on a copy so the history keeps its order
+    double sorted[HISTORY];
+    count = min(count, static_cast<int>(HISTORY));
+    copy(values, values + count, sorted);
+    int index = min(count - 1, static_cast<int>(percent / 100.0 * count));
+    nth_element(sorted, sorted + index, sorted + count);
+    return sorted[index];
+}
+
+double FrameProfiler::getPercentile(FramePhase phase, double percent) const
+{
+    return percentileOf(history[static_cast<int>(phase)], historyCount, percent);
+}
+
+double FrameProfiler::getFrameTimePercentile(double percent) const
+{
+    return percentileOf(history[PHASES], historyCount, percent);
+}
+
+const char *FrameProfiler::phaseName(FramePhase phase)
+{
+    switch (phase)
+    {
+    case FramePhase::Events:
+        return "events";
+    case FramePhase::Logic:
+        return "logic";
+    case FramePhase::Network:
+        return "network";
+    case FramePhase::Engine:
+        return "engine";
+    case FramePhase::Pgn:
+        return "pgn";
+    case FramePhase::Draw:
+        return "draw";
+    case FramePhase::Present:
+        return "present";
+    default:
+        return "?";
+    }
+}
+
+string FrameProfiler::report() const
+{
+    stringstream ss;
+    ss << fixed << setprecision(2);
+    ss << "frame " << getFrameTimePercentile(50) << " ms  p95 " << getFrameTimePercentile(95)
+       << "  p99 " << getFrameTimePercentile(99) << "  " << framesPerSecond << " fps\n";
+    ss << "draw calls " << lastDrawCalls << "  vertices " << lastVertices << "\n";
+    for (int i = 0; i < PHASES; i++)
+    {
+        FramePhase phase = static_cast<FramePhase>(i);
+        ss << setw(8) << left << phaseName(phase) << right << setw(8) << getLast(phase)
+           << "  p95 " << setw(8) << getPercentile(phase, 95) << "\n";
+    }
+    return ss.str();
+}
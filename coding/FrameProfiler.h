@@ -0,0 +1,92 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <chrono>
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// Parts of a frame that CPU time is charged to
+enum class FramePhase
+{
+    Events,  // Window event handling
+    Logic,   // Rule evaluation: move generation, check and mate tests
+    Network, // Draining NetworkManager's message queue
+    Engine,  // Waiting for Stockfish
+    Pgn,     // Writing the PGN file
+    Draw,    // Building and submitting draw calls
+    Present, // window.display()
+    Count
+};
+
+// Per-frame timing for the render loop, with rolling percentiles over the last
+// few seconds. Time is charged exclusively: a ScopedTimer inside another pauses
+// the outer one. Main thread only.
+class FrameProfiler
+{
+private:
+    static const int HISTORY = 240; // Frames kept for percentiles
+    static const int PHASES = static_cast<int>(FramePhase::Count);
+
+    double current[PHASES];            // ms charged to each phase in the frame being built
+    double history[PHASES + 1][HISTORY]; // Last index holds whole-frame CPU time
+    int historyCount;
+    int historyNext;
+
+    int activePhase; // -1 when no timer is running
+    chrono::steady_clock::time_point activeSince;
+
+    size_t drawCalls;
+    size_t vertices;
+    size_t lastDrawCalls;
+    size_t lastVertices;
+
+    int framesThisSecond;
+    int framesPerSecond;
+    chrono::steady_clock::time_point secondStart;
+
+    void chargeActive(chrono::steady_clock::time_point now);
+    static double percentileOf(const double *values, int count, double percent);
+
+public:
+    FrameProfiler();
+    static FrameProfiler &instance();
+
+    // Phase switching, normally through ScopedTimer
+    int enter(FramePhase phase); // Returns the phase that was active before
+    void leave(int previousPhase);
+
+    void addDrawCalls(size_t calls, size_t vertexCount);
+
+    // Close the frame after display(); time spent in loop iterations that
+    // didn't draw is carried into the next drawn frame
+    void endFrame();
+
+    double getLast(FramePhase phase) const;
+    double getPercentile(FramePhase phase, double percent) const;
+    double getFrameTimePercentile(double percent) const; // Sum of all phases
+    int getFramesPerSecond() const { return framesPerSecond; }
+    size_t getDrawCalls() const { return lastDrawCalls; }
+    size_t getVertexCount() const { return lastVertices; }
+
+    static const char *phaseName(FramePhase phase);
+    string report() const; // Multi-line text for the HUD
+};
+
+// Charges the time until it goes out of scope to a phase:
+//     ScopedTimer timer(FramePhase::Pgn);
+class ScopedTimer
+{
+private:
+    int previousPhase;
+
+public:
+    explicit ScopedTimer(FramePhase phase) : previousPhase(FrameProfiler::instance().enter(phase)) {}
+    ~ScopedTimer() { FrameProfiler::instance().leave(previousPhase); }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
+
+#endif // FRAMEPROFILER_H
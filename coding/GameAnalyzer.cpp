@@ -0,0 +1,460 @@
+#include "GameAnalyzer.h"
+#include "PgnParser.h"
+#include "Fen.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+
+using namespace std;
+
+// Helper function to format a score from White's point of view
+static string formatWhiteScore(const EngineLine &line, bool whiteToMove)
+{
+    if (!line.hasScore)
+        return "?";
+
+    int score = whiteToMove ? line.score : -line.score;
+    stringstream ss;
+    if (line.scoreIsMate)
+    {
+        ss << (score < 0 ? "-#" : "#") << abs(score);
+    }
+    else
+    {
+        ss << (score >= 0 ? "+" : "-") << abs(score) / 100 << "." << (abs(score) % 100 < 10 ? "0" : "") << abs(score) % 100;
+    }
+    return ss.str();
+}
+
+GameAnalyzer::GameAnalyzer(int workerCount, int hashPerWorkerMb)
+    : workerCount(workerCount), hashPerWorkerMb(hashPerWorkerMb),
+      elapsedSeconds(0), positionsAnalyzed(0), progress(0), cancelled(false)
+{
+    if (this->workerCount <= 0)
+    {
+        this->workerCount = max(1, static_cast<int>(thread::hardware_concurrency()));
+    }
+}
+
+bool GameAnalyzer::addPgnFile(const string &path)
+{
+    PgnParser parser;
+    auto addParsedGame = [&](const PgnGame &game)
+    {
+        if (!game.error.empty())
+        {
+            cerr << path << " game " << game.number << ": " << game.error
+                 << ", analysing the game up to it" << endl;
+        }
+
+        vector<string> uciMoves;
+        uciMoves.reserve(game.moves.size());
+        for (const PgnMove &move : game.moves)
+        {
+            string uciMove = {static_cast<char>('a' + move.fromX), static_cast<char>('8' - move.fromY),
+                              static_cast<char>('a' + move.toX), static_cast<char>('8' - move.toY)};
+            switch (move.promotion)
+            {
+            case 11:
+                uciMove += 'q';
+                break;
+            case 6:
+                uciMove += 'r';
+                break;
+            case 7:
+                uciMove += 'b';
+                break;
+            case 8:
+                uciMove += 'n';
+                break;
+            }
+            uciMoves.push_back(uciMove);
+        }
+
+        if (!uciMoves.empty())
+        {
+            const string *fen = game.tag("FEN");
+            addGame(uciMoves, fen ? *fen : "");
+        }
+        return true;
+    };
+    return parser.parseFile(path, addParsedGame);
+}
+
+void GameAnalyzer::addGame(const vector<string> &uciMoves, const string &startFen)
+{
+    games.push_back(uciMoves);
+    startFens.push_back(startFen);
+}
+
+bool GameAnalyzer::addEpdFile(const string &path)
+{
+    vector<EpdRecord> records;
+    if (!Fen::readEpdFile(path, records))
+        return false;
+    for (const EpdRecord &record : records)
+    {
+        EpdPosition position = {record, games.size()};
+        epdPositions.push_back(position);
+        addGame(vector<string>(), Fen::write(record.position));
+    }
+    return true;
+}
+
+bool GameAnalyzer::run(SearchLimit limit, int limitValue, int multiPv)
+{
+    // Flatten every position of every game into one job list; results are
+    // pre-sized so each worker writes straight into its [game][ply] slot
+    vector<Job> jobs;
+    results.assign(games.size(), vector<PlyEvaluation>());
+    for (size_t g = 0; g < games.size(); g++)
+    {
+        FenPosition start;
+        string error;
+        bool whiteStarts = startFens[g].empty() || !Fen::parse(startFens[g], start, error) || start.whiteToMove;
+        results[g].resize(games[g].size() + 1);
+        for (size_t ply = 0; ply <= games[g].size(); ply++)
+        {
+            PlyEvaluation &evaluation = results[g][ply];
+            evaluation.ply = static_cast<int>(ply);
+            evaluation.whiteToMove = (ply % 2 == 0) == whiteStarts;
+            evaluation.playedMove = ply < games[g].size() ? games[g][ply] : "";
+            jobs.push_back({g, ply});
+        }
+    }
+
+    if (jobs.empty())
+    {
+        cerr << "No games to analyse" << endl;
+        return false;
+    }
+
+    int workers = static_cast<int>(min(static_cast<size_t>(workerCount), jobs.size()));
+    cout << "Analysing " << jobs.size() << " positions from " << games.size() << " game(s) with "
+         << workers << " engine(s), " << hashPerWorkerMb << " MB hash each" << endl;
+
+    size_t nextJob = 0;
+    size_t completed = 0;
+    mutex jobMutex;
+    progress = 0;
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> threads;
+    for (int i = 0; i < workers; i++)
+    {
+        threads.emplace_back(&GameAnalyzer::workerLoop, this, cref(jobs), ref(nextJob), ref(jobMutex),
+                             limit, limitValue, multiPv, ref(completed));
+    }
+    for (auto &worker : threads)
+    {
+        worker.join();
+    }
+
+    elapsedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    positionsAnalyzed = completed;
+    cout << "Analysed " << completed << " positions in " << elapsedSeconds << " s ("
+         << getPositionsPerSecond() << " positions/s)" << endl;
+
+    return completed == jobs.size();
+}
+
+void GameAnalyzer::workerLoop(const vector<Job> &jobs, size_t &nextJob, mutex &jobMutex,
+                              SearchLimit limit, int limitValue, int multiPv, size_t &completed)
+{
+    StockfishEngine engine;
+    if (!engine.initialize())
+    {
+        cerr << "Analysis worker could not start Stockfish" << endl;
+        return;
+    }
+
+    // One search thread per process; parallelism comes from running several processes
+    engine.setOption("Threads", "1");
+    engine.setOption("Hash", to_string(hashPerWorkerMb));
+    if (!engine.beginAnalysis(multiPv))
+        return;
+
+    // Take a few consecutive plies at a time so positions of the same game share hash entries
+    const size_t batchSize = 4;
+    while (true)
+    {
+        size_t first, last;
+        {
+            lock_guard<mutex> lock(jobMutex);
+            if (nextJob >= jobs.size() || cancelled)
+                break;
+            first = nextJob;
+            last = min(jobs.size(), first + batchSize);
+            nextJob = last;
+        }
+
+        for (size_t j = first; j < last; j++)
+        {
+            const Job &job = jobs[j];
+            string position = "";
+            for (size_t m = 0; m < job.ply; m++)
+            {
+                position += (m == 0 ? "" : " ") + games[job.game][m];
+            }
+
+            if (engine.analyzePosition(position, limit, limitValue, results[job.game][job.ply].lines,
+                                       startFens[job.game]))
+            {
+                lock_guard<mutex> lock(jobMutex);
+                completed++;
+                progress++;
+            }
+            else
+            {
+                cerr << "Engine did not answer for game " << job.game + 1 << " ply " << job.ply << endl;
+            }
+        }
+    }
+
+    engine.endAnalysis();
+    if (engine.getHealth().restarts > 0)
+    {
+        cerr << "Analysis worker restarted its engine " << engine.getHealth().restarts << " time(s)" << endl;
+    }
+}
+
+size_t GameAnalyzer::getPositionCount() const
+{
+    size_t count = 0;
+    for (const auto &game : games)
+    {
+        count += game.size() + 1;
+    }
+    return count;
+}
+
+double GameAnalyzer::getPositionsPerSecond() const
+{
+    return elapsedSeconds > 0 ? positionsAnalyzed / elapsedSeconds : 0;
+}
+
+void GameAnalyzer::writeReport(ostream &out, const vector<PlyEvaluation> &evaluations)
+{
+    out << "ply\tplayed\tbest\tscore\tsecond\tscore\n";
+    for (const auto &evaluation : evaluations)
+    {
+        out << evaluation.ply << "\t" << (evaluation.playedMove.empty() ? "-" : evaluation.playedMove);
+        for (size_t i = 0; i < 2; i++)
+        {
+            if (i < evaluation.lines.size())
+            {
+                out << "\t" << evaluation.lines[i].move << "\t"
+                    << formatWhiteScore(evaluation.lines[i], evaluation.whiteToMove);
+            }
+            else
+            {
+                out << "\t-\t-";
+            }
+        }
+        out << "\n";
+    }
+}
+
+void GameAnalyzer::writeViewerJson(ostream &out, const vector<PlyEvaluation> &evaluations)
+{
+    out << "[\n";
+    for (size_t i = 0; i < evaluations.size(); i++)
+    {
+        const PlyEvaluation &evaluation = evaluations[i];
+        out << "  [";
+        bool first = true;
+        for (size_t id = 0; id < evaluation.lines.size(); id++)
+        {
+            const EngineLine &line = evaluation.lines[id];
+            if (!line.hasScore || line.move.empty())
+                continue;
+            int score = evaluation.whiteToMove ? line.score : -line.score;
+            out << (first ? "" : ", ") << "{\"id\": " << id + 1 << ", \"depth\": " << line.depth
+                << ", \"moveUCI\": \"" << line.move << "\", \"evaluation\": {\"type\": \""
+                << (line.scoreIsMate ? "mate" : "cp") << "\", \"value\": " << score << "}}";
+            first = false;
+        }
+        out << "]" << (i + 1 < evaluations.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+// Helper function to turn the SAN moves of a bm or am operand into UCI moves
+static vector<string> epdMovesToUci(const FenPosition &position, const string &sanMoves)
+{
+    vector<vector<int>> board = position.board;
+    GameLogic logic(board);
+    logic.setPosition(position);
+
+    vector<string> moves;
+    istringstream list(sanMoves);
+    string san;
+    while (list >> san)
+    {
+        int fromX, fromY, toX, toY;
+        if (logic.sanToMove(san, position.whiteToMove, fromX, fromY, toX, toY))
+        {
+            string uci = {static_cast<char>('a' + fromX), static_cast<char>('8' - fromY),
+                          static_cast<char>('a' + toX), static_cast<char>('8' - toY)};
+            if (abs(board[fromX][fromY]) == 10 && (toY == 0 || toY == 7))
+            {
+                switch (GameLogic::sanPromotion(san))
+                {
+                case 6:
+                    uci += 'r';
+                    break;
+                case 7:
+                    uci += 'b';
+                    break;
+                case 8:
+                    uci += 'n';
+                    break;
+                default:
+                    uci += 'q';
+                    break;
+                }
+            }
+            moves.push_back(uci);
+        }
+        else
+        {
+            cerr << "EPD move '" << san << "' is not legal in " << Fen::write(position) << endl;
+        }
+    }
+    return moves;
+}
+
+size_t GameAnalyzer::writeEpdReport(ostream &out) const
+{
+    size_t solved = 0, scored = 0;
+    out << "id	best	expected	solved\n";
+    for (const EpdPosition &position : epdPositions)
+    {
+        const EpdRecord &record = position.record;
+        const vector<EngineLine> &lines = results[position.game][0].lines;
+        string best = lines.empty() ? "" : lines[0].move;
+
+        const string *id = record.operation("id");
+        const string *bm = record.operation("bm");
+        const string *am = record.operation("am");
+        string expected = (bm ? "bm " + *bm : "") + (bm && am ? ", " : "") + (am ? "am " + *am : "");
+
+        const char *verdict = "-";
+        if (bm || am)
+        {
+            bool ok = !best.empty();
+            if (bm)
+            {
+                vector<string> moves = epdMovesToUci(record.position, *bm);
+                ok = ok && find(moves.begin(), moves.end(), best) != moves.end();
+            }
+            if (am)
+            {
+                vector<string> moves = epdMovesToUci(record.position, *am);
+                ok = ok && find(moves.begin(), moves.end(), best) == moves.end();
+            }
+            scored++;
+            solved += ok;
+            verdict = ok ? "yes" : "no";
+        }
+        out << (id ? *id : "-") << "\t" << (best.empty() ? "-" : best) << "\t"
+            << (expected.empty() ? "-" : expected) << "\t" << verdict << "\n";
+    }
+    out << "# Solved " << solved << " of " << scored << "\n";
+    return solved;
+}
+
+int GameAnalyzer::runCommandLine(int argc, char *argv[])
+{
+    int threads = 0;
+    int hashMb = 64;
+    SearchLimit limit = SearchLimit::Depth;
+    int limitValue = 14;
+    int multiPv = 2;
+    string outPath;
+    vector<string> files;
+
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue)
+            threads = atoi(argv[++i]);
+        else if (arg == "--hash" && hasValue)
+            hashMb = atoi(argv[++i]);
+        else if (arg == "--depth" && hasValue)
+        {
+            limit = SearchLimit::Depth;
+            limitValue = atoi(argv[++i]);
+        }
+        else if (arg == "--nodes" && hasValue)
+        {
+            limit = SearchLimit::Nodes;
+            limitValue = atoi(argv[++i]);
+        }
+        else if (arg == "--movetime" && hasValue)
+        {
+            limit = SearchLimit::MoveTime;
+            limitValue = atoi(argv[++i]);
+        }
+        else if (arg == "--multipv" && hasValue)
+            multiPv = max(1, atoi(argv[++i]));
+        else if (arg == "--out" && hasValue)
+            outPath = argv[++i];
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            cerr << "Unknown analysis option: " << arg << endl;
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+
+    if (files.empty())
+    {
+        files.push_back("temp_game.pgn"); // The game saved by the last session
+    }
+
+    GameAnalyzer analyzer(threads, hashMb);
+    for (const string &file : files)
+    {
+        bool isEpd = file.size() > 4 && file.compare(file.size() - 4, 4, ".epd") == 0;
+        if (!(isEpd ? analyzer.addEpdFile(file) : analyzer.addPgnFile(file)))
+            return 1;
+    }
+
+    bool complete = analyzer.run(limit, limitValue, multiPv);
+
+    ofstream outFile;
+    if (!outPath.empty())
+    {
+        outFile.open(outPath, ios::out | ios::trunc);
+        if (!outFile.is_open())
+        {
+            cerr << "Could not write analysis report: " << outPath << endl;
+            return 1;
+        }
+    }
+    ostream &out = outPath.empty() ? cout : outFile;
+
+    const auto &results = analyzer.getResults();
+    for (size_t g = 0; g < results.size(); g++)
+    {
+        if (results[g].size() == 1)
+            continue; // An EPD position, reported below
+        out << "# Game " << g + 1 << "\n";
+        writeReport(out, results[g]);
+    }
+    if (!analyzer.epdPositions.empty())
+    {
+        out << "# EPD positions\n";
+        analyzer.writeEpdReport(out);
+    }
+
+    return complete ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#ifndef GAMEANALYZER_H
+#define GAMEANALYZER_H
+
+#include "ChessBoard.h" // StockfishEngine, PlyEvaluation
+#include <string>
+#include <vector>
+#include <ostream>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+// Analyses the positions of one or many games on a pool of Stockfish processes.
+// Each worker runs its own engine with Threads=1, so throughput grows with the
+// number of cores instead of relying on one engine's internal threading.
+class GameAnalyzer
+{
+private:
+    // One position to evaluate: a ply of one of the loaded games
+    struct Job
+    {
+        size_t game;
+        size_t ply;
+    };
+
+    // A position of an EPD test suite, analysed as a game without moves
+    struct EpdPosition
+    {
+        EpdRecord record;
+        size_t game;
+    };
+
+    vector<vector<string>> games;               // UCI moves of every loaded game
+    vector<string> startFens;                   // Where each game starts, empty for the standard start
+    vector<EpdPosition> epdPositions;
+    vector<vector<PlyEvaluation>> results;      // Indexed [game][ply], so results come out in ply order
+    int workerCount;
+    int hashPerWorkerMb;
+    double elapsedSeconds;
+    size_t positionsAnalyzed;
+    atomic<size_t> progress; // Positions evaluated so far by the running analysis
+    atomic<bool> cancelled;
+
+    void workerLoop(const vector<Job> &jobs, size_t &nextJob, mutex &jobMutex,
+                    SearchLimit limit, int limitValue, int multiPv, size_t &completed);
+
+public:
+    // workerCount 0 uses one engine per hardware thread
+    explicit GameAnalyzer(int workerCount = 0, int hashPerWorkerMb = 64);
+
+    // Load every game of a PGN file (e.g. temp_game.pgn written by ChessBoard::updatePgnFile)
+    bool addPgnFile(const string &path);
+    void addGame(const vector<string> &uciMoves, const string &startFen = "");
+
+    // Load every position of an EPD test suite; its bm and am operations are checked
+    // against the engine's best move by writeEpdReport
+    bool addEpdFile(const string &path);
+    size_t getGameCount() const { return games.size(); }
+
+    bool run(SearchLimit limit = SearchLimit::Depth, int limitValue = 14, int multiPv = 2);
+
+    // For watching run from another thread: positions done so far out of all positions
+    // of the loaded games, and a way to stop once the searches under way are finished
+    size_t getProgress() const { return progress; }
+    size_t getPositionCount() const;
+    void cancel() { cancelled = true; }
+
+    const vector<vector<PlyEvaluation>> &getResults() const { return results; }
+    size_t getPositionsAnalyzed() const { return positionsAnalyzed; }
+    double getPositionsPerSecond() const;
+
+    // Tab separated report: one row per position with the two best lines (scores from White's side)
+    static void writeReport(ostream &out, const vector<PlyEvaluation> &evaluations);
+
+    // The same lines as JSON for the analysis viewer: one array of engine lines per
+    // position, scores from White's side, in the shape its own engine produces
+    static void writeViewerJson(ostream &out, const vector<PlyEvaluation> &evaluations);
+
+    // One row per EPD position with the engine's best move and whether it solved the
+    // position, then the total; returns how many were solved
+    size_t writeEpdReport(ostream &out) const;
+
+    // Command line entry: --analyze [--threads N] [--hash MB] [--depth D | --nodes N | --movetime MS]
+    //                     [--multipv N] [--out FILE] [file.pgn | suite.epd ...]
+    static int runCommandLine(int argc, char *argv[]);
+};
+
+#endif // GAMEANALYZER_H
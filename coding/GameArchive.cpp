@@ -0,0 +1,623 @@
+#include "GameArchive.h"
+#include "PgnWriter.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef CHESS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+static const char DATA_MAGIC[4] = {'C', 'G', 'A', '1'};
+static const char INDEX_MAGIC[8] = {'C', 'G', 'B', '1', 0, 0, 0, 0}; // Padded so the entries are 8-byte aligned
+static const size_t INDEX_HEADER = sizeof(INDEX_MAGIC) + sizeof(uint64_t);
+static const size_t BLOCKS_AHEAD_PER_THREAD = 2; // How far readAll's workers may get ahead of the sink
+
+// Helper function to compress a block; false if the codec is not in this build
+static bool compressBlock(ArchiveCodec codec, int level, Lz4 &lz4, const string &raw, string &out)
+{
+    if (codec == ArchiveCodec::Lz4)
+    {
+        out.resize(Lz4::compressBound(raw.size()));
+        out.resize(lz4.compress(raw.data(), raw.size(), &out[0]));
+        return true;
+    }
+#ifdef CHESS_HAVE_ZSTD
+    out.resize(ZSTD_compressBound(raw.size()));
+    size_t size = ZSTD_compress(&out[0], out.size(), raw.data(), raw.size(), level);
+    if (ZSTD_isError(size))
+        return false;
+    out.resize(size);
+    return true;
+#else
+    (void)level;
+    return false;
+#endif
+}
+
+// Helper function to tell whether a path ends in the extension
+static bool hasExtension(const string &path, const char *extension)
+{
+    size_t length = strlen(extension);
+    return path.size() > length && path.compare(path.size() - length, length, extension) == 0;
+}
+
+GameArchiveWriter::GameArchiveWriter(ArchiveCodec codec, int level, size_t blockSize)
+    : data(nullptr), codec(codec), level(level), blockSize(max<size_t>(blockSize, 1)),
+      written(0), gameCount(0), rawBytes(0), compressedBytes(0), blockGames(0)
+{
+}
+
+GameArchiveWriter::~GameArchiveWriter()
+{
+    if (data)
+        close();
+}
+
+bool GameArchiveWriter::isAvailable(ArchiveCodec codec)
+{
+#ifdef CHESS_HAVE_ZSTD
+    return codec == ArchiveCodec::Lz4 || codec == ArchiveCodec::Zstd;
+#else
+    return codec == ArchiveCodec::Lz4;
+#endif
+}
+
+bool GameArchiveWriter::open(const string &path)
+{
+    if (data)
+        close();
+    if (!isAvailable(codec))
+    {
+        cerr << "This build can't write zstd archives (build with CHESS_HAVE_ZSTD)" << endl;
+        return false;
+    }
+    this->path = path;
+    blocks.clear();
+    block.clear();
+    blockGames = 0;
+    gameCount = rawBytes = compressedBytes = 0;
+
+    // An index left from an earlier archive would describe the wrong blocks
+    remove((path + ".idx").c_str());
+    data = fopen(path.c_str(), "wb");
+    if (!data || fwrite(DATA_MAGIC, 1, sizeof(DATA_MAGIC), data) != sizeof(DATA_MAGIC))
+    {
+        cerr << "Could not write game archive: " << path << endl;
+        return false;
+    }
+    written = sizeof(DATA_MAGIC);
+    return true;
+}
+
+bool GameArchiveWriter::openAppend(const string &path)
+{
+    FILE *existing = fopen(path.c_str(), "rb");
+    if (!existing)
+        return open(path);
+    fclose(existing);
+
+    if (data)
+        close();
+    if (!isAvailable(codec))
+    {
+        cerr << "This build can't write zstd archives (build with CHESS_HAVE_ZSTD)" << endl;
+        return false;
+    }
+    FILE *existingIndex = fopen((path + ".idx").c_str(), "rb");
+    if (existingIndex)
+    {
+        fclose(existingIndex);
+
+        // The archive is unmapped again before it is written to
+        GameArchive archive;
+        if (!archive.open(path))
+            return false;
+        blocks.clear();
+        for (size_t i = 0; i < archive.getBlockCount(); i++)
+            blocks.push_back(archive.getBlock(i));
+        gameCount = archive.getGameCount();
+        written = archive.getDataSize(); // Past anything a crash left after the last indexed block
+    }
+    else
+    {
+        // The index is only written by close, so a crash during the first save leaves
+        // a data file without one. Nothing in it can be found: a new index starts after it
+        MappedFile existingData;
+        if (!existingData.open(path))
+        {
+            cerr << "Could not open game archive: " << path << endl;
+            return false;
+        }
+        if (existingData.size() < sizeof(DATA_MAGIC))
+        {
+            existingData.close();
+            return open(path); // Cut off before even the magic was written
+        }
+        if (memcmp(existingData.data(), DATA_MAGIC, sizeof(DATA_MAGIC)) != 0)
+        {
+            cerr << "Not a game archive: " << path << endl;
+            return false;
+        }
+        blocks.clear();
+        gameCount = 0;
+        written = existingData.size();
+    }
+    this->path = path;
+    block.clear();
+    blockGames = 0;
+    rawBytes = compressedBytes = 0;
+
+    data = fopen(path.c_str(), "ab");
+    if (!data)
+    {
+        cerr << "Could not write game archive: " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+bool GameArchiveWriter::addGame(const PgnGame &game)
+{
+    if (!data)
+        return false;
+
+    bool complete = GameStore::appendRecord(block, game, position);
+    blockGames++;
+    gameCount++;
+    if (block.size() >= blockSize && !flushBlock())
+        return false;
+    return complete;
+}
+
+bool GameArchiveWriter::flushBlock()
+{
+    if (blockGames == 0)
+        return true;
+    if (!compressBlock(codec, level, lz4, block, compressed))
+    {
+        cerr << "Could not compress a block of game archive: " << path << endl;
+        return false;
+    }
+    if (fwrite(compressed.data(), 1, compressed.size(), data) != compressed.size())
+    {
+        cerr << "Could not write game archive: " << path << endl;
+        return false;
+    }
+
+    ArchiveBlock entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.offset = written;
+    entry.firstGame = gameCount - blockGames;
+    entry.compressedSize = static_cast<uint32_t>(compressed.size());
+    entry.rawSize = static_cast<uint32_t>(block.size());
+    entry.gameCount = blockGames;
+    entry.codec = static_cast<uint8_t>(codec);
+    blocks.push_back(entry);
+
+    written += compressed.size();
+    rawBytes += block.size();
+    compressedBytes += compressed.size();
+    block.clear();
+    blockGames = 0;
+    return true;
+}
+
+bool GameArchiveWriter::close()
+{
+    if (!data)
+        return false;
+    bool ok = flushBlock();
+    ok = writeIndex() && ok;
+    ok = fclose(data) == 0 && ok;
+    data = nullptr;
+    return ok;
+}
+
+bool GameArchiveWriter::writeIndex()
+{
+    if (!data)
+        return false;
+    bool ok = PgnWriter::syncFile(data); // The blocks must be on disk before an index lists them
+
+    // The new index only goes in once every block it lists is in the data file
+    string contents(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    uint64_t count = blocks.size();
+    contents.append(reinterpret_cast<const char *>(&count), sizeof(count));
+    contents.append(reinterpret_cast<const char *>(blocks.data()), blocks.size() * sizeof(ArchiveBlock));
+    string indexPath = path + ".idx";
+    ok = ok && PgnWriter::writeFileAtomically(indexPath, contents);
+    if (!ok)
+        cerr << "Could not write game archive index: " << indexPath << endl;
+    return ok;
+}
+
+GameArchive::GameArchive() : blocks(nullptr), blockCount(0), gameCount(0), cachedBlock(SIZE_MAX)
+{
+}
+
+bool GameArchive::open(const string &path)
+{
+    blocks = nullptr;
+    blockCount = 0;
+    gameCount = 0;
+    cachedBlock = SIZE_MAX;
+    if (!data.open(path) || !index.open(path + ".idx"))
+    {
+        cerr << "Could not open game archive: " << path << endl;
+        return false;
+    }
+
+    // Both files must be whole, and every block must lie inside the data file
+    uint64_t count = 0;
+    bool valid = data.size() >= sizeof(DATA_MAGIC) && memcmp(data.data(), DATA_MAGIC, sizeof(DATA_MAGIC)) == 0 &&
+                 index.size() >= INDEX_HEADER && memcmp(index.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+    if (valid)
+    {
+        memcpy(&count, index.data() + sizeof(INDEX_MAGIC), sizeof(count));
+        valid = (index.size() - INDEX_HEADER) / sizeof(ArchiveBlock) == count &&
+                (index.size() - INDEX_HEADER) % sizeof(ArchiveBlock) == 0;
+    }
+    const ArchiveBlock *table = reinterpret_cast<const ArchiveBlock *>(index.data() + INDEX_HEADER);
+    for (uint64_t i = 0; valid && i < count; i++)
+    {
+        const ArchiveBlock &block = table[i];
+        valid = block.offset >= sizeof(DATA_MAGIC) && block.offset <= data.size() &&
+                block.compressedSize <= data.size() - block.offset && block.firstGame == gameCount &&
+                block.gameCount > 0 && (block.codec == static_cast<uint8_t>(ArchiveCodec::Lz4) ||
+                                        block.codec == static_cast<uint8_t>(ArchiveCodec::Zstd));
+        gameCount += block.gameCount;
+    }
+    if (!valid)
+    {
+        cerr << "Game archive is damaged or incomplete: " << path << endl;
+        data.close();
+        index.close();
+        gameCount = 0;
+        return false;
+    }
+    blocks = table;
+    blockCount = static_cast<size_t>(count);
+    return true;
+}
+
+size_t GameArchive::findBlock(uint64_t game) const
+{
+    const ArchiveBlock *after = upper_bound(blocks, blocks + blockCount, game,
+                                            [](uint64_t g, const ArchiveBlock &block)
+                                            { return g < block.firstGame; });
+    return static_cast<size_t>(after - blocks) - 1;
+}
+
+bool GameArchive::decompressBlock(size_t n, string &raw) const
+{
+    const ArchiveBlock &block = blocks[n];
+    const char *compressed = data.data() + block.offset;
+    raw.resize(block.rawSize);
+    if (block.codec == static_cast<uint8_t>(ArchiveCodec::Lz4))
+        return Lz4::decompress(compressed, block.compressedSize, &raw[0], block.rawSize);
+#ifdef CHESS_HAVE_ZSTD
+    size_t size = ZSTD_decompress(&raw[0], raw.size(), compressed, block.compressedSize);
+    return !ZSTD_isError(size) && size == block.rawSize;
+#else
+    cerr << "Archive block " << n + 1 << " is zstd compressed; this build can't read it (build with CHESS_HAVE_ZSTD)"
+         << endl;
+    return false;
+#endif
+}
+
+bool GameArchive::readGame(uint64_t n, PgnGame &game)
+{
+    if (n >= gameCount)
+        return false;
+    size_t b = findBlock(n);
+    const ArchiveBlock &block = blocks[b];
+    if (b != cachedBlock)
+    {
+        // Find where each record starts once, so any game of the block is one decode away
+        cachedBlock = SIZE_MAX;
+        recordOffsets.clear();
+        if (!decompressBlock(b, raw))
+            return false;
+        const char *p = raw.data();
+        const char *end = p + raw.size();
+        for (uint32_t i = 0; i < block.gameCount; i++)
+        {
+            recordOffsets.push_back(p - raw.data());
+            if (!GameStore::skipRecord(p, end))
+                return false;
+        }
+        if (p != end)
+            return false;
+        cachedBlock = b;
+    }
+
+    const char *p = raw.data() + recordOffsets[static_cast<size_t>(n - block.firstGame)];
+    game.number = n + 1;
+    return GameStore::readRecord(p, raw.data() + raw.size(), game, position);
+}
+
+bool GameArchive::readAll(const PgnImporter::GameSink &sink, int threadCount) const
+{
+    if (blockCount == 0)
+        return true;
+    if (threadCount <= 0)
+        threadCount = max(1, static_cast<int>(thread::hardware_concurrency()));
+    size_t workers = min(static_cast<size_t>(threadCount), blockCount);
+
+    mutex stateMutex; // Guards everything below
+    condition_variable stateChanged;
+    size_t nextBlock = 0;
+    size_t blocksSunk = 0;
+    size_t damagedBlock = SIZE_MAX; // The first block that could not be read
+    bool stopping = false;
+    map<size_t, vector<PgnGame>> decoded; // Finished blocks waiting for their turn at the sink
+    size_t ahead = workers * BLOCKS_AHEAD_PER_THREAD;
+
+    auto decodeBlocks = [&]()
+    {
+        string raw;
+        StoredPosition position;
+        while (true)
+        {
+            size_t b;
+            {
+                unique_lock<mutex> lock(stateMutex);
+                stateChanged.wait(lock, [&]
+                                  { return stopping || nextBlock >= blockCount || nextBlock < blocksSunk + ahead; });
+                if (stopping || nextBlock >= blockCount)
+                    return;
+                b = nextBlock++;
+            }
+
+            const ArchiveBlock &block = blocks[b];
+            vector<PgnGame> games(block.gameCount);
+            bool ok = decompressBlock(b, raw);
+            const char *p = raw.data();
+            const char *end = p + raw.size();
+            for (size_t i = 0; i < games.size() && ok; i++)
+            {
+                games[i].tagCount = 0;
+                games[i].number = block.firstGame + i + 1;
+                ok = GameStore::readRecord(p, end, games[i], position);
+            }
+            ok = ok && p == end;
+
+            {
+                lock_guard<mutex> lock(stateMutex);
+                if (ok)
+                    decoded[b] = move(games);
+                else
+                    damagedBlock = min(damagedBlock, b);
+            }
+            stateChanged.notify_all();
+        }
+    };
+
+    vector<thread> threads;
+    for (size_t i = 0; i < workers; i++)
+        threads.emplace_back(decodeBlocks);
+
+    // Hand the games out in archive order, whatever order the blocks finish in
+    bool ok = true;
+    for (size_t b = 0; b < blockCount; b++)
+    {
+        vector<PgnGame> games;
+        {
+            unique_lock<mutex> lock(stateMutex);
+            stateChanged.wait(lock, [&]
+                              { return decoded.count(b) > 0 || damagedBlock <= b; });
+            if (decoded.count(b) == 0)
+            {
+                cerr << "Game archive block " << b + 1 << " is damaged" << endl;
+                ok = false;
+                break;
+            }
+            games = move(decoded[b]);
+            decoded.erase(b);
+        }
+        for (const PgnGame &game : games)
+            sink(game);
+        {
+            lock_guard<mutex> lock(stateMutex);
+            blocksSunk = b + 1;
+        }
+        stateChanged.notify_all();
+    }
+
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    stateChanged.notify_all();
+    for (thread &worker : threads)
+        worker.join();
+    return ok;
+}
+
+int GameArchive::runCommandLine(int argc, char *argv[])
+{
+    ArchiveCodec codec = ArchiveCodec::Lz4;
+    int level = 0;
+    size_t blockSize = GameArchiveWriter::BLOCK_SIZE;
+    int threads = 0;
+    bool append = false;
+    bool check = false;
+    uint64_t gameNumber = 0; // Counting from 1, 0 for none
+    vector<string> files;
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--codec" && hasValue)
+        {
+            string name = argv[++i];
+            if (name == "lz4")
+                codec = ArchiveCodec::Lz4;
+            else if (name == "zstd")
+                codec = ArchiveCodec::Zstd;
+            else
+            {
+                cerr << "Unknown archive codec: " << name << " (lz4 or zstd)" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--level" && hasValue)
+            level = atoi(argv[++i]);
+        else if (arg == "--block" && hasValue)
+            blockSize = static_cast<size_t>(max(1, atoi(argv[++i]))) << 10;
+        else if (arg == "--threads" && hasValue)
+            threads = atoi(argv[++i]);
+        else if (arg == "--append")
+            append = true;
+        else if (arg == "--check")
+            check = true;
+        else if (arg == "--game" && hasValue)
+            gameNumber = strtoull(argv[++i], nullptr, 10);
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            cerr << "Unknown archive option: " << arg << endl;
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+
+    bool readOnly = check || gameNumber > 0;
+    if ((readOnly && files.size() != 1) || (!readOnly && files.size() != 2))
+    {
+        cerr << "Usage: --archive [--codec lz4|zstd] [--level N] [--block KB] [--threads N] [--append]"
+                " in.pgn|in.cgd|in.cga out.cga | --archive [--threads N] in.cga out.pgn |"
+                " --archive --game N in.cga | --archive --check [--threads N] in.cga"
+             << endl;
+        return 1;
+    }
+    const string &in = files[0];
+    auto start = chrono::steady_clock::now();
+
+    if (gameNumber > 0)
+    {
+        // One game: a search of the index and a single block
+        GameArchive archive;
+        if (!archive.open(in))
+            return 1;
+        PgnGame game;
+        game.tagCount = 0;
+        if (!archive.readGame(gameNumber - 1, game))
+        {
+            cerr << in << " game " << gameNumber << " could not be read" << endl;
+            return 1;
+        }
+        double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+        string text;
+        StoredGamePgn pgnText;
+        pgnText.append(text, game);
+        cout << text;
+        cerr << "Read in " << fixed << setprecision(1) << micros << " us" << endl;
+        return 0;
+    }
+
+    if (check || hasExtension(files[1], ".pgn"))
+    {
+        GameArchive archive;
+        if (!archive.open(in))
+            return 1;
+        FILE *pgn = nullptr;
+        if (!check)
+        {
+            pgn = fopen(files[1].c_str(), "wb");
+            if (!pgn)
+            {
+                cerr << "Could not write PGN file: " << files[1] << endl;
+                return 1;
+            }
+        }
+
+        size_t games = 0, moves = 0;
+        StoredGamePgn pgnText;
+        string text;
+        bool written = true;
+        auto sink = [&](const PgnGame &game)
+        {
+            games++;
+            moves += game.moves.size();
+            if (!pgn)
+                return;
+            text.clear();
+            pgnText.append(text, game);
+            written = written && fwrite(text.data(), 1, text.size(), pgn) == text.size();
+        };
+        bool ok = archive.readAll(sink, threads);
+        if (pgn)
+        {
+            written = fclose(pgn) == 0 && written;
+            if (!written)
+                cerr << "Could not write PGN file: " << files[1] << endl;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << games << " games, " << moves << " moves from " << archive.getBlockCount() << " blocks ("
+             << archive.getDataSize() / 1e6 << " MB) in " << seconds << " s, "
+             << (seconds > 0 ? archive.getDataSize() / 1e6 / seconds : 0) << " MB/s" << endl;
+        return ok && written ? 0 : 1;
+    }
+
+    // Build, add to or repack an archive
+    const string &out = files[1];
+    GameArchiveWriter writer(codec, level, blockSize);
+    if (!(append ? writer.openAppend(out) : writer.open(out)))
+        return 1;
+    uint64_t before = writer.getGameCount();
+    size_t shortened = 0;
+    auto add = [&](const PgnGame &game)
+    {
+        if (!writer.addGame(game) || !game.error.empty())
+            shortened++;
+    };
+
+    bool ok = true;
+    if (hasExtension(in, ".pgn"))
+    {
+        // Games are parsed on every core and archived in file order
+        PgnImporter importer(threads);
+        ok = importer.importFile(in, add);
+        importer.printStats(cout);
+    }
+    else if (hasExtension(in, ".cga"))
+    {
+        GameArchive source;
+        ok = source.open(in) && source.readAll(add, threads);
+    }
+    else
+    {
+        GameStore store;
+        if (!store.open(in))
+            return 1;
+        PgnGame game;
+        game.tagCount = 0;
+        for (size_t n = 0; n < store.getGameCount(); n++)
+        {
+            if (store.readGame(n, game))
+                add(game);
+            else
+                cerr << in << " game " << n + 1 << " could not be read" << endl;
+        }
+    }
+    ok = writer.close() && ok;
+
+    double ratio = writer.getRawBytes() > 0 ? 100.0 * writer.getCompressedBytes() / writer.getRawBytes() : 0;
+    cout << writer.getGameCount() - before << " games archived in " << out << " ("
+         << writer.getGameCount() << " in all), " << shortened
+         << " of them cut short at a move that could not be read or stored" << endl;
+    cout << writer.getRawBytes() / 1e6 << " MB of records compressed to " << writer.getCompressedBytes() / 1e6
+         << " MB (" << fixed << setprecision(1) << ratio << "%) in "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+#ifndef GAMEARCHIVE_H
+#define GAMEARCHIVE_H
+
+#include "GameStore.h"
+#include "PgnImporter.h"
+#include "MappedFile.h"
+#include "Lz4.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum class ArchiveCodec : uint8_t
+{
+    Lz4 = 1, // Built in; fast to write and read
+    Zstd = 2 // Denser; needs the zstd library (build with CHESS_HAVE_ZSTD)
+};
+
+// One entry of an archive's block index
+struct ArchiveBlock
+{
+    uint64_t offset;    // Where the compressed block starts in the data file
+    uint64_t firstGame; // Number of its first game, counting from 0
+    uint32_t compressedSize;
+    uint32_t rawSize;
+    uint32_t gameCount;
+    uint8_t codec;       // ArchiveCodec
+    uint8_t reserved[3]; // Keeps an entry 32 bytes in the file
+};
+
+// Compressed game archives. Games are kept in the GameStore record format, and
+// records are grouped into blocks of about blockSize bytes that are compressed on
+// their own, each with the codec it names. The data file is a 4-byte magic and the
+// blocks; the index next to it (<data>.idx) is an 8-byte magic, the block count
+// (8 bytes) and one ArchiveBlock per block. Game N is found with a binary search of
+// the index and only its block is decompressed; a whole archive is decompressed on
+// every core, a block per task.
+//
+// Archives only grow: blocks are appended to the data file and the index is
+// replaced in one step, so a crash leaves the archive as it was before.
+class GameArchiveWriter
+{
+private:
+    FILE *data;
+    string path;
+    ArchiveCodec codec;
+    int level;
+    size_t blockSize;
+    vector<ArchiveBlock> blocks;
+    uint64_t written;
+    uint64_t gameCount;
+    uint64_t rawBytes; // Since open, for the compression ratio
+    uint64_t compressedBytes;
+    string block; // Records of the block being filled
+    uint32_t blockGames;
+    string compressed; // Reused for every block
+    StoredPosition position;
+    Lz4 lz4;
+
+    bool flushBlock();
+
+public:
+    static const size_t BLOCK_SIZE = 256 << 10; // Raw bytes: about a thousand games
+
+    // level only applies to zstd (0 is its default)
+    explicit GameArchiveWriter(ArchiveCodec codec = ArchiveCodec::Lz4, int level = 0, size_t blockSize = BLOCK_SIZE);
+    ~GameArchiveWriter(); // Closes the archive if close was not called
+
+    bool open(const string &path);       // A new, empty archive
+    bool openAppend(const string &path); // Add games after those already there; creates the archive if missing
+
+    // The game's moves up to its first error, if it has one; false if it was cut short
+    // or could not be written
+    bool addGame(const PgnGame &game);
+
+    bool close(); // Writes the last block and the index; games added since open are lost without it
+
+    // Replace the index with one listing every block written so far, leaving the archive
+    // open; games in the block still being filled are not in it
+    bool writeIndex();
+
+    uint64_t getGameCount() const { return gameCount; } // Including those already in an appended archive
+    uint32_t getUnwrittenGames() const { return blockGames; } // In the block being filled
+    uint64_t getRawBytes() const { return rawBytes; }
+    uint64_t getCompressedBytes() const { return compressedBytes; }
+
+    static bool isAvailable(ArchiveCodec codec); // Zstd only when built with CHESS_HAVE_ZSTD
+};
+
+class GameArchive
+{
+private:
+    MappedFile data;
+    MappedFile index;
+    const ArchiveBlock *blocks;
+    size_t blockCount;
+    uint64_t gameCount;
+
+    // readGame keeps the last block it decompressed, and where its records start
+    size_t cachedBlock;
+    string raw;
+    vector<size_t> recordOffsets;
+    StoredPosition position;
+
+    size_t findBlock(uint64_t game) const;
+
+public:
+    GameArchive();
+
+    bool open(const string &path);
+    uint64_t getGameCount() const { return gameCount; }
+    size_t getBlockCount() const { return blockCount; }
+    size_t getDataSize() const { return data.size(); }
+    const ArchiveBlock &getBlock(size_t n) const { return blocks[n]; }
+
+    // Decompress block n into raw; safe to call from several threads at once
+    bool decompressBlock(size_t n, string &raw) const;
+
+    // Game n (counting from 0); only its block is decompressed, and reading on
+    // through the same block decompresses nothing
+    bool readGame(uint64_t n, PgnGame &game);
+
+    // Every game, in order, to the sink on this thread; blocks are decompressed and
+    // decoded on threadCount workers (0: one per hardware thread). False if a block
+    // is damaged; the games before it have been handed out
+    bool readAll(const PgnImporter::GameSink &sink, int threadCount = 0) const;
+
+    // Command line entry: --archive [--codec lz4|zstd] [--level N] [--block KB] [--threads N] [--append]
+    //                               in.pgn|in.cgd|in.cga out.cga   (build, or repack)
+    //                     --archive [--threads N] in.cga out.pgn    (back to PGN)
+    //                     --archive --game N in.cga                 (print one game)
+    //                     --archive --check [--threads N] in.cga    (decode everything, timed)
+    static int runCommandLine(int argc, char *argv[]);
+};
+
+#endif // GAMEARCHIVE_H
@@ -1,18 +1,26 @@
 #include "GameLogic.h"
 #include "ChessBoard.h"
+#include "PgnSerializer.h"
+#include "Zobrist.h"
 #include <math.h>
-#include <SFML/Audio.hpp>
 #include <iostream>
 #include <ctime>
+#include <cctype>
 
 using namespace std;
 
-// Initialize static members
-int GameLogic::lastKingX[2] = {-1, -1}; // [0] for black, [1] for white
-int GameLogic::lastKingY[2] = {-1, -1}; // [0] for black, [1] for white
-
 GameLogic::GameLogic(vector<vector<int>> &boardRef, ChessBoard &chessBoardRef)
-    : board(boardRef), chessBoard(chessBoardRef),
+    : board(boardRef), chessBoard(&chessBoardRef),
+      enPassantCol(-1), enPassantRow(-1), enPassantPossible(false),
+      whiteKingMoved(false), blackKingMoved(false),
+      whiteQueensideRookMoved(false), whiteKingsideRookMoved(false),
+      blackQueensideRookMoved(false), blackKingsideRookMoved(false)
+{
+    reset();
+}
+
+GameLogic::GameLogic(vector<vector<int>> &boardRef)
+    : board(boardRef), chessBoard(nullptr),
       enPassantCol(-1), enPassantRow(-1), enPassantPossible(false),
       whiteKingMoved(false), blackKingMoved(false),
       whiteQueensideRookMoved(false), whiteKingsideRookMoved(false),
@@ -43,8 +51,13 @@ void GameLogic::reset()
     blackQueensideRookMoved = false;
     blackKingsideRookMoved = false;
 
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    startFen.clear();
+
     // Clear move history
     moveHistory.clear();
+    gameResult = "*";
 }
 
 bool GameLogic::isWhite(int x, int y) const
@@ -454,14 +467,220 @@ bool GameLogic::isValidMove(int x, int y, int xx, int yy)
     return false;
 }
 
-void GameLogic::movePiece(int x, int y, int xx, int yy)
+bool GameLogic::pieceCanReach(int x, int y, int toX, int toY) const
+{
+    int piece = board[x][y];
+    int target = board[toX][toY];
+    if (piece == 0 || (x == toX && y == toY))
+        return false;
+    if ((piece > 0 && target > 0) || (piece < 0 && target < 0))
+        return false; // Own piece on the target square
+
+    int dx = toX - x;
+    int dy = toY - y;
+    switch (abs(piece))
+    {
+    case 10: // Pawn
+    {
+        int forward = piece > 0 ? -1 : 1;
+        int startRow = piece > 0 ? 6 : 1;
+        if (dx == 0)
+            return target == 0 && (dy == forward || (dy == 2 * forward && y == startRow && board[x][y + forward] == 0));
+        if (abs(dx) != 1 || dy != forward)
+            return false;
+        return target != 0 || isEnPassantCapture(x, y, toX, toY);
+    }
+    case 8: // Knight
+        return abs(dx * dy) == 2;
+    case 9: // King, castling aside
+        return abs(dx) <= 1 && abs(dy) <= 1;
+    case 6: // Rook
+        if (dx != 0 && dy != 0)
+            return false;
+        break;
+    case 7: // Bishop
+        if (abs(dx) != abs(dy))
+            return false;
+        break;
+    case 11: // Queen
+        if (dx != 0 && dy != 0 && abs(dx) != abs(dy))
+            return false;
+        break;
+    default:
+        return false;
+    }
+
+    // Sliding pieces need every square in between to be empty
+    int stepX = (dx > 0) - (dx < 0);
+    int stepY = (dy > 0) - (dy < 0);
+    for (int cx = x + stepX, cy = y + stepY; cx != toX || cy != toY; cx += stepX, cy += stepY)
+    {
+        if (board[cx][cy] != 0)
+            return false;
+    }
+    return true;
+}
+
+uint64_t GameLogic::reachableSquares(int x, int y) const
+{
+    int piece = board[x][y];
+    if (piece == 0)
+        return 0;
+    bool isWhitePiece = piece > 0;
+    uint64_t squares = 0;
+
+    // Adds a square on the board unless one of the mover's own pieces stands there
+    auto add = [&](int toX, int toY)
+    {
+        if (toX >= 0 && toX < 8 && toY >= 0 && toY < 8 && (isWhitePiece ? board[toX][toY] <= 0 : board[toX][toY] >= 0))
+            squares |= 1ULL << (toX * 8 + toY);
+    };
+
+    switch (abs(piece))
+    {
+    case 10: // Pawn
+    {
+        int forward = isWhitePiece ? -1 : 1;
+        int nextY = y + forward;
+        if (nextY < 0 || nextY >= 8)
+            break;
+        if (board[x][nextY] == 0)
+        {
+            add(x, nextY);
+            if (y == (isWhitePiece ? 6 : 1) && board[x][nextY + forward] == 0)
+                add(x, nextY + forward);
+        }
+        for (int side = -1; side <= 1; side += 2)
+        {
+            int toX = x + side;
+            if (toX >= 0 && toX < 8 && (board[toX][nextY] != 0 || isEnPassantCapture(x, y, toX, nextY)))
+                add(toX, nextY);
+        }
+        break;
+    }
+    case 8: // Knight
+    {
+        int knightMoves[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+        for (auto move : knightMoves)
+            add(x + move[0], y + move[1]);
+        break;
+    }
+    case 9: // King
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            for (int dy = -1; dy <= 1; dy++)
+            {
+                if (dx != 0 || dy != 0)
+                    add(x + dx, y + dy);
+            }
+        }
+
+        // Castling while the king and rook haven't moved and nothing stands between them;
+        // whether the king passes through check is left to the caller
+        int homeRow = isWhitePiece ? 7 : 0;
+        bool kingMoved = isWhitePiece ? whiteKingMoved : blackKingMoved;
+        int rook = isWhitePiece ? 6 : -6;
+        if (x == 4 && y == homeRow && !kingMoved)
+        {
+            if (!(isWhitePiece ? whiteKingsideRookMoved : blackKingsideRookMoved) && board[7][homeRow] == rook &&
+                board[5][homeRow] == 0 && board[6][homeRow] == 0)
+                add(6, homeRow);
+            if (!(isWhitePiece ? whiteQueensideRookMoved : blackQueensideRookMoved) && board[0][homeRow] == rook &&
+                board[1][homeRow] == 0 && board[2][homeRow] == 0 && board[3][homeRow] == 0)
+                add(2, homeRow);
+        }
+        break;
+    }
+    default: // Rook, bishop, queen: slide until a piece is in the way
+    {
+        int directions[8][2] = {{0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+        int first = abs(piece) == 7 ? 4 : 0; // Bishops only use the diagonals
+        int last = abs(piece) == 6 ? 4 : 8;  // Rooks only use the straight lines
+        for (int d = first; d < last; d++)
+        {
+            for (int toX = x + directions[d][0], toY = y + directions[d][1];
+                 toX >= 0 && toX < 8 && toY >= 0 && toY < 8; toX += directions[d][0], toY += directions[d][1])
+            {
+                add(toX, toY);
+                if (board[toX][toY] != 0)
+                    break;
+            }
+        }
+        break;
+    }
+    }
+    return squares;
+}
+
+void GameLogic::movePiece(int x, int y, int xx, int yy, int promotion)
 {
-    // Record the move before making it
-    addMoveToHistory(x, y, xx, yy);
+    // SAN needs the position before the move; the check suffix is added once it is made
+    string san = moveToSan(x, y, xx, yy, promotion);
+
+    bool isWhitePiece = board[x][y] > 0;
+    if (chessBoard)
+    {
+        // Determine if this move puts the opponent in check
+        bool putsInCheck = moveWouldCheck(x, y, xx, yy, isWhitePiece);
+        bool wasEnPassant = isEnPassantCapture(x, y, xx, yy);
+        bool castlingMove = isCastlingMove(x, y, xx, yy);
+
+        // Play move sound (decoded at startup, so no file access on the move path)
+        bool promotion = abs(board[x][y]) == 10 && (yy == 0 || yy == 7);
+        if (putsInCheck)
+            chessBoard->playSound(SoundEffect::Check);
+        else if (castlingMove)
+            chessBoard->playSound(SoundEffect::Castle);
+        else if (promotion)
+            chessBoard->playSound(SoundEffect::Promote);
+        else if (board[xx][yy] == 0 && !wasEnPassant)
+            chessBoard->playSound(SoundEffect::Move);
+        else
+            chessBoard->playSound(SoundEffect::Capture);
 
-    // Determine if this move puts the opponent in check
+        // Slide the piece on screen; the captured pawn of an en passant is not on the target square
+        if (wasEnPassant)
+            chessBoard->animateMove(x, y, xx, yy, xx, isWhitePiece ? yy + 1 : yy - 1);
+        else
+            chessBoard->animateMove(x, y, xx, yy);
+        if (castlingMove)
+        {
+            int rookY = isWhitePiece ? 7 : 0;
+            if (xx > x)
+                chessBoard->animateMove(7, rookY, 5, rookY); // Kingside rook
+            else
+                chessBoard->animateMove(0, rookY, 3, rookY); // Queenside rook
+        }
+    }
+
+    playMove(x, y, xx, yy, promotion);
+
+    // Mate is only possible after a checking move, and is only looked for then;
+    // the result is kept so the PGN never has to work it out again. Check is tested
+    // on the new position so promotions and discovered checks are marked too
+    if (check(!isWhitePiece))
+    {
+        if (checkMate(!isWhitePiece))
+        {
+            san += '#';
+            gameResult = isWhitePiece ? "1-0" : "0-1";
+        }
+        else
+        {
+            san += '+';
+        }
+    }
+
+    // Add to both histories
+    moveHistory.push_back(san);
+    if (chessBoard)
+        chessBoard->addAlgebraicMove(san); // Add to ChessBoard's history
+}
+
+void GameLogic::playMove(int x, int y, int xx, int yy, int promotion)
+{
     bool isWhitePiece = board[x][y] > 0;
-    bool putsInCheck = moveWouldCheck(x, y, xx, yy, isWhitePiece);
 
     // Reset en passant flag
     bool wasEnPassant = isEnPassantCapture(x, y, xx, yy);
@@ -469,6 +688,14 @@ void GameLogic::movePiece(int x, int y, int xx, int yy)
     // Check if this is a castling move
     bool castlingMove = isCastlingMove(x, y, xx, yy);
 
+    // Move clocks, as FEN counts them
+    if (abs(board[x][y]) == 10 || board[xx][yy] != 0 || wasEnPassant)
+        halfmoveClock = 0;
+    else
+        halfmoveClock++;
+    if (!isWhitePiece)
+        fullmoveNumber++;
+
     // Track king and rook movement for castling
     if (abs(board[x][y]) == 9) // King
     {
@@ -495,6 +722,16 @@ void GameLogic::movePiece(int x, int y, int xx, int yy)
         }
     }
 
+    // A rook captured on its home square is gone for castling too, even if another rook gets there later
+    if (xx == 0 && yy == 7)
+        whiteQueensideRookMoved = true;
+    else if (xx == 7 && yy == 7)
+        whiteKingsideRookMoved = true;
+    else if (xx == 0 && yy == 0)
+        blackQueensideRookMoved = true;
+    else if (xx == 7 && yy == 0)
+        blackKingsideRookMoved = true;
+
     // Check if this move enables en passant
     bool enPassantMove = false;
     if (abs(board[x][y]) == 10) // Pawn
@@ -522,21 +759,6 @@ void GameLogic::movePiece(int x, int y, int xx, int yy)
         resetEnPassant();
     }
 
-    // Play move sound
-    static sf::SoundBuffer buffer;
-    static sf::Sound sound;
-
-    if (putsInCheck)
-        buffer.loadFromFile("coding/sounds/move-check.wav");
-    else if (board[xx][yy] == 0 && !wasEnPassant)
-        buffer.loadFromFile("coding/sounds/move-self.wav");
-    else
-        buffer.loadFromFile("coding/sounds/capture.wav");
-
-    sound.setBuffer(buffer);
-    sound.play();
-    sound.setVolume(100);
-
     // Handle en passant capture (remove the captured pawn)
     if (wasEnPassant)
     {
@@ -544,13 +766,11 @@ void GameLogic::movePiece(int x, int y, int xx, int yy)
         {
             // White capturing black - captured pawn is on the same column but one row below
             board[xx][yy + 1] = 0;
-            chessBoard.getPieceSprites()[xx][yy + 1] = Sprite();
         }
         else
         {
             // Black capturing white - captured pawn is on the same column but one row above
             board[xx][yy - 1] = 0;
-            chessBoard.getPieceSprites()[xx][yy - 1] = Sprite();
         }
     }
 
@@ -576,11 +796,6 @@ void GameLogic::movePiece(int x, int y, int xx, int yy)
         // Move the rook
         board[rookToX][rookY] = board[rookFromX][rookY];
         board[rookFromX][rookY] = 0;
-
-        // Update the rook sprite
-        auto &pieceSprites = chessBoard.getPieceSprites();
-        pieceSprites[rookToX][rookY] = pieceSprites[rookFromX][rookY];
-        pieceSprites[rookFromX][rookY] = Sprite();
     }
 
     // Handle pawn promotion
@@ -589,23 +804,18 @@ void GameLogic::movePiece(int x, int y, int xx, int yy)
         // White pawn reaching the top row
         if (board[x][y] > 0 && yy == 0)
         {
-            board[x][y] = 11; // Promote to white queen
+            board[x][y] = promotion; // Promote, to a queen unless told otherwise
         }
         // Black pawn reaching the bottom row
         else if (board[x][y] < 0 && yy == 7)
         {
-            board[x][y] = -11; // Promote to black queen
+            board[x][y] = -promotion;
         }
     }
 
     // Move the piece on the board
     board[xx][yy] = board[x][y];
     board[x][y] = 0;
-
-    // Update the sprites
-    auto &pieceSprites = chessBoard.getPieceSprites();
-    pieceSprites[xx][yy] = pieceSprites[x][y];
-    pieceSprites[x][y] = Sprite();
 }
 
 vector<vector<int>> GameLogic::getAllMoves(bool color)
@@ -630,10 +840,7 @@ vector<vector<int>> GameLogic::getAllMoves(bool color)
 
 bool GameLogic::check(bool color)
 {
-    // Cache the king position for performance
-    static int lastKingX[2] = {-1, -1}; // [0] for black, [1] for white
-    static int lastKingY[2] = {-1, -1}; // [0] for black, [1] for white
-
+    // The king position is cached per instance, so games on other threads don't share it
     int kingValue = color ? 9 : -9; // 9 for white king, -9 for black king
     int kingX = -1, kingY = -1;
     int colorIndex = color ? 1 : 0;
@@ -792,7 +999,9 @@ bool GameLogic::checkMate(bool color)
     if (!check(color))
         return false;
 
-    // Try every possible move to see if any can get out of check
+    // Try every possible move to see if any can get out of check. The squares come from
+    // the movement rules alone: the king's own move list tests every enemy piece against
+    // every square around it, which is far too slow to do for each piece of a position
     for (int x = 0; x < 8; x++)
     {
         for (int y = 0; y < 8; y++)
@@ -800,32 +1009,20 @@ bool GameLogic::checkMate(bool color)
             // If this is the player's piece who might be in checkmate
             if ((color && board[x][y] > 0) || (!color && board[x][y] < 0))
             {
-                // Get raw possible moves
-                vector<vector<int>> moves = possibleMoves(x, y);
-
-                // Try each move
-                for (const auto &move : moves)
+                uint64_t squares = reachableSquares(x, y);
+                for (int target = 0; target < 64; target++)
                 {
-                    int toX = move[0];
-                    int toY = move[1];
-
-                    // Save the board state
-                    int capturedPiece = board[toX][toY];
-                    int movingPiece = board[x][y];
-
-                    // Make the move
-                    board[toX][toY] = movingPiece;
-                    board[x][y] = 0;
+                    if (!(squares >> target & 1))
+                        continue;
+                    int toX = target / 8;
+                    int toY = target % 8;
 
-                    // Check if still in check
-                    bool stillInCheck = check(color);
-
-                    // Restore the board
-                    board[x][y] = movingPiece;
-                    board[toX][toY] = capturedPiece;
+                    // Castling is never a way out of check
+                    if (isCastlingMove(x, y, toX, toY))
+                        continue;
 
                     // If this move gets out of check, it's not checkmate
-                    if (!stillInCheck)
+                    if (!wouldBeInCheck(x, y, toX, toY, color))
                         return false;
                 }
             }
@@ -941,6 +1138,53 @@ bool GameLogic::moveWouldCheck(int fromX, int fromY, int toX, int toY, bool colo
     return putsInCheck;
 }
 
+void GameLogic::setPosition(const FenPosition &position)
+{
+    board = position.board;
+    reset();
+
+    whiteKingMoved = !(position.castlingRights & (Zobrist::WhiteKingside | Zobrist::WhiteQueenside));
+    whiteKingsideRookMoved = !(position.castlingRights & Zobrist::WhiteKingside);
+    whiteQueensideRookMoved = !(position.castlingRights & Zobrist::WhiteQueenside);
+    blackKingMoved = !(position.castlingRights & (Zobrist::BlackKingside | Zobrist::BlackQueenside));
+    blackKingsideRookMoved = !(position.castlingRights & Zobrist::BlackKingside);
+    blackQueensideRookMoved = !(position.castlingRights & Zobrist::BlackQueenside);
+
+    // The capture square is behind the pawn that just moved two: row 2 after a black
+    // move (White to move), row 5 after a white one
+    if (position.enPassantCol >= 0 && position.enPassantCol < 8)
+    {
+        enPassantPossible = true;
+        enPassantCol = position.enPassantCol;
+        enPassantRow = position.whiteToMove ? 2 : 5;
+    }
+
+    halfmoveClock = position.halfmoveClock;
+    fullmoveNumber = position.fullmoveNumber;
+
+    startFen = Fen::write(position);
+    if (startFen == Fen::START)
+        startFen.clear();
+}
+
+void GameLogic::getPosition(FenPosition &position, bool whiteToMove) const
+{
+    position.board = board;
+    position.whiteToMove = whiteToMove;
+    position.castlingRights = 0;
+    if (!whiteKingMoved && !whiteKingsideRookMoved)
+        position.castlingRights |= Zobrist::WhiteKingside;
+    if (!whiteKingMoved && !whiteQueensideRookMoved)
+        position.castlingRights |= Zobrist::WhiteQueenside;
+    if (!blackKingMoved && !blackKingsideRookMoved)
+        position.castlingRights |= Zobrist::BlackKingside;
+    if (!blackKingMoved && !blackQueensideRookMoved)
+        position.castlingRights |= Zobrist::BlackQueenside;
+    position.enPassantCol = enPassantPossible ? enPassantCol : -1;
+    position.halfmoveClock = halfmoveClock;
+    position.fullmoveNumber = fullmoveNumber;
+}
+
 void GameLogic::resetEnPassant()
 {
     enPassantPossible = false;
@@ -1014,11 +1258,14 @@ bool GameLogic::squaresAreNotAttacked(int startX, int endX, int y, bool color) c
     for (int x = startX; x <= endX; x++)
     {
         // Need a non-const copy of the board to modify it
+        // The king stands on this square instead of its own (castling starts from the e-file),
+        // so the check test below finds it here rather than on the square it left
         vector<vector<int>> tempBoard = board;
+        tempBoard[4][y] = 0;
         tempBoard[x][y] = color ? 9 : -9; // White or black king
 
         // Create a temporary GameLogic instance to use non-const check method
-        GameLogic tempLogic(tempBoard, const_cast<ChessBoard &>(chessBoard));
+        GameLogic tempLogic(tempBoard);
         if (tempLogic.check(color))
         {
             return false; // Square is under attack
@@ -1054,7 +1301,7 @@ bool GameLogic::canCastle(bool isWhite, bool isKingside) const
     }
 
     // Create a temporary GameLogic instance to use non-const check method
-    GameLogic tempLogic(const_cast<vector<vector<int>> &>(board), const_cast<ChessBoard &>(chessBoard));
+    GameLogic tempLogic(const_cast<vector<vector<int>> &>(board));
 
     // Check if king is in check
     if (tempLogic.check(isWhite))
@@ -1123,12 +1370,15 @@ string GameLogic::squareToAlgebraic(int x, int y) const
     return file + rank;
 }
 
-void GameLogic::addMoveToHistory(int fromX, int fromY, int toX, int toY)
+string GameLogic::moveToSan(int fromX, int fromY, int toX, int toY, int promotion)
 {
     string move;
     int piece = abs(board[fromX][fromY]);
     bool isCapture = board[toX][toY] != 0 || isEnPassantCapture(fromX, fromY, toX, toY);
 
+    if (isCastlingMove(fromX, fromY, toX, toY))
+        return toX > fromX ? "O-O" : "O-O-O";
+
     // Add piece letter for non-pawns
     if (piece != 10)
     {
@@ -1150,6 +1400,33 @@ void GameLogic::addMoveToHistory(int fromX, int fromY, int toX, int toY)
             move += "Q";
             break; // Queen
         }
+
+        // Disambiguate from other pieces of the same kind that can reach the square:
+        // by file if that is enough, else by rank, else by both
+        bool ambiguous = false, sameFile = false, sameRank = false;
+        for (int x = 0; x < 8; x++)
+        {
+            for (int y = 0; y < 8; y++)
+            {
+                if ((x == fromX && y == fromY) || board[x][y] != board[fromX][fromY])
+                    continue;
+                if (pieceCanReach(x, y, toX, toY) && !wouldBeInCheck(x, y, toX, toY, board[x][y] > 0))
+                {
+                    ambiguous = true;
+                    sameFile = sameFile || x == fromX;
+                    sameRank = sameRank || y == fromY;
+                }
+            }
+        }
+        if (ambiguous)
+        {
+            if (!sameFile)
+                move += static_cast<char>('a' + fromX);
+            else if (!sameRank)
+                move += static_cast<char>('8' - fromY);
+            else
+                move += squareToAlgebraic(fromX, fromY);
+        }
     }
 
     // Add capture symbol
@@ -1163,74 +1440,171 @@ void GameLogic::addMoveToHistory(int fromX, int fromY, int toX, int toY)
     // Add destination square
     move += squareToAlgebraic(toX, toY);
 
-    // Add to both histories
-    moveHistory.push_back(move);
-    chessBoard.addAlgebraicMove(move); // Add to ChessBoard's history
+    if (piece == 10 && (toY == 0 || toY == 7))
+    {
+        switch (promotion)
+        {
+        case 6:
+            move += "=R";
+            break;
+        case 7:
+            move += "=B";
+            break;
+        case 8:
+            move += "=N";
+            break;
+        default:
+            move += "=Q";
+            break;
+        }
+    }
+
+    return move;
+}
+
+void GameLogic::writePGN(string &out, const string &date) const
+{
+    PgnSerializer::writeGame(out, date, moveHistory, gameResult, startFen);
 }
 
 string GameLogic::generatePGN() const
 {
-    // Get current date in YYYY.MM.DD format
-    time_t now = time(0);
-    tm *ltm = localtime(&now);
-    string date = to_string(1900 + ltm->tm_year) + "." +
-                  (ltm->tm_mon + 1 < 10 ? "0" : "") + to_string(ltm->tm_mon + 1) + "." +
-                  (ltm->tm_mday < 10 ? "0" : "") + to_string(ltm->tm_mday);
-
-    // Determine the result based on the game state
-    string result = "*";
-    if (!moveHistory.empty())
+    string pgn;
+    writePGN(pgn, PgnSerializer::today());
+    return pgn;
+}
+
+int GameLogic::sanPromotion(const string &san)
+{
+    // The letter after "=", or a bare piece letter right after the rank ("e8Q")
+    size_t end = san.find_last_not_of("+#!?");
+    if (end == string::npos || end < 2)
+        return 0;
+
+    char letter = 0;
+    if (san[end - 1] == '=')
+        letter = static_cast<char>(toupper(san[end]));
+    else if (isdigit(san[end - 1]) && isupper(san[end]))
+        letter = san[end];
+
+    switch (letter)
     {
-        // Create a temporary GameLogic to check the game state
-        GameLogic tempLogic(const_cast<vector<vector<int>> &>(board), const_cast<ChessBoard &>(chessBoard));
+    case 'Q':
+        return 11;
+    case 'R':
+        return 6;
+    case 'B':
+        return 7;
+    case 'N':
+        return 8;
+    default:
+        return 0;
+    }
+}
 
-        if (tempLogic.checkMate(true))
-        {
-            result = "0-1"; // Black wins
-        }
-        else if (tempLogic.checkMate(false))
-        {
-            result = "1-0"; // White wins
-        }
-        // Note: We're not checking for stalemate since the method isn't implemented
+bool GameLogic::sanToMove(const string &san, bool color, int &fromX, int &fromY, int &toX, int &toY)
+{
+    // Strip check, mate and annotation marks
+    string move = san;
+    while (!move.empty() && (move.back() == '+' || move.back() == '#' || move.back() == '!' || move.back() == '?'))
+    {
+        move.pop_back();
     }
 
-    // Create PGN header
-    string pgn = "[Event \"Chess Game\"]\n";
-    pgn += "[Site \"Local Game\"]\n";
-    pgn += "[Date \"" + date + "\"]\n";
-    pgn += "[Round \"1\"]\n";
-    pgn += "[White \"Player 1\"]\n";
-    pgn += "[Black \"Player 2\"]\n";
-    pgn += "[Result \"" + result + "\"]\n\n";
+    int homeRow = color ? 7 : 0;
 
-    // Add moves with proper formatting
-    int lineLength = 0;
-    for (size_t i = 0; i < moveHistory.size(); i++)
+    // Castling
+    if (move == "O-O" || move == "0-0" || move == "O-O-O" || move == "0-0-0")
     {
-        string moveText;
-        if (i % 2 == 0)
-        {
-            moveText = to_string(i / 2 + 1) + ". " + moveHistory[i] + " ";
-        }
-        else
-        {
-            moveText = moveHistory[i] + " ";
-        }
+        fromX = 4;
+        fromY = homeRow;
+        toX = move.length() == 3 ? 6 : 2;
+        toY = homeRow;
+        return board[fromX][fromY] == (color ? 9 : -9) && canCastle(color, toX == 6);
+    }
+
+    // Promotion suffix ("=Q" or a bare "Q" after the rank); sanPromotion tells which piece
+    size_t promotion = move.find('=');
+    if (promotion != string::npos)
+    {
+        if (sanPromotion(move) == 0)
+            return false; // "=K" or nothing after the "="
+        move = move.substr(0, promotion);
+    }
+    else if (move.length() > 2 && isdigit(move[move.length() - 2]) && isupper(move.back()))
+    {
+        move.pop_back();
+    }
 
-        // Handle line wrapping for better readability
-        if (lineLength + moveText.length() > 80)
+    // Moving piece type
+    int pieceType = 10; // Pawn
+    size_t start = 0;
+    if (!move.empty() && isupper(move[0]))
+    {
+        switch (move[0])
         {
-            pgn += "\n";
-            lineLength = 0;
+        case 'K':
+            pieceType = 9;
+            break;
+        case 'Q':
+            pieceType = 11;
+            break;
+        case 'R':
+            pieceType = 6;
+            break;
+        case 'B':
+            pieceType = 7;
+            break;
+        case 'N':
+            pieceType = 8;
+            break;
+        default:
+            return false;
         }
+        start = 1;
+    }
+
+    // Destination square is always the last two characters
+    if (move.length() < start + 2)
+        return false;
+    toX = move[move.length() - 2] - 'a';
+    toY = '8' - move[move.length() - 1];
+    if (toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+        return false;
 
-        pgn += moveText;
-        lineLength += moveText.length();
+    // Optional disambiguation between the piece letter and the destination
+    int fromFile = -1, fromRank = -1;
+    for (size_t i = start; i < move.length() - 2; i++)
+    {
+        if (move[i] >= 'a' && move[i] <= 'h')
+            fromFile = move[i] - 'a';
+        else if (move[i] >= '1' && move[i] <= '8')
+            fromRank = '8' - move[i];
+        else if (move[i] != 'x' && move[i] != '-')
+            return false;
     }
 
-    // Add result at the end
-    pgn += result;
+    int pieceValue = color ? pieceType : -pieceType;
+    for (int x = 0; x < 8; x++)
+    {
+        if (fromFile != -1 && x != fromFile)
+            continue;
+        for (int y = 0; y < 8; y++)
+        {
+            if (fromRank != -1 && y != fromRank)
+                continue;
+            // Without disambiguation the first legal candidate wins, which is what
+            // games saved before SAN disambiguation existed relied on. The movement
+            // test comes first: it rules out almost every piece without trying the move
+            if (board[x][y] == pieceValue && pieceCanReach(x, y, toX, toY) &&
+                !wouldBeInCheck(x, y, toX, toY, color))
+            {
+                fromX = x;
+                fromY = y;
+                return true;
+            }
+        }
+    }
 
-    return pgn;
-}
\ No newline at end of file
+    return false;
+}
@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
+#include "Fen.h"
 #include <SFML/Graphics.hpp>
 
 using namespace std;
@@ -12,12 +14,12 @@ class GameLogic
 {
 private:
     vector<vector<int>> &board;
-    ChessBoard &chessBoard;
+    ChessBoard *chessBoard;  // Null when only the rules are needed (analysis and import tools)
     int enPassantCol;        // Column of pawn that just moved two squares
     int enPassantRow;        // Row where the capturing pawn would end up
     bool enPassantPossible;  // Flag indicating if en passant is possible this turn
-    static int lastKingX[2]; // Cached king X positions [0] for black, [1] for white
-    static int lastKingY[2]; // Cached king Y positions [0] for black, [1] for white
+    int lastKingX[2];        // Cached king X positions [0] for black, [1] for white
+    int lastKingY[2];        // Cached king Y positions [0] for black, [1] for white
 
     // Track piece movement for castling
     bool whiteKingMoved;          // Has white king moved?
@@ -27,22 +29,33 @@ private:
     bool blackQueensideRookMoved; // Has black queenside rook moved?
     bool blackKingsideRookMoved;  // Has black kingside rook moved?
 
+    int halfmoveClock;  // Plies since the last capture or pawn move
+    int fullmoveNumber; // Goes up after each black move
+    string startFen;    // The position setPosition set up, empty for the standard start
+
     vector<string> moveHistory; // Store moves in algebraic notation
+    string gameResult;          // "1-0" or "0-1" once a move has mated, "*" until then
 
     // Helper methods for castling
     bool canCastle(bool isWhite, bool isKingside) const;
     bool squaresAreEmpty(int startX, int endX, int y) const;
     bool squaresAreNotAttacked(int startX, int endX, int y, bool color) const;
 
+    // Whether the piece on (x, y) moves to (toX, toY) by its movement rules, ignoring
+    // checks and castling: possibleMoves for one square, without building the list
+    bool pieceCanReach(int x, int y, int toX, int toY) const;
+
 public:
     GameLogic(vector<vector<int>> &boardRef, ChessBoard &chessBoardRef);
+    explicit GameLogic(vector<vector<int>> &boardRef); // Rules only: no sprites, sounds or ChessBoard history
     void reset(); // Reset all game logic state
     bool isWhite(int x, int y) const;
     bool isBlack(int x, int y) const;
     string whatPiece(int x, int y);
     vector<vector<int>> possibleMoves(int x, int y);
     vector<vector<int>> getAllMoves(bool color);
-    void movePiece(int x, int y, int xx, int yy);
+    void movePiece(int x, int y, int xx, int yy, int promotion = 11);
+    void playMove(int x, int y, int xx, int yy, int promotion = 11); // Board and rule state only: no SAN, history, sound or animation
     bool check(bool color);
     bool checkMate(bool color);
     bool checkStaleMate(bool color);
@@ -53,8 +66,35 @@ public:
     bool isEnPassantCapture(int fromX, int fromY, int toX, int toY) const;
     bool isCastlingMove(int fromX, int fromY, int toX, int toY) const;
 
+    // Set up a position, or read the current one, in FEN terms. Castling rights map
+    // onto the *KingMoved / *RookMoved flags: a right that is off reads as a moved
+    // king or rook. setPosition copies the board and clears the move history; the
+    // side to move is kept by the caller
+    void setPosition(const FenPosition &position);
+    void getPosition(FenPosition &position, bool whiteToMove) const;
+    const string &getStartFen() const { return startFen; }
+
+    // Every square the piece on (x, y) can move to by its movement rules, as bits x * 8 + y.
+    // Checks are not tested; castling is included when the king and rook haven't moved and
+    // the squares between them are empty
+    uint64_t reachableSquares(int x, int y) const;
+
     // New methods for PGN generation
-    void addMoveToHistory(int fromX, int fromY, int toX, int toY);
+    // SAN of a move in the current position (disambiguation, captures, O-O, =Q); movePiece
+    // adds "+" or "#" after making it, since that depends on the position afterwards.
+    // promotion is the piece type a pawn reaching the last rank becomes (11 queen by default)
+    string moveToSan(int fromX, int fromY, int toX, int toY, int promotion = 11);
+    const string &getResult() const { return gameResult; }
+    const vector<string> &getMoveHistory() const { return moveHistory; }
+    void writePGN(string &out, const string &date) const; // Reuses out's capacity
     string generatePGN() const;
     string squareToAlgebraic(int x, int y) const;
+
+    // Resolve a SAN move (e.g. "Nbd7", "exd5", "O-O", "e8=Q+") for the given side.
+    // Also accepts the older notation this game wrote ("Kg1" for castling, "e8" for promotion)
+    bool sanToMove(const string &san, bool color, int &fromX, int &fromY, int &toX, int &toY);
+
+    // The piece type a SAN move promotes to (11 queen, 6 rook, 7 bishop, 8 knight), 0 if it
+    // names none; replaying a game passes it on to playMove
+    static int sanPromotion(const string &san);
 };
\ No newline at end of file
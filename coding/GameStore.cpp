@@ -0,0 +1,771 @@
+#include "GameStore.h"
+#include "PgnImporter.h"
+#include "PgnSerializer.h"
+#include "Zobrist.h"
+#include "Fen.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+
+static const char DATA_MAGIC[4] = {'C', 'G', 'D', '1'};
+static const char INDEX_MAGIC[8] = {'C', 'G', 'I', '1', 0, 0, 0, 0}; // Padded so the offsets are 8-byte aligned
+static const char *RESULTS[] = {"*", "1-0", "0-1", "1/2-1/2"};
+static const size_t MAX_PLIES = 0xFFFF;
+static const int PROMOTIONS[4] = {11, 6, 7, 8}; // The order a promoting pawn's numbers run in
+
+// Spreads bits 0-7 of a byte to squares 0, 8, ..., 56, and gathers them back
+static const uint64_t FIRST_SQUARES = 0x0101010101010101ULL;
+static const uint64_t GATHER = 0x0102040810204080ULL;
+
+// Target squares from every square on an empty board, and what slides along a line.
+// Squares are x * 8 + y, so the line through a square along y is one byte; the other
+// lines are gathered into a byte by multiplying, looked up, and spread back.
+struct MoveTables
+{
+    uint64_t knight[64];
+    uint64_t king[64];
+    uint64_t diagonal[64];     // The x - y diagonal through the square, without it
+    uint64_t antiDiagonal[64]; // The x + y diagonal through the square, without it
+    uint64_t spread[256];      // Bit k of the index on square k * 8
+    uint8_t line[8][64];       // From slot p of an 8-square line, by the inner six squares' occupancy
+
+    MoveTables()
+    {
+        int knightMoves[8][2] = {{2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2}};
+        for (int square = 0; square < 64; square++)
+        {
+            int x = square / 8;
+            int y = square % 8;
+            knight[square] = king[square] = diagonal[square] = antiDiagonal[square] = 0;
+            for (auto move : knightMoves)
+            {
+                if (x + move[0] >= 0 && x + move[0] < 8 && y + move[1] >= 0 && y + move[1] < 8)
+                    knight[square] |= 1ULL << ((x + move[0]) * 8 + y + move[1]);
+            }
+            for (int toX = 0; toX < 8; toX++)
+            {
+                for (int toY = 0; toY < 8; toY++)
+                {
+                    uint64_t bit = 1ULL << (toX * 8 + toY);
+                    if (toX == x && toY == y)
+                        continue;
+                    if (abs(toX - x) <= 1 && abs(toY - y) <= 1)
+                        king[square] |= bit;
+                    if (toX - toY == x - y)
+                        diagonal[square] |= bit;
+                    if (toX + toY == x + y)
+                        antiDiagonal[square] |= bit;
+                }
+            }
+        }
+        for (int bits = 0; bits < 256; bits++)
+        {
+            spread[bits] = 0;
+            for (int k = 0; k < 8; k++)
+            {
+                if (bits >> k & 1)
+                    spread[bits] |= 1ULL << (k * 8);
+            }
+        }
+        for (int slot = 0; slot < 8; slot++)
+        {
+            for (int inner = 0; inner < 64; inner++)
+            {
+                int occupied = inner << 1;
+                int reached = 0;
+                for (int to = slot + 1; to < 8; to++)
+                {
+                    reached |= 1 << to;
+                    if (occupied >> to & 1)
+                        break;
+                }
+                for (int to = slot - 1; to >= 0; to--)
+                {
+                    reached |= 1 << to;
+                    if (occupied >> to & 1)
+                        break;
+                }
+                line[slot][inner] = static_cast<uint8_t>(reached);
+            }
+        }
+    }
+};
+
+static const MoveTables moveTables; // Built before main, so lookups need no first-use check
+
+// Helper function for the squares a slider reaches along a diagonal mask; the
+// diagonal has one square per x, each with its own y, so adding up the bytes
+// lines its occupancy up by y
+static inline uint64_t diagonalTargets(uint64_t mask, int y, uint64_t all)
+{
+    uint64_t inner = ((all & mask) * FIRST_SQUARES) >> 57 & 63;
+    return (moveTables.line[y][inner] * FIRST_SQUARES) & mask;
+}
+
+// Helper function to count the squares in a set; a builtin would be a library call
+// without a popcount instruction enabled, so the bits are summed in parallel here
+static inline int countSquares(uint64_t squares)
+{
+    squares -= (squares >> 1) & 0x5555555555555555ULL;
+    squares = (squares & 0x3333333333333333ULL) + ((squares >> 2) & 0x3333333333333333ULL);
+    squares = (squares + (squares >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((squares * 0x0101010101010101ULL) >> 56);
+}
+
+// Helper function to find the lowest square in a non-empty set
+static inline int lowestSquare(uint64_t squares)
+{
+#ifdef __GNUC__
+    return __builtin_ctzll(squares);
+#else
+    int square = 0;
+    for (; !(squares & 1); squares >>= 1)
+        square++;
+    return square;
+#endif
+}
+
+void StoredPosition::setPosition(const FenPosition &position)
+{
+    occupied[0] = occupied[1] = 0;
+    for (int square = 0; square < 64; square++)
+    {
+        squares[square] = static_cast<signed char>(position.board[square / 8][square % 8]);
+        if (squares[square] != 0)
+            occupied[squares[square] > 0] |= 1ULL << square;
+    }
+    castlingRights = position.castlingRights;
+    // The square the pawn passed over: row 2 if White is to move, row 5 if Black is
+    enPassantSquare = position.enPassantCol < 0 ? -1 : position.enPassantCol * 8 + (position.whiteToMove ? 2 : 5);
+    whiteToMove = position.whiteToMove;
+}
+
+// Helper function to build the start position once, from the board's own setup
+static StoredPosition startPosition()
+{
+    StoredPosition position;
+    position.setPosition(FenPosition());
+    return position;
+}
+
+void StoredPosition::setStart()
+{
+    static const StoredPosition start = startPosition();
+    *this = start;
+}
+
+bool StoredPosition::setStart(const PgnGame &game)
+{
+    const string *fen = game.tag("FEN");
+    if (!fen)
+    {
+        setStart();
+        return true;
+    }
+    FenPosition position;
+    string error;
+    if (!Fen::parse(*fen, position, error))
+    {
+        setStart();
+        return false;
+    }
+    setPosition(position);
+    return true;
+}
+
+uint64_t StoredPosition::targets(int from) const
+{
+    int piece = squares[from];
+    bool white = piece > 0;
+    uint64_t own = occupied[white];
+    uint64_t all = occupied[0] | occupied[1];
+
+    switch (piece > 0 ? piece : -piece)
+    {
+    case 10: // Pawn
+    {
+        int forward = white ? -1 : 1; // Along y, one square in the index
+        int x = from / 8;
+        int y = from % 8;
+        uint64_t result = 0;
+        int ahead = from + forward;
+        if (!(all >> ahead & 1))
+        {
+            result |= 1ULL << ahead;
+            if (y == (white ? 6 : 1) && !(all >> (ahead + forward) & 1))
+                result |= 1ULL << (ahead + forward);
+        }
+        for (int side = -1; side <= 1; side += 2)
+        {
+            if (x + side < 0 || x + side >= 8)
+                continue;
+            int capture = ahead + side * 8;
+            if ((occupied[!white] >> capture & 1) || capture == enPassantSquare)
+                result |= 1ULL << capture;
+        }
+        return result;
+    }
+    case 8: // Knight
+        return moveTables.knight[from] & ~own;
+    case 9: // King
+    {
+        uint64_t result = moveTables.king[from] & ~own;
+        int homeRow = white ? 7 : 0;
+        int rook = white ? 6 : -6;
+        int kingside = white ? Zobrist::WhiteKingside : Zobrist::BlackKingside;
+        int queenside = white ? Zobrist::WhiteQueenside : Zobrist::BlackQueenside;
+        if (from == 4 * 8 + homeRow)
+        {
+            if ((castlingRights & kingside) && squares[7 * 8 + homeRow] == rook &&
+                !(all >> (5 * 8 + homeRow) & 1) && !(all >> (6 * 8 + homeRow) & 1))
+                result |= 1ULL << (6 * 8 + homeRow);
+            if ((castlingRights & queenside) && squares[homeRow] == rook && !(all >> (8 + homeRow) & 1) &&
+                !(all >> (2 * 8 + homeRow) & 1) && !(all >> (3 * 8 + homeRow) & 1))
+                result |= 1ULL << (2 * 8 + homeRow);
+        }
+        return result;
+    }
+    default: // Rook, bishop, queen: along each line up to and including the first piece
+    {
+        int x = from / 8;
+        int y = from % 8;
+        uint64_t result = 0;
+        if (piece != 7 && piece != -7)
+        {
+            result |= static_cast<uint64_t>(moveTables.line[y][all >> (x * 8 + 1) & 63]) << (x * 8);
+            uint64_t row = ((all >> y & FIRST_SQUARES) * GATHER) >> 57 & 63;
+            result |= moveTables.spread[moveTables.line[x][row]] << y;
+        }
+        if (piece != 6 && piece != -6)
+        {
+            result |= diagonalTargets(moveTables.diagonal[from], y, all);
+            result |= diagonalTargets(moveTables.antiDiagonal[from], y, all);
+        }
+        return result & ~own;
+    }
+    }
+}
+
+void StoredPosition::play(int from, int to, int promotion)
+{
+    int piece = squares[from];
+    bool white = piece > 0;
+    int type = piece > 0 ? piece : -piece;
+    int fromX = from / 8;
+    int toX = to / 8;
+    int toY = to % 8;
+
+    // Remove whatever is captured; en passant takes the pawn beside the target square
+    int captured = to;
+    if (type == 10 && to == enPassantSquare && squares[to] == 0)
+        captured = toX * 8 + from % 8;
+    if (squares[captured] != 0)
+    {
+        occupied[!white] &= ~(1ULL << captured);
+        squares[captured] = 0;
+    }
+
+    // Castling moves the rook too
+    if (type == 9 && (toX - fromX == 2 || fromX - toX == 2))
+    {
+        int rookFrom = (toX > fromX ? 7 : 0) * 8 + toY;
+        int rookTo = (toX > fromX ? 5 : 3) * 8 + toY;
+        squares[rookTo] = squares[rookFrom];
+        squares[rookFrom] = 0;
+        occupied[white] ^= (1ULL << rookFrom) | (1ULL << rookTo);
+    }
+
+    if (type == 10 && (toY == 0 || toY == 7))
+        piece = white ? promotion : -promotion;
+
+    squares[to] = static_cast<signed char>(piece);
+    squares[from] = 0;
+    occupied[white] ^= (1ULL << from) | (1ULL << to);
+
+    // Any move touching a king or rook home square removes the matching rights
+    for (int square : {from, to})
+    {
+        if (square == 4 * 8 + 7)
+            castlingRights &= ~(Zobrist::WhiteKingside | Zobrist::WhiteQueenside);
+        else if (square == 7 * 8 + 7)
+            castlingRights &= ~Zobrist::WhiteKingside;
+        else if (square == 7)
+            castlingRights &= ~Zobrist::WhiteQueenside;
+        else if (square == 4 * 8)
+            castlingRights &= ~(Zobrist::BlackKingside | Zobrist::BlackQueenside);
+        else if (square == 7 * 8)
+            castlingRights &= ~Zobrist::BlackKingside;
+        else if (square == 0)
+            castlingRights &= ~Zobrist::BlackQueenside;
+    }
+
+    enPassantSquare = type == 10 && (to - from == 2 || from - to == 2) ? (from + to) / 2 : -1;
+    whiteToMove = !whiteToMove;
+}
+
+void StoredPosition::toBoard(vector<vector<int>> &board) const
+{
+    board.assign(8, vector<int>(8, 0));
+    for (int square = 0; square < 64; square++)
+    {
+        board[square / 8][square % 8] = squares[square];
+    }
+}
+
+uint64_t StoredPosition::key() const
+{
+    uint64_t hash = Zobrist::stateKey(whiteToMove, castlingRights, enPassantSquare < 0 ? -1 : enPassantSquare / 8);
+    for (uint64_t pieces = occupied[0] | occupied[1]; pieces; pieces &= pieces - 1)
+    {
+        int square = lowestSquare(pieces);
+        hash ^= Zobrist::pieceKey(squares[square], square / 8, square % 8);
+    }
+    return hash;
+}
+
+// Helper function to tell how many numbers each of a piece's targets takes: four for a
+// pawn about to promote (one per piece it can become), one for anything else
+static int movesPerTarget(const StoredPosition &position, int square)
+{
+    int piece = position.squares[square];
+    return (piece == 10 && square % 8 == 1) || (piece == -10 && square % 8 == 6) ? 4 : 1;
+}
+
+// Helper function to number a move among every move the side to move's pieces could make
+static bool encodeMove(const StoredPosition &position, int from, int to, int promotion, unsigned char &number)
+{
+    int count = 0;
+    for (uint64_t pieces = position.occupied[position.whiteToMove]; pieces; pieces &= pieces - 1)
+    {
+        int square = lowestSquare(pieces);
+        uint64_t targets = position.targets(square);
+        int perTarget = movesPerTarget(position, square);
+        if (square == from)
+        {
+            count += countSquares(targets & ((1ULL << to) - 1)) * perTarget;
+            if (perTarget == 4)
+            {
+                int i = 0;
+                while (i < 3 && PROMOTIONS[i] != promotion)
+                    i++;
+                count += i;
+            }
+            if (!(targets >> to & 1) || count > 255)
+                return false;
+            number = static_cast<unsigned char>(count);
+            return true;
+        }
+        count += countSquares(targets) * perTarget;
+    }
+    return false;
+}
+
+// Helper function to turn a move number back into the move; promotion is 0 unless a pawn promotes
+static bool decodeMove(const StoredPosition &position, int number, int &from, int &to, int &promotion)
+{
+    for (uint64_t pieces = position.occupied[position.whiteToMove]; pieces; pieces &= pieces - 1)
+    {
+        int square = lowestSquare(pieces);
+        uint64_t targets = position.targets(square);
+        int perTarget = movesPerTarget(position, square);
+        int count = countSquares(targets) * perTarget;
+        if (number >= count)
+        {
+            number -= count;
+            continue;
+        }
+        promotion = perTarget == 4 ? PROMOTIONS[number % 4] : 0;
+        for (number /= perTarget; number > 0; number--)
+            targets &= targets - 1;
+        from = square;
+        to = lowestSquare(targets);
+        return true;
+    }
+    return false;
+}
+
+// Helper function to append a value in the file's byte order
+template <typename T>
+static void appendValue(string &out, T value)
+{
+    out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+// Helper function to read a value from a record, checking it is all there
+template <typename T>
+static bool takeValue(const char *&p, const char *end, T &value)
+{
+    if (static_cast<size_t>(end - p) < sizeof(T))
+        return false;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+GameStoreWriter::GameStoreWriter() : data(nullptr), written(0)
+{
+}
+
+GameStoreWriter::~GameStoreWriter()
+{
+    if (data)
+        close();
+}
+
+bool GameStoreWriter::open(const string &path)
+{
+    if (data)
+        close();
+    this->path = path;
+    offsets.clear();
+    data = fopen(path.c_str(), "wb");
+    if (!data || fwrite(DATA_MAGIC, 1, sizeof(DATA_MAGIC), data) != sizeof(DATA_MAGIC))
+    {
+        cerr << "Could not write game store: " << path << endl;
+        return false;
+    }
+    written = sizeof(DATA_MAGIC);
+    return true;
+}
+
+bool GameStoreWriter::addGame(const PgnGame &game)
+{
+    if (!data)
+        return false;
+
+    record.clear();
+    bool complete = GameStore::appendRecord(record, game, position);
+    if (fwrite(record.data(), 1, record.size(), data) != record.size())
+    {
+        cerr << "Could not write game store: " << path << endl;
+        return false;
+    }
+    offsets.push_back(written);
+    written += record.size();
+    return complete;
+}
+
+bool GameStoreWriter::close()
+{
+    if (!data)
+        return false;
+    bool ok = fclose(data) == 0;
+    data = nullptr;
+
+    string indexPath = path + ".idx";
+    FILE *index = fopen(indexPath.c_str(), "wb");
+    uint64_t count = offsets.size();
+    offsets.push_back(written); // The end of the last record
+    ok = index && ok && fwrite(INDEX_MAGIC, 1, sizeof(INDEX_MAGIC), index) == sizeof(INDEX_MAGIC) &&
+         fwrite(&count, sizeof(count), 1, index) == 1 &&
+         fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), index) == offsets.size();
+    offsets.pop_back();
+    if (index)
+        ok = fclose(index) == 0 && ok;
+    if (!ok)
+        cerr << "Could not write game store index: " << indexPath << endl;
+    return ok;
+}
+
+GameStore::GameStore() : gameCount(0), offsets(nullptr)
+{
+    position.setStart();
+}
+
+bool GameStore::open(const string &path)
+{
+    gameCount = 0;
+    offsets = nullptr;
+    string indexPath = path + ".idx";
+    if (!data.open(path) || !index.open(indexPath))
+    {
+        cerr << "Could not open game store: " << path << endl;
+        return false;
+    }
+
+    // Both files must be whole and agree with each other
+    uint64_t count = 0;
+    size_t header = sizeof(INDEX_MAGIC) + sizeof(count);
+    bool valid = data.size() >= sizeof(DATA_MAGIC) && memcmp(data.data(), DATA_MAGIC, sizeof(DATA_MAGIC)) == 0 &&
+                 index.size() >= header && memcmp(index.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+    if (valid)
+    {
+        memcpy(&count, index.data() + sizeof(INDEX_MAGIC), sizeof(count));
+        const uint64_t *table = reinterpret_cast<const uint64_t *>(index.data() + header);
+        valid = (index.size() - header) / sizeof(uint64_t) == count + 1 && table[count] == data.size();
+        if (valid)
+        {
+            offsets = table;
+            gameCount = static_cast<size_t>(count);
+        }
+    }
+    if (!valid)
+    {
+        cerr << "Game store is damaged or incomplete: " << path << endl;
+        data.close();
+        index.close();
+        return false;
+    }
+    return true;
+}
+
+bool GameStore::readGame(size_t n, PgnGame &game)
+{
+    if (n >= gameCount || offsets[n] > offsets[n + 1] || offsets[n + 1] > data.size())
+        return false;
+    const char *p = data.data() + offsets[n];
+    const char *end = data.data() + offsets[n + 1];
+    game.number = n + 1;
+    return readRecord(p, end, game, position) && p == end;
+}
+
+bool GameStore::appendRecord(string &out, const PgnGame &game, StoredPosition &position)
+{
+    size_t tagCount = min<size_t>(game.tagCount, 255);
+    appendValue(out, static_cast<uint8_t>(tagCount));
+    for (size_t i = 0; i < tagCount; i++)
+    {
+        const string &name = game.tags[i].first;
+        const string &value = game.tags[i].second;
+        appendValue(out, static_cast<uint8_t>(min<size_t>(name.size(), 255)));
+        out.append(name, 0, 255);
+        appendValue(out, static_cast<uint16_t>(min<size_t>(value.size(), 0xFFFF)));
+        out.append(value, 0, 0xFFFF);
+    }
+    uint8_t result = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (game.result == RESULTS[i])
+            result = i;
+    }
+    appendValue(out, result);
+
+    // Number every move on the position it was played in
+    size_t countAt = out.size();
+    appendValue(out, static_cast<uint16_t>(0));
+    bool complete = position.setStart(game); // A malformed FEN tag leaves the game without moves
+    size_t plies = 0;
+    for (size_t i = 0; i < game.moves.size() && complete; i++)
+    {
+        const PgnMove &move = game.moves[i];
+        unsigned char number;
+        int from = move.fromX * 8 + move.fromY;
+        int to = move.toX * 8 + move.toY;
+        int promotion = move.promotion != 0 ? move.promotion : 11;
+        if (plies == MAX_PLIES || !encodeMove(position, from, to, promotion, number))
+        {
+            complete = false;
+            break;
+        }
+        out += static_cast<char>(number);
+        position.play(from, to, promotion);
+        plies++;
+    }
+    uint16_t storedPlies = static_cast<uint16_t>(plies);
+    memcpy(&out[countAt], &storedPlies, sizeof(storedPlies));
+    return complete;
+}
+
+bool GameStore::readRecord(const char *&p, const char *end, PgnGame &game, StoredPosition &position)
+{
+    game.error.clear();
+    game.moves.clear();
+
+    uint8_t tagCount;
+    if (!takeValue(p, end, tagCount))
+        return false;
+    game.tagCount = 0;
+    for (size_t i = 0; i < tagCount; i++)
+    {
+        uint8_t nameLength;
+        uint16_t valueLength;
+        if (!takeValue(p, end, nameLength) || static_cast<size_t>(end - p) < nameLength)
+            return false;
+        if (game.tagCount == game.tags.size())
+            game.tags.emplace_back();
+        pair<string, string> &tag = game.tags[game.tagCount++];
+        tag.first.assign(p, nameLength);
+        p += nameLength;
+        if (!takeValue(p, end, valueLength) || static_cast<size_t>(end - p) < valueLength)
+            return false;
+        tag.second.assign(p, valueLength);
+        p += valueLength;
+    }
+
+    uint8_t result;
+    uint16_t plies;
+    if (!takeValue(p, end, result) || result > 3 || !takeValue(p, end, plies) ||
+        static_cast<size_t>(end - p) < plies)
+        return false;
+    game.result = RESULTS[result];
+
+    if (!position.setStart(game) && plies > 0)
+    {
+        game.error = "bad FEN tag";
+        return false;
+    }
+    for (size_t i = 0; i < plies; i++)
+    {
+        int from, to, promotion;
+        if (!decodeMove(position, static_cast<unsigned char>(p[i]), from, to, promotion))
+        {
+            game.error = "stored move " + to_string(i + 1) + " is not on the board";
+            return false;
+        }
+        PgnMove move;
+        move.fromX = static_cast<signed char>(from / 8);
+        move.fromY = static_cast<signed char>(from % 8);
+        move.toX = static_cast<signed char>(to / 8);
+        move.toY = static_cast<signed char>(to % 8);
+        move.promotion = static_cast<signed char>(promotion);
+        game.moves.push_back(move);
+        position.play(from, to, promotion != 0 ? promotion : 11);
+    }
+    p += plies;
+    return true;
+}
+
+bool GameStore::skipRecord(const char *&p, const char *end)
+{
+    uint8_t tagCount;
+    if (!takeValue(p, end, tagCount))
+        return false;
+    for (size_t i = 0; i < tagCount; i++)
+    {
+        uint8_t nameLength;
+        uint16_t valueLength;
+        if (!takeValue(p, end, nameLength) || static_cast<size_t>(end - p) < nameLength)
+            return false;
+        p += nameLength;
+        if (!takeValue(p, end, valueLength) || static_cast<size_t>(end - p) < valueLength)
+            return false;
+        p += valueLength;
+    }
+    uint8_t result;
+    uint16_t plies;
+    if (!takeValue(p, end, result) || !takeValue(p, end, plies) || static_cast<size_t>(end - p) < plies)
+        return false;
+    p += plies;
+    return true;
+}
+
+StoredGamePgn::StoredGamePgn() : logic(board)
+{
+    Zobrist::setStartPosition(startBoard);
+    board = startBoard;
+}
+
+void StoredGamePgn::append(string &out, const PgnGame &game)
+{
+    board = startBoard;
+    logic.reset();
+    const string *fen = game.tag("FEN");
+    if (fen && Fen::parse(*fen, fenPosition, error))
+        logic.setPosition(fenPosition);
+    for (const PgnMove &move : game.moves)
+    {
+        logic.movePiece(move.fromX, move.fromY, move.toX, move.toY, move.promotion != 0 ? move.promotion : 11);
+    }
+
+    for (size_t i = 0; i < game.tagCount; i++)
+    {
+        PgnSerializer::appendTag(out, game.tags[i].first, game.tags[i].second);
+    }
+    out += '\n';
+    size_t lineLength = 0;
+    const vector<string> &moves = logic.getMoveHistory();
+    size_t firstPly = PgnSerializer::firstPly(logic.getStartFen());
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        PgnSerializer::appendMove(out, firstPly + i, moves[i], lineLength, i == 0);
+    }
+    out += game.result;
+    out += "\n\n";
+}
+
+int GameStore::runCommandLine(int argc, char *argv[])
+{
+    int threads = 0;
+    vector<string> files;
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            cerr << "Unknown store option: " << arg << endl;
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+    if (files.size() != 2)
+    {
+        cerr << "Usage: --store [--threads N] in.pgn out.cgd | --store in.cgd out.pgn" << endl;
+        return 1;
+    }
+    const string &in = files[0];
+    const string &out = files[1];
+    auto start = chrono::steady_clock::now();
+
+    if (in.size() > 4 && in.compare(in.size() - 4, 4, ".pgn") == 0)
+    {
+        // PGN to binary: games are parsed on every core and stored in file order
+        GameStoreWriter writer;
+        if (!writer.open(out))
+            return 1;
+        size_t shortened = 0;
+        auto store = [&](const PgnGame &game)
+        {
+            if (!writer.addGame(game) || !game.error.empty())
+                shortened++;
+        };
+        PgnImporter importer(threads);
+        bool ok = importer.importFile(in, store);
+        ok = writer.close() && ok;
+        importer.printStats(cout);
+        cout << writer.getGameCount() << " games stored in " << out << ", " << shortened
+             << " of them cut short at a move that could not be read or stored" << endl;
+        return ok ? 0 : 1;
+    }
+
+    // Binary to PGN
+    GameStore store;
+    if (!store.open(in))
+        return 1;
+    FILE *pgn = fopen(out.c_str(), "wb");
+    if (!pgn)
+    {
+        cerr << "Could not write PGN file: " << out << endl;
+        return 1;
+    }
+    PgnGame game;
+    game.tagCount = 0;
+    StoredGamePgn pgnText;
+    string text;
+    bool ok = true;
+    for (size_t n = 0; n < store.getGameCount() && ok; n++)
+    {
+        if (!store.readGame(n, game))
+        {
+            cerr << in << " game " << n + 1 << " could not be read" << (game.error.empty() ? "" : ": ") << game.error << endl;
+            continue;
+        }
+        text.clear();
+        pgnText.append(text, game);
+        ok = fwrite(text.data(), 1, text.size(), pgn) == text.size();
+    }
+    ok = fclose(pgn) == 0 && ok;
+    if (!ok)
+    {
+        cerr << "Could not write PGN file: " << out << endl;
+        return 1;
+    }
+    cout << store.getGameCount() << " games written to " << out << " in "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+    return 0;
+}
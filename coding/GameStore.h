@@ -0,0 +1,136 @@
+#ifndef GAMESTORE_H
+#define GAMESTORE_H
+
+#include "PgnParser.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The position while stored games are numbered and replayed. Squares are x * 8 + y
+// as in GameLogic::reachableSquares, with the same piece values as the board; one
+// bitboard per side lets each piece's moves be counted without walking the board.
+struct StoredPosition
+{
+    signed char squares[64];
+    uint64_t occupied[2]; // [0] black, [1] white
+    int castlingRights;   // Zobrist castling bits
+    int enPassantSquare;  // Where a pawn can capture en passant, -1 if nowhere
+    bool whiteToMove;
+
+    void setStart();
+    void setPosition(const FenPosition &position);
+
+    // Where the game starts: its FEN tag, or the standard start if it has none.
+    // False, leaving the standard start, if the FEN tag is malformed
+    bool setStart(const PgnGame &game);
+
+    // The squares the piece on from can move to: GameLogic::reachableSquares for this position
+    uint64_t targets(int from) const;
+
+    // Make a move by the same rules as GameLogic::playMove; a pawn reaching the last
+    // rank becomes promotion (a piece type)
+    void play(int from, int to, int promotion = 11);
+
+    void toBoard(vector<vector<int>> &board) const; // In the board[x][y] layout
+
+    // Zobrist::hashBoard of the position, without building the board
+    uint64_t key() const;
+};
+
+// Binary game files. A data file holds one record per game:
+//
+//   tag count (1 byte), then per tag: name length (1), name, value length (2), value
+//   result (1 byte: 0 "*", 1 "1-0", 2 "0-1", 3 "1/2-1/2")
+//   ply count (2 bytes), then one byte per move
+//
+// A move byte is the move's number among the moves the position offers: the pieces
+// of the side to move are taken in board order (board[0][0], board[0][1], ...) and
+// each piece's target squares in the same order. A pawn about to promote numbers each
+// target four times, for a queen, rook, bishop and knight. Every move the movement rules
+// allow is numbered, not only the legal ones; the games were checked when they were
+// stored, and decoding then needs no check tests.
+//
+// The index file next to it (<data>.idx) holds the offset of every record plus the
+// end of the last one, so game N is found and read in place through a mapping.
+class GameStoreWriter
+{
+private:
+    FILE *data;
+    string path;
+    vector<uint64_t> offsets;
+    uint64_t written;
+    string record; // Reused for every game
+    StoredPosition position;
+
+public:
+    GameStoreWriter();
+    ~GameStoreWriter(); // Closes the store if close was not called
+
+    bool open(const string &path);
+
+    // The game's moves up to its first error, if it has one; false if it was cut short
+    // or could not be written
+    bool addGame(const PgnGame &game);
+
+    bool close(); // Writes the index; the store can't be read without it
+    size_t getGameCount() const { return offsets.size(); }
+};
+
+class GameStore
+{
+private:
+    MappedFile data;
+    MappedFile index;
+    size_t gameCount;
+    const uint64_t *offsets;
+    StoredPosition position;
+
+public:
+    GameStore();
+
+    bool open(const string &path);
+    size_t getGameCount() const { return gameCount; }
+
+    // Game n (counting from 0) into game, reusing its capacity; the moves are decoded
+    // by replaying them, so afterwards getPosition() holds the game's final position
+    bool readGame(size_t n, PgnGame &game);
+    const StoredPosition &getPosition() const { return position; }
+
+    // One game in the data file's record format, appended to out and numbered on
+    // position; false if its moves had to be cut short
+    static bool appendRecord(string &out, const PgnGame &game, StoredPosition &position);
+
+    // The record at p into game, replayed on position; p is left after the record
+    static bool readRecord(const char *&p, const char *end, PgnGame &game, StoredPosition &position);
+
+    // Step over the record at p without decoding it
+    static bool skipRecord(const char *&p, const char *end);
+
+    // Command line entry: --store [--threads N] in.pgn out.cgd  (PGN to binary)
+    //                     --store in.cgd out.pgn                 (binary to PGN)
+    static int runCommandLine(int argc, char *argv[]);
+};
+
+// Turns stored games back into PGN text: replaying each game on a rules-only
+// GameLogic gives the SAN with check marks
+class StoredGamePgn
+{
+private:
+    vector<vector<int>> board;
+    vector<vector<int>> startBoard;
+    GameLogic logic; // Refers to board
+    FenPosition fenPosition;
+    string error;
+
+public:
+    StoredGamePgn();
+
+    // The game's tags, movetext and result, then a blank line
+    void append(string &out, const PgnGame &game);
+};
+
+#endif // GAMESTORE_H
@@ -0,0 +1,159 @@
+#include "Lz4.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+static const size_t MIN_MATCH = 4;
+static const size_t LAST_LITERALS = 5; // A block always ends with at least this many literals
+static const size_t MATCH_LIMIT = 12;  // and no match starts closer than this to its end
+static const size_t MAX_OFFSET = 65535;
+
+// Helper function to read four bytes wherever they lie
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Helper function to write the part of a length that did not fit in the token
+static inline uint8_t *writeLength(uint8_t *op, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *op++ = 255;
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+// Helper function to read the part of a length that did not fit in the token
+static inline bool readLength(const uint8_t *&ip, const uint8_t *end, size_t limit, size_t &length)
+{
+    uint8_t byte;
+    do
+    {
+        if (ip == end)
+            return false;
+        byte = *ip++;
+        length += byte;
+        if (length > limit)
+            return false;
+    } while (byte == 255);
+    return true;
+}
+
+// Helper function to write one sequence: literals, then a match if matchLength is not 0
+static inline uint8_t *writeSequence(uint8_t *op, const uint8_t *literals, size_t literalLength,
+                                     size_t offset, size_t matchLength)
+{
+    uint8_t *token = op++;
+    *token = static_cast<uint8_t>(min<size_t>(literalLength, 15) << 4);
+    if (literalLength >= 15)
+        op = writeLength(op, literalLength - 15);
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+
+    if (matchLength == 0)
+        return op; // The last sequence of a block has no match
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    size_t length = matchLength - MIN_MATCH;
+    *token |= static_cast<uint8_t>(min<size_t>(length, 15));
+    if (length >= 15)
+        op = writeLength(op, length - 15);
+    return op;
+}
+
+Lz4::Lz4() : hashTable(static_cast<size_t>(1) << HASH_BITS)
+{
+}
+
+size_t Lz4::compress(const char *src, size_t size, char *dst)
+{
+    const uint8_t *in = reinterpret_cast<const uint8_t *>(src);
+    const uint8_t *end = in + size;
+    const uint8_t *anchor = in; // Start of the literals not written yet
+    uint8_t *op = reinterpret_cast<uint8_t *>(dst);
+
+    if (size > MATCH_LIMIT)
+    {
+        fill(hashTable.begin(), hashTable.end(), 0);
+        const uint8_t *limit = end - MATCH_LIMIT;
+        const uint8_t *ip = in + 1;
+        while (ip < limit)
+        {
+            uint32_t sequence = read32(ip);
+            uint32_t hash = (sequence * 2654435761U) >> (32 - HASH_BITS);
+            const uint8_t *ref = in + hashTable[hash];
+            hashTable[hash] = static_cast<uint32_t>(ip - in);
+            if (ref >= ip || static_cast<size_t>(ip - ref) > MAX_OFFSET || read32(ref) != sequence)
+            {
+                ip++;
+                continue;
+            }
+
+            // Grow the match backwards over literals, then forwards up to the last literals
+            while (ip > anchor && ref > in && ip[-1] == ref[-1])
+            {
+                ip--;
+                ref--;
+            }
+            const uint8_t *matchEnd = ip + MIN_MATCH;
+            const uint8_t *refEnd = ref + MIN_MATCH;
+            while (matchEnd < end - LAST_LITERALS && *matchEnd == *refEnd)
+            {
+                matchEnd++;
+                refEnd++;
+            }
+
+            op = writeSequence(op, anchor, ip - anchor, ip - ref, matchEnd - ip);
+            ip = anchor = matchEnd;
+        }
+    }
+
+    op = writeSequence(op, anchor, end - anchor, 0, 0);
+    return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+bool Lz4::decompress(const char *src, size_t size, char *dst, size_t rawSize)
+{
+    const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+    const uint8_t *end = ip + size;
+    uint8_t *op = reinterpret_cast<uint8_t *>(dst);
+    uint8_t *outEnd = op + rawSize;
+
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, end, rawSize, literalLength))
+            return false;
+        if (static_cast<size_t>(end - ip) < literalLength || static_cast<size_t>(outEnd - op) < literalLength)
+            return false;
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+        if (ip == end)
+            break; // The last sequence
+
+        if (end - ip < 2)
+            return false;
+        size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - reinterpret_cast<uint8_t *>(dst)))
+            return false;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, end, rawSize, matchLength))
+            return false;
+        matchLength += MIN_MATCH;
+        if (static_cast<size_t>(outEnd - op) < matchLength)
+            return false;
+
+        // Byte by byte: a match may overlap the bytes it is producing
+        const uint8_t *match = op - offset;
+        for (size_t i = 0; i < matchLength; i++)
+            op[i] = match[i];
+        op += matchLength;
+    }
+    return op == outEnd;
+}
@@ -0,0 +1,36 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// The LZ4 block format, built in so archives need no library: a run of sequences,
+// each a token (literal length, match length - 4), the literals, a 2-byte offset back
+// into what was already decoded and the match length. Blocks written here can be
+// read by any LZ4 block decoder and the other way round. The compressor is the
+// greedy single-probe kind: fast rather than dense.
+class Lz4
+{
+private:
+    static const int HASH_BITS = 16;
+    vector<uint32_t> hashTable; // Where each hashed 4-byte sequence was last seen, reused between blocks
+
+public:
+    Lz4();
+
+    // The most a block of size bytes can grow to
+    static size_t compressBound(size_t size) { return size + size / 255 + 16; }
+
+    // Compress size bytes into dst, which has room for compressBound(size); returns
+    // the compressed size
+    size_t compress(const char *src, size_t size, char *dst);
+
+    // Decode a whole block that must come out as exactly rawSize bytes; false if it
+    // is damaged. Never reads or writes outside either buffer
+    static bool decompress(const char *src, size_t size, char *dst, size_t rawSize);
+};
+
+#endif // LZ4_H
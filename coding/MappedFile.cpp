@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#define _HAS_STD_BYTE 0 // Prevent std::byte conflicts
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() : view(nullptr), length(0), opened(false)
+{
+#ifdef _WIN32
+    file = INVALID_HANDLE_VALUE;
+    mapping = nullptr;
+#else
+    descriptor = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const string &path)
+{
+    close();
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length > 0)
+    {
+        // A file of zero bytes can't be mapped, and needs no mapping
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        view = mapping ? static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!view)
+        {
+            close();
+            return false;
+        }
+    }
+#else
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    struct stat status;
+    if (fstat(descriptor, &status) != 0)
+    {
+        close();
+        return false;
+    }
+    length = static_cast<size_t>(status.st_size);
+    if (length > 0)
+    {
+        // A file of zero bytes can't be mapped, and needs no mapping
+        void *address = mmap(nullptr, length, PROT_READ, MAP_SHARED, descriptor, 0);
+        if (address == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        view = static_cast<const char *>(address);
+    }
+#endif
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (view)
+        UnmapViewOfFile(view);
+    if (mapping)
+        CloseHandle(mapping);
+    if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (view)
+        munmap(const_cast<char *>(view), length);
+    if (descriptor >= 0)
+        ::close(descriptor);
+    descriptor = -1;
+#endif
+    view = nullptr;
+    length = 0;
+    opened = false;
+}
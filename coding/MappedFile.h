@@ -0,0 +1,39 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+
+using namespace std;
+
+// A whole file mapped read-only into memory, so any part of it can be read in
+// place and the operating system only pages in what is touched
+class MappedFile
+{
+private:
+    const char *view; // Null for an empty file
+    size_t length;
+    bool opened;
+#ifdef _WIN32
+    void *file;    // HANDLE, so windows.h stays out of this header
+    void *mapping; // HANDLE
+#else
+    int descriptor;
+#endif
+
+    // The mapping belongs to one object
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const string &path);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char *data() const { return view; }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,380 @@
+#include "MultiBoardView.h"
+#include "ChessBoard.h" // StockfishEngine, PIECE_SCALE, SCALE_FACTOR
+#include "BoardImageRenderer.h"
+#include "FrameProfiler.h"
+#include "Fen.h"
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+#include <atomic>
+
+using namespace std;
+using namespace sf;
+
+static const int IDLE_POLL_MS = 8; // Sleep between polls while nothing moves
+
+MultiBoardView::Slot::Slot()
+    : board(8, vector<int>(8, 0)), logic(board), whiteToMove(true), finished(false), moveCount(0)
+{
+    Fen::parsePlacement(Fen::START, board);
+}
+
+MultiBoardView::MultiBoardView()
+    : atlas(nullptr), pieceScale(1), columns(1), gap(SQUARE_SIZE / 4.0f),
+      squares(Triangles), pieces(Triangles), batchDirty(true)
+{
+}
+
+void MultiBoardView::setAtlas(const PieceAtlas *pieceAtlas, float pieceScale)
+{
+    atlas = pieceAtlas;
+    this->pieceScale = pieceScale;
+    for (auto &slot : slots)
+    {
+        slot->renderer.setAtlas(pieceAtlas, pieceScale);
+    }
+    batchDirty = true;
+}
+
+int MultiBoardView::addBoard(const string &title, bool flipped)
+{
+    slots.emplace_back(new Slot());
+    Slot &slot = *slots.back();
+    slot.title = title;
+    slot.renderer.setAtlas(atlas, pieceScale);
+    slot.renderer.setFlipped(flipped);
+
+    // Keep the grid roughly square
+    columns = static_cast<int>(ceil(sqrt(static_cast<double>(slots.size()))));
+    batchDirty = true;
+    return static_cast<int>(slots.size()) - 1;
+}
+
+void MultiBoardView::setFlipped(int board, bool flipped)
+{
+    slots[board]->renderer.setFlipped(flipped);
+    batchDirty = true;
+}
+
+void MultiBoardView::postMove(int board, const string &uciMove)
+{
+    lock_guard<mutex> lock(pendingMutex);
+    pending.emplace_back(board, uciMove);
+}
+
+void MultiBoardView::applyMove(Slot &slot, const string &uciMove)
+{
+    if (uciMove.length() < 4 || slot.finished)
+        return;
+
+    int fromX = uciMove[0] - 'a';
+    int fromY = '8' - uciMove[1];
+    int toX = uciMove[2] - 'a';
+    int toY = '8' - uciMove[3];
+    if (fromX < 0 || fromX >= 8 || fromY < 0 || fromY >= 8 || toX < 0 || toX >= 8 || toY < 0 || toY >= 8 ||
+        slot.board[fromX][fromY] == 0)
+    {
+        cerr << "Ignoring move " << uciMove << " on board " << slot.title << endl;
+        return;
+    }
+
+    // Animate against the position before the move, as ChessBoard does through GameLogic
+    if (slot.logic.isEnPassantCapture(fromX, fromY, toX, toY))
+    {
+        slot.renderer.animateMove(slot.board, fromX, fromY, toX, toY, toX, fromY);
+    }
+    else
+    {
+        slot.renderer.animateMove(slot.board, fromX, fromY, toX, toY);
+    }
+    if (slot.logic.isCastlingMove(fromX, fromY, toX, toY))
+    {
+        int rookFromX = toX > fromX ? 7 : 0;
+        int rookToX = toX > fromX ? 5 : 3;
+        slot.renderer.animateMove(slot.board, rookFromX, fromY, rookToX, fromY);
+    }
+
+    // A promoting pawn becomes a queen unless the move names another piece
+    int promotion = 11;
+    if (uciMove.length() > 4)
+    {
+        switch (uciMove[4])
+        {
+        case 'r':
+            promotion = 6;
+            break;
+        case 'b':
+            promotion = 7;
+            break;
+        case 'n':
+            promotion = 8;
+            break;
+        }
+    }
+    slot.logic.movePiece(fromX, fromY, toX, toY, promotion);
+
+    slot.whiteToMove = !slot.whiteToMove;
+    slot.moveCount++;
+    if (slot.logic.checkMate(slot.whiteToMove) || slot.logic.checkStaleMate(slot.whiteToMove))
+    {
+        slot.finished = true;
+    }
+}
+
+bool MultiBoardView::update(float seconds)
+{
+    vector<pair<int, string>> moves;
+    {
+        lock_guard<mutex> lock(pendingMutex);
+        moves.swap(pending);
+    }
+    for (const auto &move : moves)
+    {
+        if (move.first >= 0 && move.first < static_cast<int>(slots.size()))
+        {
+            applyMove(*slots[move.first], move.second);
+        }
+    }
+
+    // Each board only rebuilds its own geometry when it changed or is animating
+    static const vector<pair<int, int>> noMoves;
+    bool changed = batchDirty;
+    for (auto &slot : slots)
+    {
+        bool animating = slot->renderer.advance(seconds);
+        bool rebuilt = slot->renderer.update(slot->board, static_cast<float>(SQUARE_SIZE), -1, -1, noMoves);
+        changed = changed || animating || rebuilt;
+    }
+
+    if (changed)
+    {
+        rebuildBatch();
+    }
+    return changed;
+}
+
+void MultiBoardView::rebuildBatch()
+{
+    // clear() keeps the capacity, so gathering every frame of an animation doesn't allocate
+    squares.clear();
+    pieces.clear();
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        slots[i]->renderer.appendGeometry(squares, pieces, getBoardOrigin(static_cast<int>(i)));
+    }
+    batchDirty = false;
+}
+
+Vector2f MultiBoardView::getSize() const
+{
+    int count = max(1, static_cast<int>(slots.size()));
+    int rows = (count + columns - 1) / columns;
+    float boardSize = 8.0f * SQUARE_SIZE;
+    return Vector2f(columns * boardSize + (columns + 1) * gap, rows * boardSize + (rows + 1) * gap);
+}
+
+Vector2f MultiBoardView::getBoardOrigin(int board) const
+{
+    float boardSize = 8.0f * SQUARE_SIZE;
+    int column = board % columns;
+    int row = board / columns;
+    return Vector2f(gap + column * (boardSize + gap), gap + row * (boardSize + gap));
+}
+
+int MultiBoardView::boardAt(Vector2f point) const
+{
+    float boardSize = 8.0f * SQUARE_SIZE;
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        Vector2f origin = getBoardOrigin(static_cast<int>(i));
+        if (FloatRect(origin.x, origin.y, boardSize, boardSize).contains(point))
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void MultiBoardView::draw(RenderTarget &target, RenderStates states) const
+{
+    target.draw(squares, states);
+
+    if (atlas && pieces.getVertexCount() > 0)
+    {
+        states.texture = &atlas->getTexture();
+        target.draw(pieces, states);
+    }
+}
+
+// Helper function to play one engine game and feed its moves to a board
+static void playEngineGame(MultiBoardView &view, int board, int skillLevel, int moveTimeMs, atomic<bool> &stop)
+{
+    StockfishEngine engine;
+    if (!engine.initialize())
+    {
+        cerr << "Board " << board + 1 << ": could not start Stockfish" << endl;
+        return;
+    }
+    engine.setDifficulty(skillLevel);
+
+    string position;
+    for (int ply = 0; ply < 400 && !stop; ply++)
+    {
+        string move = engine.getBestMove(position, moveTimeMs);
+        if (move.empty() || move == "(none)")
+            break; // Mate, stalemate or a dead engine
+        view.postMove(board, move);
+        position += (position.empty() ? "" : " ") + move;
+    }
+    engine.close();
+}
+
+int MultiBoardView::runCommandLine(int argc, char *argv[])
+{
+    int boardCount = 16;
+    int moveTimeMs = 300;
+
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--boards" && hasValue)
+            boardCount = max(1, atoi(argv[++i]));
+        else if (arg == "--movetime" && hasValue)
+            moveTimeMs = max(10, atoi(argv[++i]));
+        else
+        {
+            cerr << "Unknown watch option: " << arg << endl;
+            return 1;
+        }
+    }
+
+    PieceAtlas atlas;
+    if (!atlas.loadImages("coding/images"))
+        return 1;
+
+    MultiBoardView view;
+    for (int i = 0; i < boardCount; i++)
+    {
+        view.addBoard("Game " + to_string(i + 1), i % 2 == 1); // Every other board from Black's side
+    }
+
+    RenderWindow window(VideoMode(1280, 960), "Chess - " + to_string(boardCount) + " games");
+    window.setFramerateLimit(60);
+
+    // Letterbox the grid into the window; only the view and the atlas resolution depend on its size
+    float pieceScale = PIECE_SCALE * SCALE_FACTOR;
+    auto applyLayout = [&]()
+    {
+        Vector2u windowSize = window.getSize();
+        Vector2f gridSize = view.getSize();
+        float windowWidth = static_cast<float>(max(1u, windowSize.x));
+        float windowHeight = static_cast<float>(max(1u, windowSize.y));
+        float scale = min(windowWidth / gridSize.x, windowHeight / gridSize.y);
+        float width = gridSize.x * scale / windowWidth;
+        float height = gridSize.y * scale / windowHeight;
+
+        View gridView(FloatRect(0, 0, gridSize.x, gridSize.y));
+        gridView.setViewport(FloatRect((1 - width) / 2, (1 - height) / 2, width, height));
+        window.setView(gridView);
+
+        unsigned int cellSize = PieceAtlas::cellSizeFor(SQUARE_SIZE * scale * pieceScale);
+        if (cellSize != atlas.getCellSize() && atlas.build(cellSize))
+        {
+            view.setAtlas(&atlas, pieceScale);
+        }
+    };
+    applyLayout();
+    if (atlas.getCellSize() == 0)
+        return 1;
+
+    // Skill levels spread over the boards so the games differ
+    atomic<bool> stop(false);
+    vector<thread> games;
+    for (int i = 0; i < boardCount; i++)
+    {
+        games.emplace_back(playEngineGame, ref(view), i, (i * 7) % 21, moveTimeMs, ref(stop));
+    }
+
+    FrameProfiler &profiler = FrameProfiler::instance();
+    Clock frameClock;
+    Clock reportClock;
+    bool redrawNeeded = true;
+    while (window.isOpen())
+    {
+        Event event;
+        while (window.pollEvent(event))
+        {
+            if (event.type == Event::Closed ||
+                (event.type == Event::KeyPressed && event.key.code == Keyboard::Escape))
+            {
+                window.close();
+            }
+            else if (event.type == Event::Resized)
+            {
+                applyLayout();
+            }
+            // Click a board to turn it around, F turns them all
+            else if (event.type == Event::MouseButtonPressed)
+            {
+                int board = view.boardAt(window.mapPixelToCoords(Vector2i(event.mouseButton.x, event.mouseButton.y)));
+                if (board >= 0)
+                {
+                    view.setFlipped(board, !view.isFlipped(board));
+                }
+            }
+            else if (event.type == Event::KeyPressed && event.key.code == Keyboard::F)
+            {
+                for (int i = 0; i < boardCount; i++)
+                {
+                    view.setFlipped(i, !view.isFlipped(i));
+                }
+            }
+            if (event.type != Event::MouseMoved)
+            {
+                redrawNeeded = true;
+            }
+        }
+
+        {
+            ScopedTimer timer(FramePhase::Logic);
+            if (view.update(frameClock.restart().asSeconds()))
+            {
+                redrawNeeded = true;
+            }
+        }
+
+        if (!redrawNeeded || !window.isOpen())
+        {
+            sf::sleep(milliseconds(IDLE_POLL_MS));
+            continue;
+        }
+        redrawNeeded = false;
+
+        {
+            ScopedTimer timer(FramePhase::Draw);
+            window.clear(Color(30, 30, 30));
+            window.draw(view);
+            profiler.addDrawCalls(view.getDrawCallCount(), view.getVertexCount());
+        }
+        {
+            ScopedTimer timer(FramePhase::Present);
+            window.display();
+        }
+        profiler.endFrame();
+
+        if (reportClock.getElapsedTime().asSeconds() >= 5)
+        {
+            reportClock.restart();
+            cout << profiler.getFramesPerSecond() << " fps, frame p95 " << profiler.getFrameTimePercentile(95)
+                 << " ms, " << profiler.getDrawCalls() << " draw calls for " << boardCount << " boards" << endl;
+        }
+    }
+
+    // Engines finish their current search, then see the flag
+    stop = true;
+    for (thread &game : games)
+    {
+        game.join();
+    }
+    return 0;
+}
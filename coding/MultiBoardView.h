@@ -0,0 +1,90 @@
+#ifndef MULTIBOARDVIEW_H
+#define MULTIBOARDVIEW_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include "GameLogic.h"
+#include "PieceAtlas.h"
+#include "BoardRenderer.h"
+
+using namespace std;
+using namespace sf;
+
+// Several live games laid out in a grid, for watching them side by side. Every
+// board keeps its own position, rules state and orientation, and caches its
+// geometry in its own BoardRenderer; the cached vertices are then gathered into
+// two shared arrays, so all boards draw with the one piece atlas in two calls.
+//
+// Moves come in as UCI strings from whatever runs the games (engine threads, a
+// network connection) through postMove, which may be called from any thread.
+class MultiBoardView : public Drawable
+{
+private:
+    struct Slot
+    {
+        vector<vector<int>> board;
+        GameLogic logic; // Rules only, refers to board
+        BoardRenderer renderer;
+        string title;
+        bool whiteToMove;
+        bool finished;
+        size_t moveCount;
+
+        Slot();
+    };
+
+    vector<unique_ptr<Slot>> slots; // Stable addresses: GameLogic holds a reference to board
+    const PieceAtlas *atlas;
+    float pieceScale;
+    int columns;
+    float gap;        // Logical units between boards
+    VertexArray squares; // Triangles: every board's squares and indicators
+    VertexArray pieces;  // Triangles: every board's pieces, textured from the atlas
+    bool batchDirty;
+
+    mutex pendingMutex;
+    vector<pair<int, string>> pending; // Moves posted since the last update
+
+    void applyMove(Slot &slot, const string &uciMove);
+    void rebuildBatch();
+
+    virtual void draw(RenderTarget &target, RenderStates states) const;
+
+public:
+    static const int SQUARE_SIZE = 64; // Logical square size of every board
+
+    MultiBoardView();
+
+    void setAtlas(const PieceAtlas *pieceAtlas, float pieceScale);
+
+    // Returns the new board's index; boards are placed left to right, top to bottom
+    int addBoard(const string &title, bool flipped = false);
+    size_t getBoardCount() const { return slots.size(); }
+    void setFlipped(int board, bool flipped);
+    bool isFlipped(int board) const { return slots[board]->renderer.isFlipped(); }
+    bool isFinished(int board) const { return slots[board]->finished; }
+    const string &getTitle(int board) const { return slots[board]->title; }
+
+    // Thread safe; the move is applied (and animated) on the next update
+    void postMove(int board, const string &uciMove);
+
+    // Apply posted moves and advance animations; returns true if anything changed
+    bool update(float seconds);
+
+    // Grid geometry in logical units
+    Vector2f getSize() const;
+    Vector2f getBoardOrigin(int board) const;
+    int boardAt(Vector2f point) const; // -1 if the point is between boards
+
+    size_t getDrawCallCount() const { return atlas && pieces.getVertexCount() > 0 ? 2 : 1; }
+    size_t getVertexCount() const { return squares.getVertexCount() + pieces.getVertexCount(); }
+
+    // Command line entry: --watch [--boards N] [--movetime MS]
+    // Plays N engine games (16 by default) and shows them in one window.
+    static int runCommandLine(int argc, char *argv[]);
+};
+
+#endif // MULTIBOARDVIEW_H
@@ -0,0 +1,333 @@
+#include "PgnImporter.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+
+static const size_t CHUNKS_AHEAD_PER_THREAD = 2; // How far the reader may get ahead of the sink
+static const size_t MAX_REPORTED_ERRORS = 10;    // Per file, for --import
+
+// Helper function to measure a stage
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Helper function to tell whether a line holds nothing but whitespace
+static bool isBlankLine(const char *line, const char *end)
+{
+    for (; line < end && *line != '\n'; line++)
+    {
+        if (*line != ' ' && *line != '\t' && *line != '\r')
+            return false;
+    }
+    return true;
+}
+
+// Helper function to find where the last game that starts in text begins: the first
+// tag line after the last line of movetext. 0 if no game starts after some movetext
+static size_t lastGameStart(const char *text, size_t size)
+{
+    size_t start = 0;
+    for (size_t pos = size; pos > 0; pos--)
+    {
+        if (text[pos - 1] != '\n' || pos == size)
+            continue;
+        if (text[pos] == '[')
+            start = pos;
+        else if (start > 0 && !isBlankLine(text + pos, text + size))
+            return start;
+    }
+    return 0;
+}
+
+ImportStats::ImportStats()
+    : bytesRead(0), chunks(0), games(0), moves(0), gamesWithErrors(0), steals(0), threads(0),
+      readSeconds(0), parseSeconds(0), sinkSeconds(0), wallSeconds(0)
+{
+}
+
+PgnImporter::PgnImporter(int threadCount, size_t chunkSize)
+    : threadCount(threadCount), chunkSize(max<size_t>(chunkSize, 1))
+{
+    if (this->threadCount <= 0)
+    {
+        this->threadCount = max(1, static_cast<int>(thread::hardware_concurrency()));
+    }
+}
+
+bool PgnImporter::importFile(const string &path, const GameSink &sink)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        cerr << "Could not open PGN file: " << path << endl;
+        return false;
+    }
+
+    auto start = chrono::steady_clock::now();
+    stats = ImportStats();
+    stats.threads = threadCount;
+    queues.clear();
+    for (int i = 0; i < threadCount; i++)
+    {
+        queues.emplace_back(new WorkerQueue());
+    }
+    chunksQueued = 0;
+    chunksTaken = 0;
+    chunksSunk = 0;
+    readerDone = false;
+    readFailed = false;
+    parsed.clear();
+
+    thread reader(&PgnImporter::readChunks, this, file);
+    vector<thread> workers;
+    for (int i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back(&PgnImporter::workerLoop, this, static_cast<size_t>(i));
+    }
+
+    // The sink stage runs here: chunks are handed on strictly in file order
+    size_t gameNumber = 0;
+    while (true)
+    {
+        unique_lock<mutex> lock(stateMutex);
+        stateChanged.wait(lock, [&]()
+                          { return parsed.count(chunksSunk) > 0 || (readerDone && chunksSunk == chunksQueued); });
+        auto next = parsed.find(chunksSunk);
+        if (next == parsed.end())
+            break; // Everything read has been sunk
+        vector<PgnGame> games;
+        games.swap(next->second);
+        parsed.erase(next);
+        lock.unlock();
+
+        auto sinkStart = chrono::steady_clock::now();
+        for (PgnGame &game : games)
+        {
+            game.number = ++gameNumber;
+            stats.moves += game.moves.size();
+            if (!game.error.empty())
+                stats.gamesWithErrors++;
+            sink(game);
+        }
+        stats.games = gameNumber;
+        stats.sinkSeconds += secondsSince(sinkStart);
+
+        lock.lock();
+        chunksSunk++;
+        stateChanged.notify_all(); // The reader may be waiting for room
+    }
+
+    reader.join();
+    for (thread &worker : workers)
+    {
+        worker.join();
+    }
+    fclose(file);
+
+    stats.chunks = chunksQueued;
+    stats.wallSeconds = secondsSince(start);
+    if (readFailed)
+        cerr << "Error reading PGN file: " << path << endl;
+    return !readFailed;
+}
+
+void PgnImporter::readChunks(FILE *file)
+{
+    size_t maxAhead = CHUNKS_AHEAD_PER_THREAD * threadCount + 1;
+    vector<char> carry; // The start of a game that was cut off by the end of the last chunk
+    size_t index = 0;
+    bool atEnd = false;
+    while (!atEnd)
+    {
+        {
+            unique_lock<mutex> lock(stateMutex);
+            stateChanged.wait(lock, [&]()
+                              { return chunksQueued - chunksSunk < maxAhead; });
+        }
+
+        auto readStart = chrono::steady_clock::now();
+        Chunk chunk;
+        chunk.index = index;
+        chunk.text.swap(carry);
+        size_t kept = chunk.text.size();
+        chunk.text.resize(kept + chunkSize);
+        size_t read = fread(chunk.text.data() + kept, 1, chunkSize, file);
+        chunk.text.resize(kept + read);
+        stats.bytesRead += read;
+        atEnd = read < chunkSize && (feof(file) || ferror(file));
+        if (ferror(file))
+            readFailed = true;
+
+        // Cut after the last complete game; the game after it moves on to the next chunk
+        size_t end = atEnd ? chunk.text.size() : lastGameStart(chunk.text.data(), chunk.text.size());
+        carry.assign(chunk.text.begin() + end, chunk.text.end());
+        chunk.text.resize(end);
+        stats.readSeconds += secondsSince(readStart);
+        if (chunk.text.empty())
+            continue; // One game longer than a chunk: keep reading it
+
+        {
+            lock_guard<mutex> lock(queues[index % queues.size()]->lock);
+            queues[index % queues.size()]->chunks.push_back(move(chunk));
+        }
+        index++;
+        lock_guard<mutex> lock(stateMutex);
+        chunksQueued++;
+        stateChanged.notify_all();
+    }
+
+    lock_guard<mutex> lock(stateMutex);
+    readerDone = true;
+    stateChanged.notify_all();
+}
+
+bool PgnImporter::takeChunk(size_t worker, Chunk &chunk)
+{
+    // The worker's own queue from the front, then the others from the back
+    for (size_t i = 0; i < queues.size(); i++)
+    {
+        WorkerQueue &queue = *queues[(worker + i) % queues.size()];
+        lock_guard<mutex> queueLock(queue.lock);
+        if (queue.chunks.empty())
+            continue;
+        if (i == 0)
+        {
+            chunk = move(queue.chunks.front());
+            queue.chunks.pop_front();
+        }
+        else
+        {
+            chunk = move(queue.chunks.back());
+            queue.chunks.pop_back();
+        }
+
+        // Counted before the queue lock is let go, so no one sees the chunk in neither place
+        lock_guard<mutex> lock(stateMutex);
+        chunksTaken++;
+        if (i > 0)
+            stats.steals++;
+        return true;
+    }
+    return false;
+}
+
+void PgnImporter::workerLoop(size_t worker)
+{
+    PgnParser parser;
+    double parseSeconds = 0;
+    Chunk chunk;
+    vector<PgnGame> games;
+    auto collect = [&](const PgnGame &game)
+    {
+        games.push_back(game);
+        return true;
+    };
+
+    while (true)
+    {
+        if (!takeChunk(worker, chunk))
+        {
+            unique_lock<mutex> lock(stateMutex);
+            if (readerDone && chunksTaken == chunksQueued)
+                break;
+            stateChanged.wait(lock, [&]()
+                              { return readerDone || chunksQueued > chunksTaken; });
+            continue;
+        }
+
+        auto parseStart = chrono::steady_clock::now();
+        games.clear();
+        parser.parse(chunk.text.data(), chunk.text.size(), collect);
+        parseSeconds += secondsSince(parseStart);
+
+        lock_guard<mutex> lock(stateMutex);
+        parsed[chunk.index].swap(games);
+        stateChanged.notify_all();
+    }
+
+    lock_guard<mutex> lock(stateMutex);
+    stats.parseSeconds += parseSeconds;
+}
+
+void PgnImporter::printStats(ostream &out) const
+{
+    double megabytes = stats.bytesRead / (1024.0 * 1024.0);
+    double gamesPerMinute = stats.wallSeconds > 0 ? stats.games * 60 / stats.wallSeconds : 0;
+    double perThread = stats.parseSeconds > 0 ? stats.games * 60 / stats.parseSeconds : 0;
+    out << "read:  " << megabytes << " MB in " << stats.chunks << " chunks, " << stats.readSeconds << " s ("
+        << (stats.readSeconds > 0 ? megabytes / stats.readSeconds : 0) << " MB/s)\n";
+    out << "parse: " << stats.games << " games, " << stats.moves << " moves on " << stats.threads << " threads, "
+        << stats.parseSeconds << " s of work (" << static_cast<size_t>(perThread) << " games/min per thread), "
+        << stats.steals << " chunks stolen\n";
+    out << "sink:  " << stats.sinkSeconds << " s\n";
+    out << "total: " << stats.wallSeconds << " s (" << static_cast<size_t>(gamesPerMinute) << " games/min), "
+        << stats.gamesWithErrors << " games with moves that could not be read" << endl;
+}
+
+int PgnImporter::runCommandLine(int argc, char *argv[])
+{
+    int threads = 0;
+    string outPath;
+    vector<string> files;
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue)
+            threads = atoi(argv[++i]);
+        else if (arg == "--out" && hasValue)
+            outPath = argv[++i];
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            cerr << "Unknown import option: " << arg << endl;
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+    if (files.empty())
+    {
+        cerr << "Usage: --import [--threads N] [--out report.tsv] file.pgn ..." << endl;
+        return 1;
+    }
+
+    // Per-game report: one row per game in file order
+    ofstream report;
+    if (!outPath.empty())
+    {
+        report.open(outPath, ios::out | ios::trunc);
+        if (!report.is_open())
+        {
+            cerr << "Could not write import report: " << outPath << endl;
+            return 1;
+        }
+        report << "file\tgame\tresult\tplies\tlegal\terror\n";
+    }
+
+    PgnImporter importer(threads);
+    bool ok = true;
+    for (const string &file : files)
+    {
+        size_t reported = 0;
+        auto sink = [&](const PgnGame &game)
+        {
+            if (!game.error.empty() && reported++ < MAX_REPORTED_ERRORS)
+                cerr << file << " game " << game.number << ": " << game.error << endl;
+            if (report.is_open())
+            {
+                report << file << "\t" << game.number << "\t" << game.result << "\t" << game.moves.size()
+                       << "\t" << (game.error.empty() ? "yes" : "no") << "\t" << game.error << "\n";
+            }
+        };
+
+        ok = importer.importFile(file, sink) && ok;
+        cout << file << ":\n";
+        importer.printStats(cout);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,94 @@
+#ifndef PGNIMPORTER_H
+#define PGNIMPORTER_H
+
+#include "PgnParser.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// How long each stage of an import took, and how much it got through
+struct ImportStats
+{
+    unsigned long long bytesRead;
+    size_t chunks;
+    size_t games;
+    size_t moves;
+    size_t gamesWithErrors;
+    size_t steals;      // Chunks a worker took from another worker's queue
+    int threads;
+    double readSeconds;  // Reader thread: reading and finding game boundaries
+    double parseSeconds; // Summed over the workers: tokenizing and replaying games
+    double sinkSeconds;  // Importing thread: handing games to the sink
+    double wallSeconds;
+
+    ImportStats();
+};
+
+// Imports a PGN file on every core. A reader thread cuts the file into chunks that
+// end at game boundaries, so each chunk parses on its own; each worker has a queue
+// of chunks and its own PgnParser, and a worker whose queue is empty steals from the
+// back of another's. Parsed chunks are put back in file order before the games go
+// to the sink, so the output is the same whatever the thread count. The reader
+// stays a bounded number of chunks ahead, so memory does not grow with the file.
+class PgnImporter
+{
+public:
+    typedef function<void(const PgnGame &)> GameSink; // Called on the importing thread, in file order
+
+    static const size_t CHUNK_SIZE = 4 << 20;
+
+    // threadCount 0 uses one worker per hardware thread
+    explicit PgnImporter(int threadCount = 0, size_t chunkSize = CHUNK_SIZE);
+
+    // Game numbers in the sink count from 1 across the whole file
+    bool importFile(const string &path, const GameSink &sink);
+
+    const ImportStats &getStats() const { return stats; }
+    void printStats(ostream &out) const; // One line per stage
+
+    // Command line entry: --import [--threads N] [--out report.tsv] file.pgn ...
+    static int runCommandLine(int argc, char *argv[]);
+
+private:
+    // A run of whole games from the file
+    struct Chunk
+    {
+        size_t index;
+        vector<char> text;
+    };
+
+    struct WorkerQueue
+    {
+        mutex lock;
+        deque<Chunk> chunks;
+    };
+
+    int threadCount;
+    size_t chunkSize;
+    ImportStats stats;
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    mutex stateMutex; // Guards everything below
+    condition_variable stateChanged;
+    size_t chunksQueued;
+    size_t chunksTaken;
+    size_t chunksSunk;
+    bool readerDone;
+    bool readFailed;
+    map<size_t, vector<PgnGame>> parsed; // Finished chunks waiting for their turn at the sink
+
+    void readChunks(FILE *file);
+    void workerLoop(size_t worker);
+    bool takeChunk(size_t worker, Chunk &chunk);
+};
+
+#endif // PGNIMPORTER_H
@@ -0,0 +1,330 @@
+#include "PgnParser.h"
+#include "Zobrist.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+
+static const size_t BUFFER_SIZE = 1 << 20; // Read size; grows only for a line longer than this
+
+// Helper function to tell where a movetext token ends
+static inline bool isTokenEnd(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '{' || c == '}' ||
+           c == '(' || c == ')' || c == ';';
+}
+
+// Helper function to compare a token with a literal without copying it
+static inline bool tokenIs(const char *token, size_t length, const char *literal)
+{
+    return strlen(literal) == length && memcmp(token, literal, length) == 0;
+}
+
+const string *PgnGame::tag(const char *name) const
+{
+    for (size_t i = 0; i < tagCount; i++)
+    {
+        if (tags[i].first == name)
+            return &tags[i].second;
+    }
+    return nullptr;
+}
+
+PgnParser::PgnParser() : logic(board), whiteToMove(true), handler(nullptr),
+                         gamesParsed(0), movesParsed(0), gamesWithErrors(0), bytesParsed(0)
+{
+    Zobrist::setStartPosition(startBoard);
+    board = startBoard;
+    game.tagCount = 0;
+    reset();
+}
+
+void PgnParser::reset()
+{
+    gameStarted = false;
+    hasMovetext = false;
+    inComment = false;
+    lineStart = true;
+    variationDepth = 0;
+    stopped = false;
+    game.number = 0;
+}
+
+bool PgnParser::parseFile(const string &path, const GameHandler &onGame)
+{
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        cerr << "Could not open PGN file: " << path << endl;
+        return false;
+    }
+
+    reset();
+    handler = &onGame;
+    vector<char> buffer(BUFFER_SIZE);
+    size_t used = 0; // Bytes of an unfinished line kept from the last read
+    bool ok = true;
+    while (!stopped)
+    {
+        size_t read = fread(buffer.data() + used, 1, buffer.size() - used, file);
+        if (read == 0)
+        {
+            ok = !ferror(file);
+            feed(buffer.data(), buffer.data() + used); // Last line without a newline
+            break;
+        }
+        used += read;
+
+        // Tokens never cross a line, so only whole lines are tokenized and the rest waits for the next read
+        const char *begin = buffer.data();
+        const char *lastNewline = begin + used;
+        while (lastNewline > begin && lastNewline[-1] != '\n')
+            lastNewline--;
+        if (lastNewline == begin)
+        {
+            if (used == buffer.size())
+                buffer.resize(buffer.size() * 2);
+            continue;
+        }
+        size_t complete = lastNewline - begin;
+        feed(begin, begin + complete);
+        memmove(buffer.data(), begin + complete, used - complete);
+        used -= complete;
+    }
+    fclose(file);
+
+    finish();
+    handler = nullptr;
+    if (!ok)
+        cerr << "Error reading PGN file: " << path << endl;
+    return ok;
+}
+
+void PgnParser::parse(const char *data, size_t size, const GameHandler &onGame)
+{
+    reset();
+    handler = &onGame;
+    feed(data, data + size);
+    finish();
+    handler = nullptr;
+}
+
+void PgnParser::feed(const char *begin, const char *end)
+{
+    bytesParsed += end - begin;
+    const char *p = begin;
+    while (p < end && !stopped)
+    {
+        char c = *p;
+        if (inComment)
+        {
+            const char *close = static_cast<const char *>(memchr(p, '}', end - p));
+            inComment = close == nullptr;
+            p = close ? close + 1 : end;
+            continue;
+        }
+        if (c == '\n')
+        {
+            lineStart = true;
+            p++;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r')
+        {
+            p++;
+            continue;
+        }
+
+        bool firstOnLine = lineStart;
+        lineStart = false;
+        if (firstOnLine && c == '[' && variationDepth == 0)
+        {
+            p = readTag(p, end);
+            continue;
+        }
+        if (c == ';' || (firstOnLine && c == '%'))
+        {
+            // Comment or escaped line, up to the end of the line
+            const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+            p = newline ? newline : end;
+            continue;
+        }
+
+        switch (c)
+        {
+        case '{':
+            inComment = true;
+            p++;
+            continue;
+        case '(':
+            variationDepth++;
+            p++;
+            continue;
+        case ')':
+            if (variationDepth > 0)
+                variationDepth--;
+            p++;
+            continue;
+        case '}':
+            p++; // Stray, ignored
+            continue;
+        }
+
+        const char *token = p;
+        while (p < end && !isTokenEnd(*p))
+            p++;
+        if (variationDepth == 0)
+            readToken(token, p - token);
+    }
+}
+
+const char *PgnParser::readTag(const char *p, const char *end)
+{
+    const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+    const char *lineEnd = newline ? newline : end;
+
+    // A tag pair after the movetext is the start of the next game
+    if (hasMovetext)
+        endGame();
+    if (!gameStarted)
+        startGame();
+
+    // [Name "Value"], where the value escapes quotes and backslashes with a backslash
+    p++;
+    while (p < lineEnd && (*p == ' ' || *p == '\t'))
+        p++;
+    const char *name = p;
+    while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '"' && *p != ']')
+        p++;
+    size_t nameLength = p - name;
+    while (p < lineEnd && *p != '"')
+        p++;
+    if (nameLength == 0 || p == lineEnd)
+        return lineEnd; // Not a tag pair
+
+    if (game.tagCount == game.tags.size())
+        game.tags.emplace_back();
+    pair<string, string> &tag = game.tags[game.tagCount++];
+    tag.first.assign(name, nameLength);
+    tag.second.clear();
+    for (p++; p < lineEnd && *p != '"'; p++)
+    {
+        if (*p == '\\' && p + 1 < lineEnd)
+            p++;
+        tag.second += *p;
+    }
+
+    // A game set up from a position is replayed from there; tags come before the movetext
+    if (tag.first == "FEN" && game.error.empty())
+    {
+        string error;
+        if (Fen::parse(tag.second, fenPosition, error))
+        {
+            logic.setPosition(fenPosition);
+            whiteToMove = fenPosition.whiteToMove;
+        }
+        else
+            game.error = "bad FEN tag: " + error;
+    }
+    return lineEnd;
+}
+
+void PgnParser::readToken(const char *token, size_t length)
+{
+    if (length == 0)
+        return;
+    if (!gameStarted)
+        startGame();
+
+    // Game termination marker
+    if (tokenIs(token, length, "1-0") || tokenIs(token, length, "0-1") ||
+        tokenIs(token, length, "1/2-1/2") || tokenIs(token, length, "*"))
+    {
+        game.result.assign(token, length);
+        endGame();
+        return;
+    }
+    hasMovetext = true;
+
+    // NAGs ($1) and separate annotation glyphs (!, ?!) carry no move
+    if (token[0] == '$' || token[0] == '!' || token[0] == '?')
+        return;
+
+    // Move number ("12." or "12..."), possibly glued to the move that follows
+    size_t digits = 0;
+    while (digits < length && token[digits] >= '0' && token[digits] <= '9')
+        digits++;
+    if (digits > 0 && digits < length && token[digits] == '.')
+    {
+        while (digits < length && token[digits] == '.')
+            digits++;
+        token += digits;
+        length -= digits;
+        if (length == 0)
+            return;
+    }
+
+    if (!game.error.empty())
+        return; // The rest of the main line can't be placed on the board
+
+    san.assign(token, length);
+    int fromX, fromY, toX, toY;
+    if (!logic.sanToMove(san, whiteToMove, fromX, fromY, toX, toY))
+    {
+        game.error = "could not resolve move '" + san + "'";
+        return;
+    }
+
+    PgnMove move;
+    move.fromX = static_cast<signed char>(fromX);
+    move.fromY = static_cast<signed char>(fromY);
+    move.toX = static_cast<signed char>(toX);
+    move.toY = static_cast<signed char>(toY);
+    move.promotion = 0;
+    if (abs(board[fromX][fromY]) == 10 && (toY == 0 || toY == 7))
+    {
+        int piece = GameLogic::sanPromotion(san);
+        move.promotion = static_cast<signed char>(piece != 0 ? piece : 11); // A bare "e8" is how this game wrote a queen
+    }
+    game.moves.push_back(move);
+    logic.playMove(fromX, fromY, toX, toY, move.promotion != 0 ? move.promotion : 11);
+    whiteToMove = !whiteToMove;
+}
+
+void PgnParser::startGame()
+{
+    gameStarted = true;
+    hasMovetext = false;
+    game.number++;
+    game.tagCount = 0;
+    game.moves.clear();
+    game.result = "*";
+    game.error.clear();
+
+    board = startBoard;
+    logic.reset();
+    whiteToMove = true;
+}
+
+void PgnParser::endGame()
+{
+    gameStarted = false;
+    hasMovetext = false;
+    gamesParsed++;
+    movesParsed += game.moves.size();
+    if (!game.error.empty())
+        gamesWithErrors++;
+    if (handler && !(*handler)(game))
+        stopped = true;
+}
+
+void PgnParser::finish()
+{
+    // A game cut off before its termination marker still counts
+    if (gameStarted && !stopped)
+        endGame();
+    inComment = false;
+    variationDepth = 0;
+}
@@ -0,0 +1,89 @@
+#ifndef PGNPARSER_H
+#define PGNPARSER_H
+
+#include "GameLogic.h"
+#include <string>
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+// One move of a game's main line in the board[x][y] layout (y = 0 is the 8th rank)
+struct PgnMove
+{
+    signed char fromX, fromY, toX, toY;
+    signed char promotion; // Piece type a pawn reaching the last rank becomes (11, 6, 7 or 8), 0 for other moves
+};
+
+// A game as the parser hands it out. The parser fills the same object for every
+// game, so its strings and vectors keep their capacity from one game to the next.
+struct PgnGame
+{
+    size_t number;                     // 1 for the first game of the input
+    vector<pair<string, string>> tags; // Only the first tagCount entries belong to this game
+    size_t tagCount;
+    vector<PgnMove> moves;             // Main line, resolved against the game rules
+    string result;                     // "1-0", "0-1", "1/2-1/2" or "*" (also when the marker is missing)
+    string error;                      // Why moves stops short of the movetext, empty if it doesn't
+
+    const string *tag(const char *name) const; // Null if the game has no such tag
+};
+
+// Streaming PGN reader for game databases of any size. Files are read through a
+// fixed buffer of whole lines, and tokens are looked at where they lie in that
+// buffer: tag pairs, move numbers, SAN, comments, NAGs and variations are told
+// apart by a small state machine that carries over from one buffer to the next,
+// so nothing is allocated per token. Comments and variations are skipped; the
+// main line's SAN is resolved on a rules-only GameLogic.
+class PgnParser
+{
+public:
+    typedef function<bool(const PgnGame &)> GameHandler; // Return false to stop reading
+
+    PgnParser();
+
+    // Read a whole file; false if it could not be opened or read
+    bool parseFile(const string &path, const GameHandler &onGame);
+
+    // Read text already in memory, e.g. a mapped file or one chunk of it
+    void parse(const char *data, size_t size, const GameHandler &onGame);
+
+    size_t getGamesParsed() const { return gamesParsed; }
+    size_t getMovesParsed() const { return movesParsed; }
+    size_t getGamesWithErrors() const { return gamesWithErrors; }
+    unsigned long long getBytesParsed() const { return bytesParsed; }
+
+private:
+    vector<vector<int>> board;
+    vector<vector<int>> startBoard; // Copied over board for every game, which reuses its rows
+    GameLogic logic;                // Rules only, refers to board
+    bool whiteToMove;
+    FenPosition fenPosition; // Start of a game with a FEN tag
+
+    PgnGame game;
+    string san; // The token being resolved; sanToMove takes a string
+    const GameHandler *handler;
+
+    // Tokenizer state that carries over between buffers
+    bool gameStarted;   // Tags or movetext of the current game have been seen
+    bool hasMovetext;   // A tag pair after movetext starts the next game
+    bool inComment;     // Inside { ... }, which may span lines
+    bool lineStart;     // Nothing but whitespace so far on this line
+    int variationDepth; // Nesting of ( ... )
+    bool stopped;       // The handler asked to stop
+
+    size_t gamesParsed;
+    size_t movesParsed;
+    size_t gamesWithErrors;
+    unsigned long long bytesParsed;
+
+    void reset(); // Forget any partly read game before a new input
+    void feed(const char *begin, const char *end);
+    void finish(); // End of input: hand out a game that was still open
+    const char *readTag(const char *p, const char *end);
+    void readToken(const char *token, size_t length);
+    void startGame();
+    void endGame();
+};
+
+#endif // PGNPARSER_H
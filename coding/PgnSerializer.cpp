@@ -0,0 +1,117 @@
+#include "PgnSerializer.h"
+#include "Fen.h"
+#include <ctime>
+
+using namespace std;
+
+void PgnSerializer::appendHeader(string &out, const string &date, const string &result, const string &fen)
+{
+    out += "[Event \"Chess Game\"]\n";
+    out += "[Site \"Local Game\"]\n";
+    out += "[Date \"";
+    out += date;
+    out += "\"]\n";
+    out += "[Round \"1\"]\n";
+    out += "[White \"Player 1\"]\n";
+    out += "[Black \"Player 2\"]\n";
+    out += "[Result \"";
+    out += result;
+    out += "\"]\n";
+    if (!fen.empty())
+    {
+        out += "[SetUp \"1\"]\n";
+        appendTag(out, "FEN", fen);
+    }
+    out += '\n';
+}
+
+void PgnSerializer::appendTag(string &out, const string &name, const string &value)
+{
+    out += '[';
+    out += name;
+    out += " \"";
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    out += "\"]\n";
+}
+
+void PgnSerializer::appendMove(string &out, size_t ply, const string &san, size_t &lineLength, bool firstMove)
+{
+    // Move number for White's moves, built in place rather than with to_string
+    char number[24];
+    size_t digits = 0;
+    if (ply % 2 == 0 || firstMove)
+    {
+        char reversed[20];
+        size_t count = 0;
+        size_t moveNumber = ply / 2 + 1;
+        do
+        {
+            reversed[count++] = static_cast<char>('0' + moveNumber % 10);
+            moveNumber /= 10;
+        } while (moveNumber > 0);
+        while (count > 0)
+        {
+            number[digits++] = reversed[--count];
+        }
+        number[digits++] = '.';
+        if (ply % 2 == 1) // A game set up with Black to move opens with "12..."
+        {
+            number[digits++] = '.';
+            number[digits++] = '.';
+        }
+        number[digits++] = ' ';
+    }
+
+    // Handle line wrapping for better readability
+    size_t length = digits + san.length() + 1;
+    if (lineLength + length > LINE_WIDTH)
+    {
+        out += '\n';
+        lineLength = 0;
+    }
+
+    out.append(number, digits);
+    out += san;
+    out += ' ';
+    lineLength += length;
+}
+
+void PgnSerializer::writeGame(string &out, const string &date, const vector<string> &moves, const string &result,
+                              const string &fen)
+{
+    out.clear();
+    appendHeader(out, date, result, fen);
+
+    size_t lineLength = 0;
+    size_t ply = firstPly(fen);
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        appendMove(out, ply + i, moves[i], lineLength, i == 0);
+    }
+
+    // Add result at the end
+    out += result;
+}
+
+size_t PgnSerializer::firstPly(const string &fen)
+{
+    FenPosition position;
+    string error;
+    if (fen.empty() || !Fen::parse(fen, position, error))
+        return 0;
+    return static_cast<size_t>(position.fullmoveNumber - 1) * 2 + (position.whiteToMove ? 0 : 1);
+}
+
+string PgnSerializer::today()
+{
+    time_t now = time(0);
+    tm *ltm = localtime(&now);
+    return to_string(1900 + ltm->tm_year) + "." +
+           (ltm->tm_mon + 1 < 10 ? "0" : "") + to_string(ltm->tm_mon + 1) + "." +
+           (ltm->tm_mday < 10 ? "0" : "") + to_string(ltm->tm_mday);
+}
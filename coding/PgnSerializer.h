@@ -0,0 +1,41 @@
+#ifndef PGNSERIALIZER_H
+#define PGNSERIALIZER_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The one place PGN text is produced: GameLogic::writePGN for a whole game and
+// PgnWriter for the file kept during play both go through it, so the two can't
+// drift apart. Everything is appended to a string the caller keeps; once that
+// buffer has grown to the size of a game, writing another one allocates nothing.
+class PgnSerializer
+{
+public:
+    static const size_t LINE_WIDTH = 80;
+
+    // The tag section with this game's fixed tags, followed by the blank line. A game
+    // set up from a position also gets the SetUp and FEN tags
+    static void appendHeader(string &out, const string &date, const string &result, const string &fen = "");
+
+    // One tag pair of any name, with quotes and backslashes in the value escaped
+    static void appendTag(string &out, const string &name, const string &value);
+
+    // One move of the movetext: the move number before White's moves, a space after
+    // every move, and a line break first if the move would run past LINE_WIDTH.
+    // ply counts from 0; lineLength carries the current line's length between calls.
+    // The first move of a game is numbered even when it is Black's ("12... Nf6").
+    static void appendMove(string &out, size_t ply, const string &san, size_t &lineLength, bool firstMove = false);
+
+    // A whole game, from the start position or from fen; out is cleared but keeps its capacity
+    static void writeGame(string &out, const string &date, const vector<string> &moves, const string &result,
+                          const string &fen = "");
+
+    // The ply a game set up from fen starts at, as appendMove counts them; 0 if fen is empty
+    static size_t firstPly(const string &fen);
+
+    static string today(); // YYYY.MM.DD
+};
+
+#endif // PGNSERIALIZER_H
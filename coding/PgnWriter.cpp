@@ -0,0 +1,512 @@
+#include "PgnWriter.h"
+#include "PgnSerializer.h"
+#include "PgnParser.h"
+#include "GameArchive.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <iterator>
+#ifdef _WIN32
+#define _HAS_STD_BYTE 0 // Prevent std::byte conflicts
+#include <windows.h>
+#include <io.h> // _commit
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+using namespace std;
+
+static const int COALESCE_MS = 100; // How long the writer waits for more events before writing
+static const char JOURNAL_MAGIC[4] = {'C', 'P', 'J', '1'};
+
+bool PgnWriter::syncFile(FILE *file)
+{
+    if (fflush(file) != 0)
+        return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Helper function to replace a file with another in one step: afterwards the
+// target is either the old file or the new one, never a mix or nothing
+static bool replaceFile(const string &from, const string &to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (rename(from.c_str(), to.c_str()) != 0)
+        return false;
+
+    // The new name only survives a power cut once the directory is on disk too
+    size_t slash = to.find_last_of('/');
+    string directory = slash == string::npos ? "." : (slash == 0 ? "/" : to.substr(0, slash));
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+    return true;
+#endif
+}
+
+bool PgnWriter::writeFileAtomically(const string &path, const string &contents)
+{
+    string temporary = path + ".tmp";
+    FILE *file = fopen(temporary.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size() && syncFile(file);
+    ok = fclose(file) == 0 && ok;
+    if (!ok || !replaceFile(temporary, path))
+    {
+        remove(temporary.c_str()); // The old file is still there, untouched
+        return false;
+    }
+    return true;
+}
+
+// Helper function to add a journal record: type, length, text, checksum.
+// The checksum catches a record that was only partly written when the process died.
+static void appendRecord(string &out, char type, const string &text)
+{
+    string record;
+    record += type;
+    record += static_cast<char>(min<size_t>(text.size(), 255));
+    record.append(text, 0, 255);
+    unsigned char sum = 0;
+    for (char c : record)
+    {
+        sum = static_cast<unsigned char>(sum * 31 + static_cast<unsigned char>(c));
+    }
+    record += static_cast<char>(sum);
+    out += record;
+}
+
+PgnWriter::PgnWriter(const string &path, const string &archivePath)
+    : posted(0), completed(0), flushRequested(false), stopping(false), path(path),
+      journalPath(path + ".journal"), journal(nullptr),
+      firstPly(0), result("*"), moveCount(0), lineLength(0), movetextOffset(0), rewriteNeeded(false),
+      archivePath(archivePath), archiveJournalPath(archivePath + ".journal"), archivePending(false)
+{
+    recover();
+    recoverArchive();
+    writer = thread(&PgnWriter::run, this);
+}
+
+PgnWriter::~PgnWriter()
+{
+    {
+        lock_guard<mutex> lock(eventMutex);
+        stopping = true;
+    }
+    eventsChanged.notify_all();
+    writer.join();
+}
+
+void PgnWriter::newGame(const string &fen)
+{
+    Event event;
+    event.type = Event::NewGame;
+    event.text = PgnSerializer::today(); // localtime is not thread safe, so the date is taken here
+    if (!fen.empty())
+        event.text += " " + fen; // The date has no spaces
+    lock_guard<mutex> lock(eventMutex);
+    events.push_back(event);
+    posted++;
+    eventsChanged.notify_all();
+}
+
+void PgnWriter::addMove(const string &san)
+{
+    Event event;
+    event.type = Event::Move;
+    event.text = san;
+    lock_guard<mutex> lock(eventMutex);
+    events.push_back(event);
+    posted++;
+    eventsChanged.notify_all();
+}
+
+void PgnWriter::setResult(const string &result)
+{
+    Event event;
+    event.type = Event::Result;
+    event.text = result;
+    lock_guard<mutex> lock(eventMutex);
+    events.push_back(event);
+    posted++;
+    eventsChanged.notify_all();
+}
+
+void PgnWriter::flush()
+{
+    unique_lock<mutex> lock(eventMutex);
+    size_t target = posted;
+    flushRequested = true;
+    eventsChanged.notify_all();
+    eventsChanged.wait(lock, [&]()
+                       { return completed >= target; });
+}
+
+void PgnWriter::run()
+{
+    vector<Event> batch;
+    unique_lock<mutex> lock(eventMutex);
+    while (true)
+    {
+        eventsChanged.wait(lock, [&]()
+                           { return stopping || !events.empty(); });
+        if (events.empty())
+            break; // Stopping with nothing left to write
+
+        // Give the rest of a burst time to arrive, unless someone is waiting for the file
+        eventsChanged.wait_for(lock, chrono::milliseconds(COALESCE_MS), [&]()
+                               { return stopping || flushRequested; });
+        flushRequested = false;
+        batch.swap(events);
+        lock.unlock();
+
+        // The journal is on disk before the PGN changes, so a crash during the write loses nothing
+        journalEvents(batch);
+        for (const Event &event : batch)
+        {
+            apply(event);
+        }
+        write();
+        if (archivePending)
+            archive();
+
+        lock.lock();
+        completed += batch.size();
+        batch.clear();
+        eventsChanged.notify_all();
+    }
+    lock.unlock();
+
+    // Clean exit: make the PGN whole and durable, then the journal is no longer needed
+    if (journal)
+    {
+        fclose(journal);
+        journal = nullptr;
+        if (rewrite())
+        {
+            remove(journalPath.c_str());
+        }
+    }
+
+    // The archive's last block is only partly filled; it is written now
+    if (archiveWriter)
+    {
+        if (archiveWriter->close())
+            remove(archiveJournalPath.c_str());
+        else
+            cerr << "Warning: Could not write the last games to " << archivePath << endl;
+        archiveWriter.reset();
+    }
+}
+
+void PgnWriter::journalEvents(const vector<Event> &batch)
+{
+    string records;
+    bool restart = false;
+    for (const Event &event : batch)
+    {
+        char type = event.type == Event::NewGame ? 'G' : (event.type == Event::Move ? 'M' : 'R');
+        if (event.type == Event::NewGame)
+        {
+            // Only the running game is journalled; the previous one is complete in the PGN
+            restart = true;
+            records.clear();
+        }
+        appendRecord(records, type, event.text);
+    }
+
+    if (restart || !journal)
+    {
+        if (journal)
+            fclose(journal);
+        journal = fopen(journalPath.c_str(), restart ? "wb" : "ab");
+        if (journal && restart)
+            fwrite(JOURNAL_MAGIC, 1, sizeof(JOURNAL_MAGIC), journal);
+    }
+    if (!journal || fwrite(records.data(), 1, records.size(), journal) != records.size() || !syncFile(journal))
+    {
+        cerr << "Warning: Could not write the move journal " << journalPath << endl;
+    }
+}
+
+void PgnWriter::recover()
+{
+    FILE *file = fopen(journalPath.c_str(), "rb");
+    if (!file)
+        return; // The last session closed cleanly
+
+    string data;
+    char chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.append(chunk, read);
+    }
+    fclose(file);
+
+    // Replay records up to the first incomplete or damaged one
+    size_t pos = sizeof(JOURNAL_MAGIC);
+    bool started = false;
+    if (data.compare(0, sizeof(JOURNAL_MAGIC), string(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC))) == 0)
+    {
+        while (pos + 3 <= data.size())
+        {
+            size_t length = static_cast<unsigned char>(data[pos + 1]);
+            if (pos + 3 + length > data.size())
+                break;
+            string record = data.substr(pos, 2 + length);
+            string checked;
+            appendRecord(checked, record[0], record.substr(2));
+            if (checked.back() != data[pos + 2 + length])
+                break;
+
+            Event event;
+            event.text = record.substr(2);
+            if (record[0] == 'G')
+                event.type = Event::NewGame;
+            else if (record[0] == 'M')
+                event.type = Event::Move;
+            else if (record[0] == 'R')
+                event.type = Event::Result;
+            else
+                break;
+            if (event.type == Event::NewGame)
+                started = true;
+            if (started)
+                apply(event);
+            pos += 3 + length;
+        }
+    }
+
+    if (!started || moveCount == 0)
+    {
+        remove(journalPath.c_str()); // Nothing worth keeping
+        return;
+    }
+
+    // The PGN may be missing moves or cut off mid-append; rebuild it, and keep a copy
+    // of the game that the new session's first game cannot overwrite
+    cout << "Recovered " << moveCount << " moves of an unfinished game from " << journalPath << endl;
+    rewrite();
+    string recoveredPath = path;
+    if (recoveredPath.size() > 4 && recoveredPath.compare(recoveredPath.size() - 4, 4, ".pgn") == 0)
+        recoveredPath.resize(recoveredPath.size() - 4);
+    recoveredPath += "_recovered.pgn";
+    FILE *recovered = fopen(recoveredPath.c_str(), "ab");
+    buffer.clear();
+    PgnSerializer::appendHeader(buffer, date, result, startFen);
+    buffer += movetext;
+    buffer += result;
+    buffer += "\n\n";
+    bool saved = recovered && fwrite(buffer.data(), 1, buffer.size(), recovered) == buffer.size() && syncFile(recovered);
+    if (recovered)
+        fclose(recovered);
+    if (saved)
+    {
+        remove(journalPath.c_str());
+        cout << "Recovered game saved to " << recoveredPath << endl;
+    }
+    else
+    {
+        cerr << "Warning: Could not save the recovered game to " << recoveredPath << endl;
+    }
+    rewriteNeeded = false;
+    unwritten.clear();
+    archivePending = false; // The game may have been archived before the crash
+}
+
+void PgnWriter::apply(const Event &event)
+{
+    switch (event.type)
+    {
+    case Event::NewGame:
+    {
+        // A finished game posted in the same burst goes into the archive before it is replaced
+        if (archivePending)
+            archive();
+
+        size_t space = event.text.find(' ');
+        date = event.text.substr(0, space);
+        startFen = space == string::npos ? "" : event.text.substr(space + 1);
+        firstPly = PgnSerializer::firstPly(startFen);
+        result = "*";
+        movetext.clear();
+        unwritten.clear();
+        moveCount = 0;
+        lineLength = 0;
+        rewriteNeeded = true;
+        archivePending = false;
+        break;
+    }
+
+    case Event::Move:
+    {
+        size_t start = movetext.length();
+        PgnSerializer::appendMove(movetext, firstPly + moveCount, event.text, lineLength, moveCount == 0);
+        unwritten.append(movetext, start, string::npos);
+        moveCount++;
+        break;
+    }
+
+    case Event::Result:
+        if (event.text != result)
+        {
+            result = event.text;
+            rewriteNeeded = true; // The header holds the result too
+            archivePending = !archivePath.empty() && result != "*" && moveCount > 0;
+        }
+        break;
+    }
+}
+
+bool PgnWriter::rewrite()
+{
+    buffer.clear();
+    PgnSerializer::appendHeader(buffer, date, result, startFen);
+    size_t headerLength = buffer.length();
+    buffer += movetext;
+    buffer += result;
+    if (!writeFileAtomically(path, buffer))
+        return false;
+
+    movetextOffset = headerLength;
+    return true;
+}
+
+void PgnWriter::write()
+{
+    if (rewriteNeeded)
+    {
+        if (!rewrite())
+        {
+            cerr << "Warning: Could not write " << path << ". It may be in use by another process." << endl;
+            return; // Tried again with the next event
+        }
+        rewriteNeeded = false;
+        unwritten.clear();
+        return;
+    }
+    if (unwritten.empty())
+        return;
+
+    // The file ends with movetext and the result token; the new moves go where the
+    // result was and the result follows them, so the file only ever grows. This is
+    // not atomic, but the journal already holds the moves if it is interrupted
+    fstream file(path, ios::in | ios::out | ios::binary);
+    size_t end = movetextOffset + movetext.length() - unwritten.length();
+    if (!file.is_open() || !file.seekp(end) || !(file << unwritten << result))
+    {
+        cerr << "Warning: Could not append to " << path << ", rewriting it" << endl;
+        rewriteNeeded = true; // The next write starts over
+        return;
+    }
+    unwritten.clear();
+}
+
+void PgnWriter::recoverArchive()
+{
+    FILE *file = archivePath.empty() ? nullptr : fopen(archiveJournalPath.c_str(), "rb");
+    if (!file)
+        return; // Every archived game is in a written block
+    fclose(file);
+    openArchive();
+}
+
+bool PgnWriter::openArchive()
+{
+    archiveWriter.reset(new GameArchiveWriter());
+    if (!archiveWriter->openAppend(archivePath))
+    {
+        cerr << "Warning: Could not open " << archivePath << endl;
+        archiveWriter.reset();
+        return false;
+    }
+
+    // Games the last session left in the journal were never in a written block, unless
+    // the block made it into the index after all; the journal starts with the number
+    // its first game has in the archive, which tells the two apart
+    ifstream journalFile(archiveJournalPath, ios::binary);
+    if (!journalFile.is_open())
+        return true;
+    uint64_t firstGame = 0;
+    string games;
+    if (journalFile >> firstGame && getline(journalFile, games) && firstGame == archiveWriter->getGameCount())
+    {
+        games.assign(istreambuf_iterator<char>(journalFile), istreambuf_iterator<char>());
+        size_t recovered = 0;
+        PgnParser parser;
+        parser.parse(games.data(), games.size(), [&](const PgnGame &game)
+                     {
+                         archiveWriter->addGame(game);
+                         recovered++;
+                         return true;
+                     });
+        cout << "Recovered " << recovered << " games for " << archivePath << " from " << archiveJournalPath << endl;
+
+        // Unless they filled the block the crash interrupted, they stay in memory and in the journal
+        if (archiveWriter->getUnwrittenGames() > 0 || !archiveWriter->writeIndex())
+            return true;
+    }
+    journalFile.close();
+    remove(archiveJournalPath.c_str());
+    return true;
+}
+
+void PgnWriter::archive()
+{
+    archivePending = false;
+    if (!archiveWriter && !openArchive())
+        return;
+
+    // The game goes in as it reads in the PGN, through the same parser as any imported game
+    buffer.clear();
+    PgnSerializer::appendHeader(buffer, date, result, startFen);
+    buffer += movetext;
+    buffer += result;
+    buffer += "\n\n";
+
+    // Until its block is written the game is only in memory, so it goes in the journal first;
+    // a journal for a new block starts with the number the block's first game gets
+    bool newBlock = archiveWriter->getUnwrittenGames() == 0;
+    string record = newBlock ? to_string(archiveWriter->getGameCount()) + "\n" + buffer : buffer;
+    FILE *journalFile = fopen(archiveJournalPath.c_str(), newBlock ? "wb" : "ab");
+    if (!journalFile || fwrite(record.data(), 1, record.size(), journalFile) != record.size() || !syncFile(journalFile))
+    {
+        cerr << "Warning: Could not write the archive journal " << archiveJournalPath << endl;
+    }
+    if (journalFile)
+        fclose(journalFile);
+
+    bool ok = true;
+    PgnParser parser;
+    parser.parse(buffer.data(), buffer.size(), [&](const PgnGame &game)
+                 {
+                     ok = archiveWriter->addGame(game) && ok;
+                     return false;
+                 });
+
+    // A full block was compressed and written; once the index lists it, the journal has done its job
+    if (archiveWriter->getUnwrittenGames() == 0)
+    {
+        ok = archiveWriter->writeIndex() && ok;
+        if (ok)
+            remove(archiveJournalPath.c_str());
+    }
+    if (!ok)
+    {
+        cerr << "Warning: Could not add the game to " << archivePath << endl;
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef PGNWRITER_H
+#define PGNWRITER_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+using namespace std;
+
+class GameArchiveWriter;
+
+// Keeps the PGN of the running game on disk from a background thread, so the
+// game loop never waits for the file system. The game posts events (new game,
+// a move in SAN, the result) and returns at once; the writer waits a moment so
+// a burst of events (a move and the engine's reply) becomes one write, then
+// appends just the new moves in place of the old result token. The whole file
+// is only rewritten when a game starts or the result in the header changes.
+//
+// Rewrites go to a temporary file that is synced and renamed over the PGN, so
+// the file on disk is always a whole game. Every event is also appended to a
+// small binary journal and synced before the PGN is touched. A journal left
+// behind by a crash is replayed at the next start: the PGN is rebuilt from it
+// and the game is added to <name>_recovered.pgn before a new game replaces it.
+//
+// With an archive path, each game that ends with a result is also added to that
+// compressed game archive (see GameArchive), from the same thread. The archive stays
+// open: games collect in its current block, which is only compressed and indexed
+// when it is full or the writer stops. Until then its games are kept in a second
+// journal next to the archive, and a crash's leftovers go back in at the next start.
+class PgnWriter
+{
+private:
+    struct Event
+    {
+        enum Type
+        {
+            NewGame,
+            Move,
+            Result
+        } type;
+        string text; // Date and any start FEN for NewGame, SAN for Move, "1-0" ... for Result
+    };
+
+    // Shared with the writer thread
+    vector<Event> events;
+    mutex eventMutex;
+    condition_variable eventsChanged;
+    size_t posted;    // Events posted so far
+    size_t completed; // Events written to disk (or given up on) so far
+    bool flushRequested;
+    bool stopping;
+    thread writer;
+    string path;
+    string journalPath;
+    FILE *journal; // Writer thread only, null until the first game
+
+    // Writer thread only: the game as it is on disk
+    string date;
+    string startFen; // Empty for a game from the standard start
+    size_t firstPly; // Where the move numbers start, see PgnSerializer::firstPly
+    string result;
+    string movetext;       // Moves with numbers and line breaks, each followed by a space
+    string unwritten;      // Tail of movetext not yet appended to the file
+    size_t moveCount;
+    size_t lineLength;
+    size_t movetextOffset; // Where movetext starts in the file
+    bool rewriteNeeded;
+    string buffer; // Reused for every rewrite
+    string archivePath;
+    string archiveJournalPath;
+    unique_ptr<GameArchiveWriter> archiveWriter; // Writer thread only, null until the first finished game
+    bool archivePending; // The game has its result and is not in the archive yet
+
+    void run();
+    void apply(const Event &event);
+    void journalEvents(const vector<Event> &batch);
+    void write();
+    bool rewrite();
+    void recover();
+    void recoverArchive();
+    bool openArchive();
+    void archive();
+
+public:
+    explicit PgnWriter(const string &path, const string &archivePath = "");
+    ~PgnWriter(); // Writes whatever is still queued
+
+    void newGame(const string &fen = ""); // From the standard start unless fen is given
+    void addMove(const string &san);
+    void setResult(const string &result);
+
+    // Block until everything posted so far is on disk, e.g. before another program reads the file
+    void flush();
+
+    // Write a whole file through a synced temporary file and a rename, so it is
+    // never seen half written; also used for other files that must not be torn
+    static bool writeFileAtomically(const string &path, const string &contents);
+
+    // Push everything written to a stdio file onto the disk
+    static bool syncFile(FILE *file);
+};
+
+#endif // PGNWRITER_H
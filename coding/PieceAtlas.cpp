@@ -0,0 +1,196 @@
+#include "PieceAtlas.h"
+#include "AssetLoader.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+using namespace sf;
+
+static const unsigned int ATLAS_PADDING = 2; // Transparent border around each cell to stop filtering bleed
+
+PieceAtlas::PieceAtlas() : cellSize(0), loaded(false)
+{
+}
+
+// Helper function to get the file of a piece image, indexed like pieceIndex
+static string pieceImagePath(const string &directory, int index)
+{
+    static const string pieceNames[6] = {"Pawn", "Rook", "Knight", "Bishop", "Queen", "King"};
+    return directory + (index < 6 ? "/black" : "/white") + pieceNames[index % 6] + ".png";
+}
+
+void PieceAtlas::requestImages(const string &directory, AssetLoader &loader)
+{
+    for (int i = 0; i < 12; i++)
+    {
+        loader.requestImage(pieceImagePath(directory, i));
+    }
+}
+
+bool PieceAtlas::loadImages(const string &directory, AssetLoader *loader)
+{
+    for (int i = 0; i < 12; i++)
+    {
+        string path = pieceImagePath(directory, i);
+        bool ok = loader ? loader->takeImage(path, sources[i]) : sources[i].loadFromFile(path);
+        if (!ok)
+        {
+            cout << "Failed to load " << path << endl;
+            return false;
+        }
+    }
+
+    loaded = true;
+    return true;
+}
+
+bool PieceAtlas::build(unsigned int cellSize, bool mipmaps, bool uploadTexture)
+{
+    if (!loaded || cellSize == 0)
+        return false;
+
+    // Six piece types across, black on the top row and white below
+    unsigned int stride = cellSize + 2 * ATLAS_PADDING;
+    image.create(6 * stride, 2 * stride, Color::Transparent);
+
+    for (int i = 0; i < 12; i++)
+    {
+        Vector2u size = sources[i].getSize();
+        if (size.x == 0 || size.y == 0)
+            return false;
+
+        // Fit the longer side to the cell, keep the aspect ratio
+        float fit = static_cast<float>(cellSize) / max(size.x, size.y);
+        unsigned int width = max(1u, static_cast<unsigned int>(size.x * fit + 0.5f));
+        unsigned int height = max(1u, static_cast<unsigned int>(size.y * fit + 0.5f));
+        unsigned int x = (i % 6) * stride + ATLAS_PADDING;
+        unsigned int y = (i / 6) * stride + ATLAS_PADDING;
+
+        downscale(sources[i], image, x, y, width, height);
+        rects[i] = IntRect(x, y, width, height);
+    }
+
+    if (uploadTexture)
+    {
+        if (!texture.loadFromImage(image))
+        {
+            cerr << "Could not create the piece atlas texture" << endl;
+            return false;
+        }
+        texture.setSmooth(true);
+        if (mipmaps && !texture.generateMipmap())
+        {
+            cerr << "Mipmaps not available, piece atlas uses plain filtering" << endl;
+        }
+    }
+
+    this->cellSize = cellSize;
+    return true;
+}
+
+void PieceAtlas::downscale(const Image &source, Image &target, unsigned int targetX, unsigned int targetY,
+                           unsigned int width, unsigned int height)
+{
+    // Box filter: every target pixel averages the block of source pixels it covers.
+    // Colour is weighted by alpha so transparent edges don't turn dark.
+    Vector2u size = source.getSize();
+    const Uint8 *pixels = source.getPixelsPtr();
+
+    for (unsigned int ty = 0; ty < height; ty++)
+    {
+        unsigned int sy0 = ty * size.y / height;
+        unsigned int sy1 = max(sy0 + 1, (ty + 1) * size.y / height);
+        for (unsigned int tx = 0; tx < width; tx++)
+        {
+            unsigned int sx0 = tx * size.x / width;
+            unsigned int sx1 = max(sx0 + 1, (tx + 1) * size.x / width);
+
+            Uint64 r = 0, g = 0, b = 0, a = 0, count = 0;
+            for (unsigned int sy = sy0; sy < sy1; sy++)
+            {
+                const Uint8 *row = pixels + (sy * size.x + sx0) * 4;
+                for (unsigned int sx = sx0; sx < sx1; sx++, row += 4)
+                {
+                    r += row[0] * row[3];
+                    g += row[1] * row[3];
+                    b += row[2] * row[3];
+                    a += row[3];
+                    count++;
+                }
+            }
+
+            Color color = Color::Transparent;
+            if (a > 0)
+            {
+                color = Color(static_cast<Uint8>(r / a), static_cast<Uint8>(g / a),
+                              static_cast<Uint8>(b / a), static_cast<Uint8>(a / count));
+            }
+            target.setPixel(targetX + tx, targetY + ty, color);
+        }
+    }
+}
+
+unsigned int PieceAtlas::cellSizeFor(float pieceWidth)
+{
+    unsigned int cellSize = 64;
+    while (cellSize < pieceWidth && cellSize < 512)
+    {
+        cellSize *= 2;
+    }
+    return cellSize;
+}
+
+int PieceAtlas::pieceIndex(int pieceValue)
+{
+    int index;
+    switch (abs(pieceValue))
+    {
+    case 10:
+        index = 0;
+        break; // Pawn
+    case 6:
+        index = 1;
+        break; // Rook
+    case 8:
+        index = 2;
+        break; // Knight
+    case 7:
+        index = 3;
+        break; // Bishop
+    case 11:
+        index = 4;
+        break; // Queen
+    case 9:
+        index = 5;
+        break; // King
+    default:
+        return -1;
+    }
+    return pieceValue > 0 ? index + 6 : index;
+}
+
+void PieceAtlas::appendPiece(VertexArray &vertices, int pieceValue, float centerX, float centerY, float width,
+                             const Color &color) const
+{
+    int index = pieceIndex(pieceValue);
+    if (index < 0 || cellSize == 0)
+        return;
+
+    const IntRect &rect = rects[index];
+    float height = width * rect.height / rect.width;
+    float left = centerX - width / 2;
+    float top = centerY - height / 2;
+
+    Vertex topLeft(Vector2f(left, top), color, Vector2f(rect.left, rect.top));
+    Vertex topRight(Vector2f(left + width, top), color, Vector2f(rect.left + rect.width, rect.top));
+    Vertex bottomRight(Vector2f(left + width, top + height), color, Vector2f(rect.left + rect.width, rect.top + rect.height));
+    Vertex bottomLeft(Vector2f(left, top + height), color, Vector2f(rect.left, rect.top + rect.height));
+
+    vertices.append(topLeft);
+    vertices.append(topRight);
+    vertices.append(bottomRight);
+    vertices.append(topLeft);
+    vertices.append(bottomRight);
+    vertices.append(bottomLeft);
+}
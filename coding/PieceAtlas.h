@@ -0,0 +1,61 @@
+#ifndef PIECEATLAS_H
+#define PIECEATLAS_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+
+using namespace std;
+using namespace sf;
+
+class AssetLoader;
+
+// All twelve piece images packed into one texture, so every piece on the
+// board can be drawn from a single vertex array with a single draw call.
+// Source images are kept in memory so the atlas can be rebuilt at another
+// cell size (for example after a large window resize) without disk access.
+class PieceAtlas
+{
+private:
+    Image sources[12]; // Full-size piece images, indexed by pieceIndex
+    Texture texture;
+    Image image;       // CPU copy of the texture, for rendering without a GPU
+    IntRect rects[12]; // Where each piece ended up in the texture
+    unsigned int cellSize;
+    bool loaded;
+
+    static void downscale(const Image &source, Image &target, unsigned int targetX, unsigned int targetY,
+                          unsigned int width, unsigned int height);
+
+public:
+    PieceAtlas();
+
+    // Load the piece PNGs (blackPawn.png ... whiteKing.png) from a directory, or collect
+    // them from a loader that was given them earlier with requestImages
+    bool loadImages(const string &directory, AssetLoader *loader = nullptr);
+    static void requestImages(const string &directory, AssetLoader &loader);
+
+    // Pack the loaded images into the texture, each scaled to fit a cellSize square.
+    // Mipmaps keep pieces smooth when they are drawn much smaller than the cell.
+    // With uploadTexture false only the CPU image is built (no graphics context needed).
+    bool build(unsigned int cellSize, bool mipmaps = true, bool uploadTexture = true);
+
+    // Cell size for pieces drawn pieceWidth pixels wide on screen: the next power of two
+    // above it (64 to 512), so pieces are only ever minified (with mipmaps)
+    static unsigned int cellSizeFor(float pieceWidth);
+
+    // 0-5 black pawn, rook, knight, bishop, queen, king; 6-11 the same for white; -1 if empty
+    static int pieceIndex(int pieceValue);
+
+    // Append a piece as two textured triangles, centred on (centerX, centerY).
+    // Like the old sprites, the width is fixed and the height follows the image.
+    void appendPiece(VertexArray &vertices, int pieceValue, float centerX, float centerY, float width,
+                     const Color &color = Color::White) const;
+
+    const Texture &getTexture() const { return texture; }
+    const Image &getImage() const { return image; }
+    const IntRect &getRect(int index) const { return rects[index]; }
+    unsigned int getCellSize() const { return cellSize; }
+    bool isLoaded() const { return loaded; }
+};
+
+#endif // PIECEATLAS_H
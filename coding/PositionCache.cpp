@@ -0,0 +1,190 @@
+#include "PositionCache.h"
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+static const char CACHE_MAGIC[4] = {'C', 'P', 'C', '1'};
+
+// Helpers for the binary cache file
+template <typename T>
+static void writeValue(ofstream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(ifstream &in, T &value)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+static void writeString(ofstream &out, const string &value)
+{
+    uint16_t length = static_cast<uint16_t>(value.size() > 0xFFFF ? 0xFFFF : value.size());
+    writeValue(out, length);
+    out.write(value.data(), length);
+}
+
+static bool readString(ifstream &in, string &value)
+{
+    uint16_t length;
+    if (!readValue(in, length))
+        return false;
+    value.resize(length);
+    return length == 0 || static_cast<bool>(in.read(&value[0], length));
+}
+
+PositionCache::PositionCache(size_t capacity)
+    : capacity(capacity > 0 ? capacity : 1), hits(0), misses(0)
+{
+}
+
+bool PositionCache::lookup(uint64_t hash, SearchLimit limit, int limitValue, int skillLevel, CachedSearch &result)
+{
+    lock_guard<mutex> lock(cacheMutex);
+
+    Key key = {hash, limit, limitValue, skillLevel};
+    auto it = index.find(key);
+    if (it == index.end())
+    {
+        misses++;
+        return false;
+    }
+
+    // Move to the front of the LRU list
+    entries.splice(entries.begin(), entries, it->second);
+    result = it->second->second;
+    hits++;
+    return true;
+}
+
+void PositionCache::store(uint64_t hash, SearchLimit limit, int limitValue, int skillLevel, const CachedSearch &result)
+{
+    if (result.bestMove.empty())
+        return;
+
+    lock_guard<mutex> lock(cacheMutex);
+    Key key = {hash, limit, limitValue, skillLevel};
+    insertLocked(key, result);
+}
+
+void PositionCache::insertLocked(const Key &key, const CachedSearch &result)
+{
+    auto it = index.find(key);
+    if (it != index.end())
+    {
+        it->second->second = result;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+
+    entries.emplace_front(key, result);
+    index[key] = entries.begin();
+
+    // Evict the least recently used entries
+    while (entries.size() > capacity)
+    {
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+void PositionCache::clear()
+{
+    lock_guard<mutex> lock(cacheMutex);
+    entries.clear();
+    index.clear();
+    hits = 0;
+    misses = 0;
+}
+
+size_t PositionCache::size() const
+{
+    lock_guard<mutex> lock(cacheMutex);
+    return entries.size();
+}
+
+size_t PositionCache::getHits() const
+{
+    lock_guard<mutex> lock(cacheMutex);
+    return hits;
+}
+
+size_t PositionCache::getMisses() const
+{
+    lock_guard<mutex> lock(cacheMutex);
+    return misses;
+}
+
+bool PositionCache::loadFromFile(const string &path)
+{
+    ifstream in(path, ios::binary);
+    if (!in.is_open())
+        return false; // No cache file yet is not an error worth reporting
+
+    char magic[4];
+    uint32_t count;
+    if (!in.read(magic, 4) || string(magic, 4) != string(CACHE_MAGIC, 4) || !readValue(in, count))
+    {
+        cerr << "Ignoring invalid position cache file: " << path << endl;
+        return false;
+    }
+
+    lock_guard<mutex> lock(cacheMutex);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Key key;
+        int32_t limit, limitValue, skillLevel, score, depth;
+        uint8_t flags;
+        CachedSearch result;
+        if (!readValue(in, key.hash) || !readValue(in, limit) || !readValue(in, limitValue) ||
+            !readValue(in, skillLevel) || !readValue(in, flags) || !readValue(in, score) ||
+            !readValue(in, depth) || !readString(in, result.bestMove) || !readString(in, result.pv))
+        {
+            cerr << "Position cache file truncated after " << i << " entries" << endl;
+            return i > 0;
+        }
+        key.limit = static_cast<SearchLimit>(limit);
+        key.limitValue = limitValue;
+        key.skillLevel = skillLevel;
+        result.hasScore = (flags & 1) != 0;
+        result.scoreIsMate = (flags & 2) != 0;
+        result.score = score;
+        result.depth = depth;
+        insertLocked(key, result); // File is oldest first, so the newest ends up in front
+    }
+
+    return true;
+}
+
+bool PositionCache::saveToFile(const string &path) const
+{
+    lock_guard<mutex> lock(cacheMutex);
+
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.is_open())
+    {
+        cerr << "Could not write position cache file: " << path << endl;
+        return false;
+    }
+
+    out.write(CACHE_MAGIC, 4);
+    writeValue(out, static_cast<uint32_t>(entries.size()));
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it)
+    {
+        const Key &key = it->first;
+        const CachedSearch &result = it->second;
+        writeValue(out, key.hash);
+        writeValue(out, static_cast<int32_t>(key.limit));
+        writeValue(out, static_cast<int32_t>(key.limitValue));
+        writeValue(out, static_cast<int32_t>(key.skillLevel));
+        writeValue(out, static_cast<uint8_t>((result.hasScore ? 1 : 0) | (result.scoreIsMate ? 2 : 0)));
+        writeValue(out, static_cast<int32_t>(result.score));
+        writeValue(out, static_cast<int32_t>(result.depth));
+        writeString(out, result.bestMove);
+        writeString(out, result.pv);
+    }
+
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,93 @@
+#ifndef POSITIONCACHE_H
+#define POSITIONCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+using namespace std;
+
+// How a search was limited; part of the cache key because a 2 second search
+// and a 200 ms search of the same position are not interchangeable
+enum class SearchLimit
+{
+    MoveTime,
+    Depth,
+    Nodes
+};
+
+// Result of one engine search
+struct CachedSearch
+{
+    string bestMove;
+    bool hasScore;
+    bool scoreIsMate;
+    int score; // Centipawns or moves to mate, side to move's point of view
+    int depth;
+    string pv;
+
+    CachedSearch() : hasScore(false), scoreIsMate(false), score(0), depth(0) {}
+};
+
+// In-process cache of engine results keyed by Zobrist hash + search limits,
+// with least-recently-used eviction. Safe to share between several engines.
+class PositionCache
+{
+private:
+    struct Key
+    {
+        uint64_t hash;
+        SearchLimit limit;
+        int limitValue;
+        int skillLevel;
+
+        bool operator==(const Key &other) const
+        {
+            return hash == other.hash && limit == other.limit &&
+                   limitValue == other.limitValue && skillLevel == other.skillLevel;
+        }
+    };
+
+    struct KeyHasher
+    {
+        size_t operator()(const Key &key) const
+        {
+            uint64_t h = key.hash;
+            h ^= (static_cast<uint64_t>(key.limit) << 56) ^ (static_cast<uint64_t>(key.limitValue) << 8) ^
+                 static_cast<uint64_t>(key.skillLevel);
+            return static_cast<size_t>(h ^ (h >> 32));
+        }
+    };
+
+    typedef list<pair<Key, CachedSearch>> EntryList;
+
+    EntryList entries; // Most recently used first
+    unordered_map<Key, EntryList::iterator, KeyHasher> index;
+    size_t capacity;
+    mutable mutex cacheMutex;
+
+    // Statistics
+    size_t hits;
+    size_t misses;
+
+    void insertLocked(const Key &key, const CachedSearch &result);
+
+public:
+    explicit PositionCache(size_t capacity = 100000);
+
+    bool lookup(uint64_t hash, SearchLimit limit, int limitValue, int skillLevel, CachedSearch &result);
+    void store(uint64_t hash, SearchLimit limit, int limitValue, int skillLevel, const CachedSearch &result);
+    void clear();
+
+    size_t size() const;
+    size_t getHits() const;
+    size_t getMisses() const;
+
+    // Optional persistence; entries are written oldest first so recency survives a reload
+    bool loadFromFile(const string &path);
+    bool saveToFile(const string &path) const;
+};
+
+#endif // POSITIONCACHE_H
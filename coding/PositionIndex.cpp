@@ -0,0 +1,335 @@
+#include "PositionIndex.h"
+#include "PgnImporter.h"
+#include "Zobrist.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+
+static const char INDEX_MAGIC[8] = {'C', 'P', 'X', '1', 0, 0, 0, 0};
+static const size_t HEADER_SIZE = sizeof(INDEX_MAGIC) + 3 * sizeof(uint64_t);
+static const size_t COMPACT_ROWS = 1 << 22; // Rows gathered before the first merge
+
+// Helper function to order move rows by position, then move
+static bool moveRowLess(const PositionMoveStats &a, const PositionMoveStats &b)
+{
+    return a.key != b.key ? a.key < b.key : a.move < b.move;
+}
+
+// Helper function to order game rows by position, then game
+static bool gameRowLess(const PositionGame &a, const PositionGame &b)
+{
+    return a.key != b.key ? a.key < b.key : a.game < b.game;
+}
+
+PositionIndexWriter::PositionIndexWriter(size_t maxPlies)
+    : maxPlies(maxPlies), compactAt(COMPACT_ROWS), gamesAdded(0), positionCount(0)
+{
+}
+
+void PositionIndexWriter::addGame(const PgnGame &game, uint64_t number)
+{
+    PositionMoveStats row;
+    row.games = 1;
+    row.whiteWins = game.result == "1-0";
+    row.blackWins = game.result == "0-1";
+    row.draws = game.result == "1/2-1/2";
+    row.reserved = 0;
+
+    if (!position.setStart(game))
+        return; // A malformed FEN tag: the moves can't be placed
+    size_t plies = min(game.moves.size(), maxPlies);
+    for (size_t i = 0; i <= plies && i < maxPlies; i++)
+    {
+        uint64_t key = position.key();
+        PositionGame reached = {key, number};
+        games.push_back(reached);
+        if (i == plies)
+            break; // The game ended here: reached, but nothing was played from it
+
+        const PgnMove &move = game.moves[i];
+        int from = move.fromX * 8 + move.fromY;
+        int to = move.toX * 8 + move.toY;
+        row.key = key;
+        row.move = static_cast<uint32_t>(move.promotion * 4096 + from * 64 + to);
+        moves.push_back(row);
+        position.play(from, to, move.promotion != 0 ? move.promotion : 11);
+    }
+    gamesAdded++;
+
+    if (moves.size() + games.size() >= compactAt)
+    {
+        compact();
+        compactAt = max(compactAt, 2 * (moves.size() + games.size()));
+    }
+}
+
+void PositionIndexWriter::compact()
+{
+    // Same move from the same position: add the counts up
+    sort(moves.begin(), moves.end(), moveRowLess);
+    size_t kept = 0;
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        if (kept > 0 && moves[kept - 1].key == moves[i].key && moves[kept - 1].move == moves[i].move)
+        {
+            PositionMoveStats &merged = moves[kept - 1];
+            merged.games += moves[i].games;
+            merged.whiteWins += moves[i].whiteWins;
+            merged.draws += moves[i].draws;
+            merged.blackWins += moves[i].blackWins;
+        }
+        else
+            moves[kept++] = moves[i];
+    }
+    moves.resize(kept);
+
+    // A game counts once per position (repetitions reach it again), and only the
+    // lowest numbers are kept
+    sort(games.begin(), games.end(), gameRowLess);
+    kept = 0;
+    size_t sameKey = 0;
+    for (size_t i = 0; i < games.size(); i++)
+    {
+        if (kept > 0 && games[kept - 1].key == games[i].key)
+        {
+            if (games[kept - 1].game == games[i].game || sameKey == GAMES_PER_POSITION)
+                continue;
+            sameKey++;
+        }
+        else
+            sameKey = 1;
+        games[kept++] = games[i];
+    }
+    games.resize(kept);
+}
+
+bool PositionIndexWriter::write(const string &path)
+{
+    compact();
+    positionCount = 0;
+    for (size_t i = 0; i < games.size(); i++)
+    {
+        if (i == 0 || games[i].key != games[i - 1].key)
+            positionCount++;
+    }
+
+    FILE *out = fopen(path.c_str(), "wb");
+    uint64_t header[3] = {moves.size(), games.size(), maxPlies};
+    bool ok = out && fwrite(INDEX_MAGIC, 1, sizeof(INDEX_MAGIC), out) == sizeof(INDEX_MAGIC) &&
+              fwrite(header, sizeof(uint64_t), 3, out) == 3 &&
+              fwrite(moves.data(), sizeof(PositionMoveStats), moves.size(), out) == moves.size() &&
+              fwrite(games.data(), sizeof(PositionGame), games.size(), out) == games.size();
+    if (out)
+        ok = fclose(out) == 0 && ok;
+    if (!ok)
+        cerr << "Could not write position index: " << path << endl;
+    return ok;
+}
+
+PositionIndex::PositionIndex()
+    : moveRows(nullptr), moveRowCount(0), gameRows(nullptr), gameRowCount(0), plies(0)
+{
+}
+
+bool PositionIndex::open(const string &path)
+{
+    moveRows = nullptr;
+    gameRows = nullptr;
+    moveRowCount = gameRowCount = 0;
+    if (!file.open(path))
+        return false;
+
+    uint64_t header[3] = {0, 0, 0};
+    bool valid = file.size() >= HEADER_SIZE && memcmp(file.data(), INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+    if (valid)
+    {
+        memcpy(header, file.data() + sizeof(INDEX_MAGIC), sizeof(header));
+        valid = header[0] <= file.size() / sizeof(PositionMoveStats) &&
+                header[1] <= file.size() / sizeof(PositionGame) &&
+                file.size() == HEADER_SIZE + header[0] * sizeof(PositionMoveStats) + header[1] * sizeof(PositionGame);
+    }
+    if (!valid)
+    {
+        cerr << "Position index is damaged or incomplete: " << path << endl;
+        file.close();
+        return false;
+    }
+    moveRowCount = static_cast<size_t>(header[0]);
+    gameRowCount = static_cast<size_t>(header[1]);
+    plies = header[2];
+    moveRows = reinterpret_cast<const PositionMoveStats *>(file.data() + HEADER_SIZE);
+    gameRows = reinterpret_cast<const PositionGame *>(moveRows + moveRowCount);
+    return true;
+}
+
+bool PositionIndex::lookup(uint64_t key, vector<PositionMoveStats> &moves) const
+{
+    moves.clear();
+    const PositionMoveStats *end = moveRows + moveRowCount;
+    const PositionMoveStats *first = lower_bound(moveRows, end, key,
+                                                 [](const PositionMoveStats &row, uint64_t k)
+                                                 { return row.key < k; });
+    for (const PositionMoveStats *row = first; row != end && row->key == key; row++)
+    {
+        moves.push_back(*row);
+    }
+    sort(moves.begin(), moves.end(), [](const PositionMoveStats &a, const PositionMoveStats &b)
+         { return a.games > b.games; });
+    return !moves.empty();
+}
+
+void PositionIndex::findGames(uint64_t key, vector<uint64_t> &games) const
+{
+    games.clear();
+    const PositionGame *end = gameRows + gameRowCount;
+    const PositionGame *first = lower_bound(gameRows, end, key,
+                                            [](const PositionGame &row, uint64_t k)
+                                            { return row.key < k; });
+    for (const PositionGame *row = first; row != end && row->key == key; row++)
+    {
+        games.push_back(row->game);
+    }
+}
+
+string PositionIndex::moveToUci(uint32_t move)
+{
+    int from = move / 64 % 64;
+    int to = move % 64;
+    string uci;
+    uci += static_cast<char>('a' + from / 8);
+    uci += static_cast<char>('8' - from % 8);
+    uci += static_cast<char>('a' + to / 8);
+    uci += static_cast<char>('8' - to % 8);
+    switch (move / 4096)
+    {
+    case 11:
+        uci += 'q';
+        break;
+    case 6:
+        uci += 'r';
+        break;
+    case 7:
+        uci += 'b';
+        break;
+    case 8:
+        uci += 'n';
+        break;
+    }
+    return uci;
+}
+
+// Helper function to print what the index knows about one position
+static int queryIndex(const string &path, const string &uciMoves)
+{
+    PositionIndex index;
+    if (!index.open(path))
+    {
+        cerr << "Could not open position index: " << path << endl;
+        return 1;
+    }
+    uint64_t key = Zobrist::hashUciMoves(uciMoves);
+    vector<PositionMoveStats> moves;
+    vector<uint64_t> games;
+    auto start = chrono::steady_clock::now();
+    index.lookup(key, moves);
+    index.findGames(key, games);
+    double micros = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count();
+
+    cout << "Position " << hex << key << dec << ": " << games.size() << " games listed, " << moves.size()
+         << " moves played (" << fixed << setprecision(1) << micros << " us)" << endl;
+    for (const PositionMoveStats &move : moves)
+    {
+        cout << "  " << PositionIndex::moveToUci(move.move) << "  " << setw(8) << move.games << "  +" << move.whiteWins
+             << " =" << move.draws << " -" << move.blackWins << endl;
+    }
+    if (!games.empty())
+    {
+        cout << "  games:";
+        for (size_t i = 0; i < games.size() && i < 10; i++)
+            cout << " " << games[i] + 1;
+        cout << (games.size() > 10 ? " ..." : "") << endl;
+    }
+    return 0;
+}
+
+int PositionIndex::runCommandLine(int argc, char *argv[])
+{
+    int threads = 0;
+    size_t plies = PositionIndexWriter::DEFAULT_PLIES;
+    bool query = false;
+    vector<string> files;
+    for (int i = 2; i < argc; i++)
+    {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--threads" && hasValue)
+            threads = atoi(argv[++i]);
+        else if (arg == "--plies" && hasValue)
+            plies = static_cast<size_t>(max(1, atoi(argv[++i])));
+        else if (arg == "--query")
+            query = true;
+        else if (arg.compare(0, 2, "--") == 0)
+        {
+            cerr << "Unknown index option: " << arg << endl;
+            return 1;
+        }
+        else
+            files.push_back(arg);
+    }
+
+    if (query && !files.empty())
+    {
+        string uciMoves;
+        for (size_t i = 1; i < files.size(); i++)
+            uciMoves += (i > 1 ? " " : "") + files[i];
+        return queryIndex(files[0], uciMoves);
+    }
+    if (query || files.size() != 2)
+    {
+        cerr << "Usage: --index [--plies N] [--threads N] in.pgn|in.cgd out.cpi | --index --query index.cpi [uci moves...]"
+             << endl;
+        return 1;
+    }
+
+    const string &in = files[0];
+    const string &out = files[1];
+    auto start = chrono::steady_clock::now();
+    PositionIndexWriter writer(plies);
+    bool ok = true;
+    if (in.size() > 4 && in.compare(in.size() - 4, 4, ".pgn") == 0)
+    {
+        // Games are parsed on every core and indexed in file order
+        auto index = [&](const PgnGame &game)
+        {
+            writer.addGame(game, game.number - 1);
+        };
+        PgnImporter importer(threads);
+        ok = importer.importFile(in, index);
+        importer.printStats(cout);
+    }
+    else
+    {
+        GameStore store;
+        if (!store.open(in))
+            return 1;
+        PgnGame game;
+        game.tagCount = 0;
+        for (size_t n = 0; n < store.getGameCount(); n++)
+        {
+            if (store.readGame(n, game))
+                writer.addGame(game, n);
+            else
+                cerr << in << " game " << n + 1 << " could not be read" << endl;
+        }
+    }
+    ok = writer.write(out) && ok;
+    cout << writer.getGamesAdded() << " games, " << writer.getPositionCount() << " positions up to ply " << plies
+         << " indexed in " << out << " in " << chrono::duration<double>(chrono::steady_clock::now() - start).count()
+         << " s" << endl;
+    return ok ? 0 : 1;
+}
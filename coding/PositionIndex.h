@@ -0,0 +1,101 @@
+#ifndef POSITIONINDEX_H
+#define POSITIONINDEX_H
+
+#include "PgnParser.h"
+#include "GameStore.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// One move played from an indexed position, and how the games that played it ended
+struct PositionMoveStats
+{
+    uint64_t key;  // Zobrist::hashBoard of the position
+    uint32_t move; // promotion * 4096 + from * 64 + to, squares x * 8 + y as in StoredPosition
+    uint32_t games;
+    uint32_t whiteWins;
+    uint32_t draws;
+    uint32_t blackWins;
+    uint32_t reserved; // Keeps a row 32 bytes in the file
+
+    int fromX() const { return move / 64 % 64 / 8; }
+    int fromY() const { return move / 64 % 8; }
+    int toX() const { return move % 64 / 8; }
+    int toY() const { return move % 64 % 8; }
+    int promotion() const { return move / 4096; } // Piece type a pawn becomes, 0 if none
+};
+
+// One game that reached an indexed position
+struct PositionGame
+{
+    uint64_t key;
+    uint64_t game; // Number in the database, counting from 0 as GameStore::readGame does
+};
+
+// Position index files: an 8-byte magic, the number of move rows, game rows and
+// plies indexed (8 bytes each), then every PositionMoveStats row sorted by key and
+// move, then the PositionGame rows sorted by key and game. A position keeps the
+// GAMES_PER_POSITION lowest game numbers. Both tables are read in place through a
+// mapping, so a lookup is two binary searches and never reads the whole file.
+class PositionIndexWriter
+{
+public:
+    static const size_t DEFAULT_PLIES = 40;       // An opening explorer; deeper positions are mostly unique
+    static const size_t GAMES_PER_POSITION = 100;
+
+    explicit PositionIndexWriter(size_t maxPlies = DEFAULT_PLIES);
+
+    // Index the positions of the game's first maxPlies moves
+    void addGame(const PgnGame &game, uint64_t number);
+
+    bool write(const string &path);
+
+    size_t getGamesAdded() const { return gamesAdded; }
+    size_t getPositionCount() const { return positionCount; } // After write
+
+private:
+    size_t maxPlies;
+    vector<PositionMoveStats> moves;
+    vector<PositionGame> games;
+    size_t compactAt;     // Rows are merged whenever the tables grow past this
+    size_t gamesAdded;
+    size_t positionCount;
+    StoredPosition position;
+
+    void compact(); // Sort and merge the rows, so memory follows the distinct positions
+};
+
+class PositionIndex
+{
+private:
+    MappedFile file;
+    const PositionMoveStats *moveRows;
+    size_t moveRowCount;
+    const PositionGame *gameRows;
+    size_t gameRowCount;
+    uint64_t plies;
+
+public:
+    PositionIndex();
+
+    bool open(const string &path);
+    bool isOpen() const { return file.isOpen(); }
+    uint64_t getPlies() const { return plies; }
+
+    // The moves played from the position, most played first; false if it isn't indexed
+    bool lookup(uint64_t key, vector<PositionMoveStats> &moves) const;
+
+    // Games that reached the position, lowest numbers first
+    void findGames(uint64_t key, vector<uint64_t> &games) const;
+
+    static string moveToUci(uint32_t move);
+
+    // Command line entry: --index [--plies N] [--threads N] in.pgn|in.cgd out.cpi  (build)
+    //                     --index --query index.cpi [uci moves...]                (look up)
+    static int runCommandLine(int argc, char *argv[]);
+};
+
+#endif // POSITIONINDEX_H
@@ -0,0 +1,95 @@
+#include "SoundBank.h"
+#include "AssetLoader.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace sf;
+
+// Files in the sound directory, in SoundEffect order
+static const char *EFFECT_FILES[] = {"move-self.wav", "capture.wav", "move-check.wav",
+                                     "castle.wav", "promote.wav", "game-end.wav"};
+
+// What an effect plays when its file is missing (-1 for silence)
+static const int EFFECT_FALLBACKS[] = {-1, -1, -1, static_cast<int>(SoundEffect::Move),
+                                       static_cast<int>(SoundEffect::Move), -1};
+
+SoundBank::SoundBank() : nextVoice(0)
+{
+    for (int i = 0; i < EFFECTS; i++)
+    {
+        source[i] = -1;
+    }
+}
+
+void SoundBank::requestFiles(const string &directory, AssetLoader &loader)
+{
+    for (int i = 0; i < EFFECTS; i++)
+    {
+        loader.requestFile(directory + "/" + EFFECT_FILES[i]);
+    }
+}
+
+bool SoundBank::load(const string &directory, AssetLoader *loader)
+{
+    bool complete = true;
+    for (int i = 0; i < EFFECTS; i++)
+    {
+        string path = directory + "/" + EFFECT_FILES[i];
+        bool ok;
+        if (loader)
+        {
+            vector<char> bytes;
+            ok = loader->takeFile(path, bytes) && buffers[i].loadFromMemory(bytes.data(), bytes.size());
+        }
+        else
+        {
+            ok = buffers[i].loadFromFile(path);
+        }
+
+        if (ok)
+        {
+            source[i] = i;
+        }
+        else if (i < static_cast<int>(SoundEffect::Castle)) // Move, capture and check are required
+        {
+            cout << "Failed to load sound " << path << endl;
+            complete = false;
+        }
+    }
+
+    // Stand-ins for the optional effects
+    for (int i = 0; i < EFFECTS; i++)
+    {
+        if (source[i] < 0 && EFFECT_FALLBACKS[i] >= 0)
+        {
+            source[i] = source[EFFECT_FALLBACKS[i]];
+        }
+    }
+    return complete;
+}
+
+void SoundBank::play(SoundEffect effect, float volume)
+{
+    int buffer = source[static_cast<int>(effect)];
+    if (buffer < 0)
+        return;
+
+    // A free voice if there is one, otherwise the one that started longest ago
+    int voice = nextVoice;
+    for (int i = 0; i < VOICES; i++)
+    {
+        int candidate = (nextVoice + i) % VOICES;
+        if (voices[candidate].getStatus() != Sound::Playing)
+        {
+            voice = candidate;
+            break;
+        }
+    }
+    nextVoice = (voice + 1) % VOICES;
+
+    voices[voice].stop();
+    voices[voice].setBuffer(buffers[buffer]);
+    voices[voice].setVolume(volume);
+    voices[voice].play();
+}
@@ -0,0 +1,49 @@
+#ifndef SOUNDBANK_H
+#define SOUNDBANK_H
+
+#include <SFML/Audio.hpp>
+#include <string>
+
+using namespace std;
+using namespace sf;
+
+class AssetLoader;
+
+enum class SoundEffect
+{
+    Move,
+    Capture,
+    Check,
+    Castle,
+    Promote,
+    GameEnd,
+    Count
+};
+
+// Every game sound decoded once into memory, played through a few voices so a
+// new effect never cuts off or reloads one that is still playing. Playing a
+// sound does no file access.
+class SoundBank
+{
+private:
+    static const int EFFECTS = static_cast<int>(SoundEffect::Count);
+    static const int VOICES = 4; // Enough for a capture, a check and the game end to overlap
+
+    SoundBuffer buffers[EFFECTS];
+    int source[EFFECTS]; // Buffer each effect plays: its own, or a stand-in if its file is missing
+    Sound voices[VOICES];
+    int nextVoice;       // Oldest voice, taken when all of them are busy
+
+public:
+    SoundBank();
+
+    // Decode the effect files (move-self.wav, capture.wav, ...) from a directory, or collect
+    // them from a loader that was given them earlier with requestFiles. Move, capture and
+    // check are required; castle, promote and game end fall back to another sound or silence.
+    bool load(const string &directory, AssetLoader *loader = nullptr);
+    static void requestFiles(const string &directory, AssetLoader &loader);
+
+    void play(SoundEffect effect, float volume = 100);
+};
+
+#endif // SOUNDBANK_H
@@ -1,4 +1,6 @@
 #include "ChessBoard.h"
+#include "Zobrist.h"
+#include "Fen.h"
 #include <cstdio>
 #include <string>
 #include <sstream>
@@ -15,6 +17,11 @@
 
 using namespace std;
 
+// Watchdog timings
+static const int PING_INTERVAL_MS = 2000; // Ping before a search if the engine has been quiet this long
+static const int PING_TIMEOUT_MS = 2000;
+static const int STOP_GRACE_MS = 500;     // Time allowed for "bestmove" after sending "stop"
+
 // Helper function to read from pipe
 string readFromPipe(HANDLE pipe)
 {
@@ -54,7 +61,8 @@ StockfishEngine::StockfishEngine()
     : engineProcessHandle(nullptr),
       hChildStd_IN_Rd(nullptr), hChildStd_IN_Wr(nullptr),
       hChildStd_OUT_Rd(nullptr), hChildStd_OUT_Wr(nullptr),
-      initialized(false), skillLevel(10)
+      initialized(false), skillLevel(10), nextInfoCallbackId(0),
+      readyReceived(false), cache(nullptr), lastOutput(chrono::steady_clock::now())
 {
 }
 
@@ -167,27 +175,10 @@ bool StockfishEngine::initialize()
     }
 #endif
 
-    // Add a short delay to let Stockfish initialize
-    this_thread::sleep_for(chrono::milliseconds(1000)); // Increased delay slightly
-
-    // Initialize UCI mode
-    string response = sendCommand("uci");
-    cerr << "Stockfish initial response check: " << response << endl;
-
-    // Wait up to 3 seconds for uciok
-    bool uciOkReceived = false;
-    for (int i = 0; i < 30; ++i)
-    { // Check 10 times per second for 3 seconds
-        if (response.find("uciok") != string::npos)
-        {
-            uciOkReceived = true;
-            break;
-        }
-        this_thread::sleep_for(chrono::milliseconds(100));
-        response += readFromPipe(hChildStd_OUT_Rd); // Append any new output
-    }
-
-    if (!uciOkReceived)
+    // Commands queue up in the pipe until Stockfish reads them, so there is no need to
+    // sleep while it starts; answers are polled until they arrive or the deadline passes
+    string response;
+    if (!writeCommand("uci") || !waitForToken("uciok", 3000, response))
     {
         cerr << "Stockfish failed to initialize UCI mode! Final response: " << response << endl;
         close();
@@ -196,24 +187,12 @@ bool StockfishEngine::initialize()
     cerr << "Stockfish UCI mode confirmed." << endl;
 
     // Configure the engine
-    sendCommand("setoption name UCI_AnalyseMode value true");
+    writeCommand("setoption name UCI_AnalyseMode value true");
     setDifficulty(skillLevel);
 
     // Send isready and wait for readyok
-    response = sendCommand("isready");
-    bool readyOkReceived = false;
-    for (int i = 0; i < 30; ++i)
-    {
-        if (response.find("readyok") != string::npos)
-        {
-            readyOkReceived = true;
-            break;
-        }
-        this_thread::sleep_for(chrono::milliseconds(100));
-        response += readFromPipe(hChildStd_OUT_Rd);
-    }
-
-    if (!readyOkReceived)
+    response.clear();
+    if (!writeCommand("isready") || !waitForToken("readyok", 3000, response))
     {
         cerr << "Stockfish failed to respond with readyok! Final response: " << response << endl;
         close();
@@ -221,6 +200,7 @@ bool StockfishEngine::initialize()
     }
     cerr << "Stockfish is ready." << endl;
 
+    lastOutput = chrono::steady_clock::now();
     initialized = true;
     return true;
 }
@@ -234,72 +214,459 @@ void StockfishEngine::setDifficulty(int level)
     skillLevel = max(0, min(20, skillLevel));
 
     // Stockfish skill level setting (no error/probability needed for basic levels)
-    stringstream ss;
-    ss << "setoption name Skill Level value " << skillLevel;
-    sendCommand(ss.str());
+    setOption("Skill Level", to_string(skillLevel));
+}
+
+// Helper function for the UCI position command: the start position or a FEN, then the moves
+static string positionCommand(const string &startFen, const string &moves)
+{
+    string command = startFen.empty() ? "position startpos" : "position fen " + startFen;
+    if (!moves.empty())
+    {
+        command += " moves " + moves;
+    }
+    return command;
 }
 
-string StockfishEngine::getBestMove(const string &position, int moveTime)
+// Helper function for the cache key of the position the moves lead to
+static uint64_t positionKey(const string &startFen, const string &moves)
+{
+    FenPosition start;
+    string error;
+    if (!startFen.empty() && Fen::parse(startFen, start, error))
+    {
+        return Zobrist::hashUciMoves(moves, start.board, start.whiteToMove, start.castlingRights,
+                                     start.enPassantCol);
+    }
+    return Zobrist::hashUciMoves(moves);
+}
+
+string StockfishEngine::getBestMove(const string &position, int moveTime, const string &startFen)
 {
     if (!initialized)
         return "";
 
-    // Set position
-    string posCmd = "position startpos";
-    if (!position.empty())
+    // Answer from the cache when this position was already searched with the same limits
+    uint64_t key = 0;
+    if (cache)
     {
-        posCmd += " moves " + position;
+        key = positionKey(startFen, position);
+        CachedSearch cached;
+        if (cache->lookup(key, SearchLimit::MoveTime, moveTime, skillLevel, cached))
+        {
+            // Let subscribers see the stored evaluation as if it had just been searched
+            UciInfo info;
+            info.depth = cached.depth;
+            info.hasScore = cached.hasScore;
+            info.scoreIsMate = cached.scoreIsMate;
+            info.score = cached.score;
+            info.pv = cached.pv.data();
+            info.pvLength = cached.pv.size();
+            for (auto &callback : infoCallbacks)
+            {
+                callback.second(info);
+            }
+            return cached.bestMove;
+        }
     }
-    sendCommand(posCmd);
 
-    // Calculate best move
+    // Set position
+    string posCmd = positionCommand(startFen, position);
+
+    // Calculate best move; the watchdog stops the search one second after movetime
+    string bestMove = "";
     stringstream ss;
     ss << "go movetime " << moveTime;
-    string response = sendCommand(ss.str());
+    bool found = runSearch(posCmd, ss.str(), moveTime + 1000, bestMove);
 
-    // Wait for bestmove response (up to moveTime + buffer)
-    string bestMove = "";
-    size_t bestMovePos = string::npos;
-    int waitTime = moveTime + 1000; // Wait for movetime + 1 second buffer
+    if (!found || bestMove.empty())
+    {
+        cerr << "Engine did not return a move." << endl;
+        bestMove = "";
+    }
+    else if (cache)
+    {
+        CachedSearch result;
+        result.bestMove = bestMove;
+        if (!searchLines.empty())
+        {
+            result.hasScore = searchLines[0].hasScore;
+            result.scoreIsMate = searchLines[0].scoreIsMate;
+            result.score = searchLines[0].score;
+            result.depth = searchLines[0].depth;
+            result.pv = searchLines[0].pv;
+        }
+        cache->store(key, SearchLimit::MoveTime, moveTime, skillLevel, result);
+    }
+
+    return bestMove;
+}
 
-    for (int i = 0; i < waitTime / 50; ++i)
+vector<PlyEvaluation> StockfishEngine::analyzeGame(const vector<string> &moves, SearchLimit limit,
+                                                   int limitValue, int multiPv,
+                                                   const function<bool(size_t)> &onPosition)
+{
+    vector<PlyEvaluation> evaluations;
+    if (!beginAnalysis(multiPv))
+        return evaluations;
+
+    // Positions are sent back to back on the same session: as soon as one
+    // bestmove arrives the next position is queued, with no fixed sleeps
+    evaluations.reserve(moves.size() + 1);
+    string position = "";
+    for (size_t ply = 0; ply <= moves.size(); ++ply)
     {
-        bestMovePos = response.find("bestmove");
-        if (bestMovePos != string::npos)
+        if (ply > 0)
         {
-            size_t spacePos = response.find(' ', bestMovePos + 9);
-            if (spacePos != string::npos)
-            {
-                bestMove = response.substr(bestMovePos + 9, spacePos - (bestMovePos + 9));
-            }
-            else
-            {
-                bestMove = response.substr(bestMovePos + 9); // If no space after move
-                // Trim potential newline/whitespace
-                bestMove.erase(bestMove.find_last_not_of(" \n\r\t") + 1);
-            }
-            // Basic validation: check length (e.g., e2e4 is 4, a7a8q is 5)
-            if (bestMove.length() >= 4 && bestMove.length() <= 5)
+            position += (ply == 1 ? "" : " ") + moves[ply - 1];
+        }
+
+        PlyEvaluation evaluation;
+        evaluation.ply = static_cast<int>(ply);
+        evaluation.whiteToMove = ply % 2 == 0;
+        evaluation.playedMove = ply < moves.size() ? moves[ply] : "";
+        if (!analyzePosition(position, limit, limitValue, evaluation.lines))
+        {
+            cerr << "Analysis stopped at ply " << ply << ": engine did not answer" << endl;
+            break;
+        }
+        evaluations.push_back(evaluation);
+        if (onPosition && !onPosition(evaluations.size()))
+            break;
+    }
+
+    endAnalysis();
+    return evaluations;
+}
+
+bool StockfishEngine::beginAnalysis(int multiPv)
+{
+    if (!initialized)
+        return false;
+
+    // Analysis always runs at full strength with several lines
+    setOption("Skill Level", "20");
+    setOption("MultiPV", to_string(max(1, multiPv)));
+    writeCommand("ucinewgame");
+    if (!waitForReady(5000))
+    {
+        cerr << "Engine did not become ready for analysis" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool StockfishEngine::analyzePosition(const string &moves, SearchLimit limit, int limitValue,
+                                      vector<EngineLine> &lines, const string &startFen)
+{
+    stringstream goCmd;
+    int timeoutMs = 60000; // Generous limit per position for depth and node searches
+    switch (limit)
+    {
+    case SearchLimit::Depth:
+        goCmd << "go depth " << limitValue;
+        break;
+    case SearchLimit::Nodes:
+        goCmd << "go nodes " << limitValue;
+        break;
+    case SearchLimit::MoveTime:
+        goCmd << "go movetime " << limitValue;
+        timeoutMs = limitValue + 2000;
+        break;
+    }
+
+    string positionCmd = positionCommand(startFen, moves);
+
+    string bestMove;
+    if (!runSearch(positionCmd, goCmd.str(), timeoutMs, bestMove))
+    {
+        return false;
+    }
+
+    lines.clear();
+    for (const auto &line : searchLines)
+    {
+        if (!line.move.empty())
+        {
+            lines.push_back(line);
+        }
+    }
+    return true;
+}
+
+void StockfishEngine::endAnalysis()
+{
+    // Back to playing settings
+    setOption("MultiPV", "1");
+    setDifficulty(skillLevel);
+}
+
+void StockfishEngine::setOption(const string &name, const string &value)
+{
+    // Remember the latest value of every option so a restarted process gets the same settings
+    bool known = false;
+    for (auto &option : options)
+    {
+        if (option.first == name)
+        {
+            option.second = value;
+            known = true;
+            break;
+        }
+    }
+    if (!known)
+    {
+        options.emplace_back(name, value);
+    }
+
+    writeCommand("setoption name " + name + " value " + value);
+}
+
+bool StockfishEngine::isAlive() const
+{
+#ifdef _WIN32
+    DWORD exitCode;
+    return engineProcessHandle && GetExitCodeProcess(engineProcessHandle, &exitCode) && exitCode == STILL_ACTIVE;
+#else
+    return engineProcess && !ferror(engineProcess);
+#endif
+}
+
+bool StockfishEngine::ping(int timeoutMs)
+{
+    auto start = chrono::steady_clock::now();
+    bool ready = waitForReady(timeoutMs);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    health.pings++;
+    health.lastPingMs = ms;
+    health.maxPingMs = max(health.maxPingMs, ms);
+    return ready;
+}
+
+bool StockfishEngine::restart()
+{
+    cerr << "Restarting Stockfish..." << endl;
+    auto start = chrono::steady_clock::now();
+
+    close();
+    if (!initialize())
+    {
+        cerr << "Stockfish could not be restarted" << endl;
+        return false;
+    }
+
+    // Bring the new process back to the settings of the old one
+    for (const auto &option : options)
+    {
+        writeCommand("setoption name " + option.first + " value " + option.second);
+    }
+
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    health.restarts++;
+    health.lastRestartMs = ms;
+    health.totalRestartMs += ms;
+    cerr << "Stockfish restarted in " << ms << " ms (restart " << health.restarts << ")" << endl;
+    return true;
+}
+
+bool StockfishEngine::ensureResponsive()
+{
+    if (!isAlive())
+    {
+        cerr << "Stockfish process is gone" << endl;
+        return restart();
+    }
+
+    // A recently active engine is known to be fine; only ping after a quiet spell
+    if (chrono::steady_clock::now() - lastOutput < chrono::milliseconds(PING_INTERVAL_MS))
+        return true;
+
+    if (!ping(PING_TIMEOUT_MS))
+    {
+        cerr << "Stockfish did not answer isready within " << PING_TIMEOUT_MS << " ms" << endl;
+        return restart();
+    }
+    return true;
+}
+
+bool StockfishEngine::runSearch(const string &positionCmd, const string &goCmd, int timeoutMs, string &bestMove)
+{
+    // A second attempt replays the same position on a fresh process
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        if (attempt == 0 ? !ensureResponsive() : !restart())
+            return false;
+
+        bestMove = "";
+        searchLines.clear();
+        if (writeCommand(positionCmd) && writeCommand(goCmd))
+        {
+            if (waitForBestMove(timeoutMs, bestMove))
+                return true;
+
+            // Hard deadline passed: ask for the best move found so far
+            health.timeouts++;
+            cerr << "Search missed its " << timeoutMs << " ms deadline, sending stop" << endl;
+            if (writeCommand("stop") && waitForBestMove(STOP_GRACE_MS, bestMove))
+                return true;
+        }
+        cerr << "Stockfish is not responding" << (attempt == 0 ? ", replaying the position on a new process" : "") << endl;
+    }
+    return false;
+}
+
+bool StockfishEngine::waitForBestMove(int timeoutMs, string &bestMove)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+    while (chrono::steady_clock::now() < deadline)
+    {
+        string output = readFromPipe(hChildStd_OUT_Rd);
+        if (processOutput(output, bestMove))
+        {
+            return true;
+        }
+        if (output.empty())
+        {
+            // Nothing to read yet; poll again shortly rather than sleeping a whole tick
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+    return false;
+}
+
+bool StockfishEngine::waitForToken(const string &token, int timeoutMs, string &response)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+    while (response.find(token) == string::npos)
+    {
+        if (chrono::steady_clock::now() >= deadline)
+            return false;
+        string output = readFromPipe(hChildStd_OUT_Rd);
+        if (output.empty())
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        response += output;
+    }
+    return true;
+}
+
+bool StockfishEngine::waitForReady(int timeoutMs)
+{
+    readyReceived = false;
+    if (!writeCommand("isready"))
+        return false;
+
+    string ignored;
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeoutMs);
+    while (!readyReceived && chrono::steady_clock::now() < deadline)
+    {
+        string output = readFromPipe(hChildStd_OUT_Rd);
+        processOutput(output, ignored);
+        if (output.empty())
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+    return readyReceived;
+}
+
+bool StockfishEngine::processOutput(const string &output, string &bestMove)
+{
+    if (!output.empty())
+    {
+        lastOutput = chrono::steady_clock::now();
+    }
+    outputBuffer.append(output);
+
+    bool found = false;
+    const char *line;
+    size_t length;
+    UciInfo info;
+    while (outputBuffer.nextLine(line, length))
+    {
+        if (UciInfoParser::startsWith(line, length, "info"))
+        {
+            if (UciInfoParser::parseInfo(line, length, info))
             {
-                break; // Found valid-looking move
+                // Bound scores from aspiration windows are not final, so don't keep them
+                if (info.hasScore && info.multiPv >= 1 && !info.lowerBound && !info.upperBound)
+                {
+                    if (searchLines.size() < static_cast<size_t>(info.multiPv))
+                    {
+                        searchLines.resize(info.multiPv);
+                    }
+                    EngineLine &searchLine = searchLines[info.multiPv - 1];
+                    searchLine.move = info.firstPvMove();
+                    searchLine.hasScore = true;
+                    searchLine.scoreIsMate = info.scoreIsMate;
+                    searchLine.score = info.score;
+                    searchLine.depth = info.depth;
+                    searchLine.pv = info.pvString();
+                }
+                for (auto &callback : infoCallbacks)
+                {
+                    callback.second(info);
+                }
             }
-            else
+        }
+        else if (UciInfoParser::startsWith(line, length, "bestmove"))
+        {
+            // The search is over even if there is no move ("bestmove (none)" when mated)
+            found = true;
+            if (!UciInfoParser::parseBestMove(line, length, bestMove))
             {
-                cerr << "Warning: Parsed potentially invalid move format: '" << bestMove << "'" << endl;
-                bestMove = "";              // Reset if invalid format
-                bestMovePos = string::npos; // Continue searching
+                bestMove = "";
             }
         }
-        this_thread::sleep_for(chrono::milliseconds(50));
-        response += readFromPipe(hChildStd_OUT_Rd);
+        else if (UciInfoParser::startsWith(line, length, "readyok"))
+        {
+            readyReceived = true;
+        }
     }
+    return found;
+}
 
-    if (bestMove.empty())
+int StockfishEngine::addInfoCallback(function<void(const UciInfo &)> callback)
+{
+    int id = nextInfoCallbackId++;
+    infoCallbacks.emplace_back(id, callback);
+    return id;
+}
+
+void StockfishEngine::removeInfoCallback(int id)
+{
+    for (size_t i = 0; i < infoCallbacks.size(); ++i)
     {
-        cerr << "Engine response did not contain bestmove after waiting. Full response: " << response << endl;
+        if (infoCallbacks[i].first == id)
+        {
+            infoCallbacks.erase(infoCallbacks.begin() + i);
+            return;
+        }
     }
+}
 
-    return bestMove;
+bool StockfishEngine::writeCommand(const string &command)
+{
+    string cmdWithNewline = command + "\n";
+#ifdef _WIN32
+    if (!hChildStd_IN_Wr)
+        return false;
+
+    DWORD bytesWritten;
+    if (!WriteFile(hChildStd_IN_Wr, cmdWithNewline.c_str(), cmdWithNewline.length(), &bytesWritten, NULL))
+    {
+        cerr << "WriteFile to pipe failed. Error: " << GetLastError() << endl;
+        return false;
+    }
+#else
+    if (!engineProcess)
+        return false;
+    fputs(cmdWithNewline.c_str(), engineProcess);
+    fflush(engineProcess);
+#endif
+    return true;
 }
 
 string StockfishEngine::sendCommand(const string &command)
@@ -380,5 +747,6 @@ void StockfishEngine::close()
         engineProcess = nullptr;
     }
 #endif
+    outputBuffer.clear();
     initialized = false;
 }
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "TextCache.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+using namespace sf;
+
+TextCache::TextCache()
+    : font(nullptr), pixelScale(1), hasBackground(false), dirty(true), textureFailed(false), renders(0)
+{
+}
+
+void TextCache::setFont(const Font &font)
+{
+    if (this->font != &font)
+    {
+        this->font = &font;
+        metrics.clear();
+        dirty = true;
+    }
+}
+
+void TextCache::setArea(const FloatRect &area, float pixelScale)
+{
+    if (area != this->area || pixelScale != this->pixelScale)
+    {
+        this->area = area;
+        this->pixelScale = pixelScale > 0 ? pixelScale : 1;
+        dirty = true;
+    }
+}
+
+void TextCache::clear()
+{
+    panels.clear();
+    labels.clear();
+    if (hasBackground)
+    {
+        hasBackground = false;
+        dirty = true;
+    }
+}
+
+void TextCache::setBackground(const Sprite &sprite)
+{
+    background = sprite;
+    hasBackground = true;
+    dirty = true;
+}
+
+int TextCache::addPanel(const FloatRect &rect, const Color &color)
+{
+    Panel panel;
+    panel.rect = rect;
+    panel.color = color;
+    panels.push_back(panel);
+    return static_cast<int>(panels.size()) - 1;
+}
+
+void TextCache::setPanelColor(int panel, const Color &color)
+{
+    panels[panel].color = color;
+}
+
+int TextCache::findPanel(Vector2f point) const
+{
+    for (int i = static_cast<int>(panels.size()) - 1; i >= 0; i--)
+    {
+        if (panels[i].rect.contains(point))
+            return i;
+    }
+    return -1;
+}
+
+FloatRect TextCache::measure(const string &text, unsigned int size)
+{
+    if (!font)
+        return FloatRect();
+
+    string key = to_string(size) + ':' + text;
+    auto it = metrics.find(key);
+    if (it != metrics.end())
+        return it->second;
+
+    FloatRect bounds = Text(text, *font, size).getLocalBounds();
+    metrics[key] = bounds;
+    return bounds;
+}
+
+void TextCache::addLabel(const string &text, unsigned int size, const Color &color, Vector2f position)
+{
+    Label label;
+    label.text = text;
+    label.size = size;
+    label.color = color;
+    label.position = position;
+    labels.push_back(label);
+}
+
+void TextCache::addCenteredLabel(const string &text, unsigned int size, const Color &color,
+                                 const FloatRect &box, float offsetY)
+{
+    FloatRect bounds = measure(text, size);
+    addLabel(text, size, color, Vector2f(box.left + (box.width - bounds.width) / 2,
+                                         box.top + (box.height - bounds.height) / 2 + offsetY));
+}
+
+void TextCache::drawItems(RenderTarget &target, RenderStates states) const
+{
+    if (hasBackground)
+    {
+        target.draw(background, states);
+    }
+
+    // All panels in one vertex array
+    VertexArray quads(Triangles);
+    for (const Panel &panel : panels)
+    {
+        const FloatRect &r = panel.rect;
+        Vertex topLeft(Vector2f(r.left, r.top), panel.color);
+        Vertex topRight(Vector2f(r.left + r.width, r.top), panel.color);
+        Vertex bottomRight(Vector2f(r.left + r.width, r.top + r.height), panel.color);
+        Vertex bottomLeft(Vector2f(r.left, r.top + r.height), panel.color);
+        quads.append(topLeft);
+        quads.append(topRight);
+        quads.append(bottomRight);
+        quads.append(topLeft);
+        quads.append(bottomRight);
+        quads.append(bottomLeft);
+    }
+    if (quads.getVertexCount() > 0)
+    {
+        target.draw(quads, states);
+    }
+
+    if (font)
+    {
+        // Glyphs are rasterized at the size they will cover on screen, then scaled back
+        // into area units, so the view's magnification doesn't blur them
+        for (const Label &label : labels)
+        {
+            unsigned int size = max(1u, static_cast<unsigned int>(label.size * pixelScale + 0.5f));
+            Text text(label.text, *font, size);
+            text.setFillColor(label.color);
+            text.setPosition(label.position);
+            text.setScale(static_cast<float>(label.size) / size, static_cast<float>(label.size) / size);
+            target.draw(text, states);
+        }
+    }
+}
+
+void TextCache::render() const
+{
+    unsigned int width = static_cast<unsigned int>(ceil(area.width * pixelScale));
+    unsigned int height = static_cast<unsigned int>(ceil(area.height * pixelScale));
+    if (width == 0 || height == 0)
+        return;
+
+    // Only grow the texture; while the window is dragged smaller the old one is reused,
+    // so a continuous resize doesn't reallocate it on every event
+    Vector2u size = texture.getSize();
+    if (size.x < width || size.y < height)
+    {
+        if (!texture.create(max(size.x, width), max(size.y, height)))
+        {
+            cerr << "RenderTexture not available, menu text is drawn directly" << endl;
+            textureFailed = true;
+            return;
+        }
+        texture.setSmooth(true); // Texture pixels map to window pixels up to rounding
+        size = texture.getSize();
+    }
+
+    View view(area);
+    view.setViewport(FloatRect(0, 0, static_cast<float>(width) / size.x, static_cast<float>(height) / size.y));
+    texture.setView(view);
+    texture.clear(Color::Transparent);
+    drawItems(texture, RenderStates::Default);
+    texture.display();
+
+    sprite.setTexture(texture.getTexture());
+    sprite.setTextureRect(IntRect(0, 0, width, height));
+    sprite.setPosition(area.left, area.top);
+    sprite.setScale(area.width / width, area.height / height);
+
+    renderedPanels = panels;
+    renderedLabels = labels;
+    dirty = false;
+    renders++;
+}
+
+void TextCache::draw(RenderTarget &target, RenderStates states) const
+{
+    if (!textureFailed && (dirty || panels != renderedPanels || labels != renderedLabels))
+    {
+        render();
+    }
+
+    if (textureFailed)
+    {
+        drawItems(target, states);
+        return;
+    }
+
+    // Translucent items were blended into a transparent texture, so its colours are
+    // already multiplied by alpha; blending them by alpha again would darken the edges
+    states.blendMode = BlendMode(BlendMode::One, BlendMode::OneMinusSrcAlpha);
+    target.draw(sprite, states);
+}
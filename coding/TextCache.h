@@ -0,0 +1,100 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <map>
+
+using namespace std;
+using namespace sf;
+
+// Static labels, and the button panels and background behind them, rendered once
+// into a RenderTexture and drawn as a single sprite. A menu frame is then one draw
+// call however many buttons it has. The texture is only rendered again when the
+// labels (string, size, colour, position) or panels differ from what it holds, or
+// the area changes (resize); clearing and re-adding the same items is free.
+// Text measurements are cached by string and character size, so layout code can
+// centre labels without building Text objects.
+class TextCache : public Drawable
+{
+private:
+    struct Label
+    {
+        string text;
+        unsigned int size;
+        Color color;
+        Vector2f position;
+
+        bool operator==(const Label &other) const
+        {
+            return text == other.text && size == other.size && color == other.color && position == other.position;
+        }
+    };
+
+    struct Panel
+    {
+        FloatRect rect;
+        Color color;
+
+        bool operator==(const Panel &other) const { return rect == other.rect && color == other.color; }
+    };
+
+    const Font *font;
+    FloatRect area;   // Coordinates the panels and labels are given in
+    float pixelScale; // Texture pixels per unit of area
+    Sprite background;
+    bool hasBackground;
+    vector<Panel> panels;
+    vector<Label> labels;
+    map<string, FloatRect> metrics; // Local bounds keyed by size and string
+
+    // Rendered lazily from draw(), the same way sf::Text updates its geometry
+    mutable RenderTexture texture;
+    mutable Sprite sprite;
+    mutable vector<Panel> renderedPanels; // What the texture currently shows
+    mutable vector<Label> renderedLabels;
+    mutable bool dirty;
+    mutable bool textureFailed; // No RenderTexture support: draw the items directly
+    mutable unsigned int renders;
+
+    void render() const;
+    void drawItems(RenderTarget &target, RenderStates states) const;
+
+    virtual void draw(RenderTarget &target, RenderStates states) const;
+
+public:
+    TextCache();
+
+    void setFont(const Font &font);
+
+    // The region the layer covers, normally the current view, and how many window
+    // pixels one unit of it takes up. The texture is rendered at that resolution so
+    // text stays sharp when the view is scaled up; changing either (the window was
+    // resized) invalidates the texture.
+    void setArea(const FloatRect &area, float pixelScale = 1);
+    const FloatRect &getArea() const { return area; }
+
+    // Remove the background, panels and labels before laying the layer out again
+    void clear();
+    void setBackground(const Sprite &sprite);
+
+    // Panels are filled rectangles drawn under the labels; returns the panel's index
+    int addPanel(const FloatRect &rect, const Color &color);
+    void setPanelColor(int panel, const Color &color);
+    const FloatRect &getPanel(int panel) const { return panels[panel].rect; }
+    int findPanel(Vector2f point) const; // Topmost panel containing the point, -1 if none
+
+    // Bounds of a string as sf::Text would report them, cached
+    FloatRect measure(const string &text, unsigned int size);
+
+    void addLabel(const string &text, unsigned int size, const Color &color, Vector2f position);
+    // Centre a label inside a box, e.g. a button panel
+    void addCenteredLabel(const string &text, unsigned int size, const Color &color,
+                          const FloatRect &box, float offsetY = 0);
+
+    void invalidate() { dirty = true; }
+    unsigned int getRenderCount() const { return renders; }
+};
+
+#endif // TEXTCACHE_H
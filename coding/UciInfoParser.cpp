@@ -0,0 +1,244 @@
+#include "UciInfoParser.h"
+#include <cstring>
+
+using namespace std;
+
+// Helper: advance to the next space separated token in [cur, end)
+static bool nextToken(const char *&cur, const char *end, const char *&token, size_t &tokenLength)
+{
+    while (cur < end && (*cur == ' ' || *cur == '\t'))
+        cur++;
+    if (cur >= end)
+        return false;
+
+    token = cur;
+    while (cur < end && *cur != ' ' && *cur != '\t')
+        cur++;
+    tokenLength = cur - token;
+    return true;
+}
+
+// Helper: compare a token against a keyword without needing a null-terminated token
+static bool tokenIs(const char *token, size_t tokenLength, const char *keyword)
+{
+    size_t keywordLength = strlen(keyword);
+    return tokenLength == keywordLength && memcmp(token, keyword, keywordLength) == 0;
+}
+
+// Helper: parse a (possibly negative) integer token
+static bool parseNumber(const char *token, size_t tokenLength, long long &value)
+{
+    if (tokenLength == 0)
+        return false;
+
+    size_t i = 0;
+    bool negative = false;
+    if (token[0] == '-' || token[0] == '+')
+    {
+        negative = token[0] == '-';
+        i = 1;
+    }
+    if (i == tokenLength)
+        return false;
+
+    long long result = 0;
+    for (; i < tokenLength; i++)
+    {
+        if (token[i] < '0' || token[i] > '9')
+            return false;
+        result = result * 10 + (token[i] - '0');
+    }
+    value = negative ? -result : result;
+    return true;
+}
+
+// Helper: read the token after a keyword as a number
+static bool readNumber(const char *&cur, const char *end, long long &value)
+{
+    const char *token;
+    size_t tokenLength;
+    if (!nextToken(cur, end, token, tokenLength))
+        return false;
+    return parseNumber(token, tokenLength, value);
+}
+
+void UciInfo::clear()
+{
+    depth = 0;
+    selDepth = 0;
+    multiPv = 1;
+    hasScore = false;
+    scoreIsMate = false;
+    score = 0;
+    lowerBound = false;
+    upperBound = false;
+    nodes = 0;
+    nps = 0;
+    timeMs = 0;
+    hashFull = 0;
+    pv = nullptr;
+    pvLength = 0;
+}
+
+string UciInfo::firstPvMove() const
+{
+    if (!pv)
+        return "";
+    size_t end = 0;
+    while (end < pvLength && pv[end] != ' ')
+        end++;
+    return string(pv, end);
+}
+
+bool UciInfoParser::startsWith(const char *line, size_t length, const char *prefix)
+{
+    size_t prefixLength = strlen(prefix);
+    return length >= prefixLength && memcmp(line, prefix, prefixLength) == 0;
+}
+
+bool UciInfoParser::parseInfo(const char *line, size_t length, UciInfo &info)
+{
+    const char *cur = line;
+    const char *end = line + length;
+    const char *token;
+    size_t tokenLength;
+
+    if (!nextToken(cur, end, token, tokenLength) || !tokenIs(token, tokenLength, "info"))
+        return false;
+
+    info.clear();
+    bool sawSearchField = false;
+    long long value = 0;
+
+    while (nextToken(cur, end, token, tokenLength))
+    {
+        if (tokenIs(token, tokenLength, "string"))
+        {
+            // Free-form text from the engine, nothing to parse
+            return false;
+        }
+        else if (tokenIs(token, tokenLength, "depth"))
+        {
+            if (readNumber(cur, end, value))
+                info.depth = static_cast<int>(value);
+            sawSearchField = true;
+        }
+        else if (tokenIs(token, tokenLength, "seldepth"))
+        {
+            if (readNumber(cur, end, value))
+                info.selDepth = static_cast<int>(value);
+        }
+        else if (tokenIs(token, tokenLength, "multipv"))
+        {
+            if (readNumber(cur, end, value))
+                info.multiPv = static_cast<int>(value);
+        }
+        else if (tokenIs(token, tokenLength, "score"))
+        {
+            const char *kind;
+            size_t kindLength;
+            if (nextToken(cur, end, kind, kindLength) && readNumber(cur, end, value))
+            {
+                info.hasScore = true;
+                info.scoreIsMate = tokenIs(kind, kindLength, "mate");
+                info.score = static_cast<int>(value);
+            }
+            sawSearchField = true;
+        }
+        else if (tokenIs(token, tokenLength, "lowerbound"))
+        {
+            info.lowerBound = true;
+        }
+        else if (tokenIs(token, tokenLength, "upperbound"))
+        {
+            info.upperBound = true;
+        }
+        else if (tokenIs(token, tokenLength, "nodes"))
+        {
+            if (readNumber(cur, end, value))
+                info.nodes = value;
+        }
+        else if (tokenIs(token, tokenLength, "nps"))
+        {
+            if (readNumber(cur, end, value))
+                info.nps = value;
+        }
+        else if (tokenIs(token, tokenLength, "time"))
+        {
+            if (readNumber(cur, end, value))
+                info.timeMs = static_cast<int>(value);
+        }
+        else if (tokenIs(token, tokenLength, "hashfull"))
+        {
+            if (readNumber(cur, end, value))
+                info.hashFull = static_cast<int>(value);
+        }
+        else if (tokenIs(token, tokenLength, "pv"))
+        {
+            // The PV runs to the end of the line
+            while (cur < end && (*cur == ' ' || *cur == '\t'))
+                cur++;
+            const char *pvEnd = end;
+            while (pvEnd > cur && (pvEnd[-1] == ' ' || pvEnd[-1] == '\t'))
+                pvEnd--;
+            info.pv = cur;
+            info.pvLength = pvEnd - cur;
+            break;
+        }
+        // Anything else (currmove, tbhits, cpuload, ...) is skipped
+    }
+
+    return sawSearchField;
+}
+
+bool UciInfoParser::parseBestMove(const char *line, size_t length, string &bestMove)
+{
+    const char *cur = line;
+    const char *end = line + length;
+    const char *token;
+    size_t tokenLength;
+
+    if (!nextToken(cur, end, token, tokenLength) || !tokenIs(token, tokenLength, "bestmove"))
+        return false;
+    if (!nextToken(cur, end, token, tokenLength))
+        return false;
+
+    // Basic validation: e2e4 is 4 characters, a7a8q is 5 ("(none)" is rejected)
+    if (tokenLength < 4 || tokenLength > 5)
+        return false;
+
+    bestMove.assign(token, tokenLength);
+    return true;
+}
+
+void UciLineBuffer::append(const char *data, size_t length)
+{
+    // Drop lines that have already been handed out before growing the buffer
+    if (readPos > 0 && readPos >= buffer.size() / 2)
+    {
+        buffer.erase(0, readPos);
+        readPos = 0;
+    }
+    buffer.append(data, length);
+}
+
+bool UciLineBuffer::nextLine(const char *&line, size_t &length)
+{
+    size_t newline = buffer.find('\n', readPos);
+    if (newline == string::npos)
+        return false;
+
+    line = buffer.data() + readPos;
+    length = newline - readPos;
+    if (length > 0 && line[length - 1] == '\r')
+        length--;
+
+    readPos = newline + 1;
+    return true;
+}
+
+void UciLineBuffer::clear()
+{
+    buffer.clear();
+    readPos = 0;
+}
@@ -0,0 +1,68 @@
+#ifndef UCIINFOPARSER_H
+#define UCIINFOPARSER_H
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+// One parsed "info" line from a UCI engine.
+// pv points into the line it was parsed from (no copy is made), so it is only
+// valid inside the callback the info is handed to. Use pvString() to keep it.
+struct UciInfo
+{
+    int depth;
+    int selDepth;
+    int multiPv;      // 1 unless the engine runs with MultiPV > 1
+    bool hasScore;    // Not every info line carries a score
+    bool scoreIsMate; // score is "mate N" instead of centipawns
+    int score;        // Centipawns (or moves to mate) from the side to move's point of view
+    bool lowerBound;
+    bool upperBound;
+    long long nodes;
+    long long nps;
+    int timeMs;
+    int hashFull;
+    const char *pv; // Space separated UCI moves, not null-terminated
+    size_t pvLength;
+
+    UciInfo() { clear(); }
+    void clear();
+    string pvString() const { return string(pv ? pv : "", pvLength); }
+    string firstPvMove() const;
+};
+
+class UciInfoParser
+{
+public:
+    // Parse an "info ..." line. Returns false for lines that are not search info
+    // (e.g. "info string ..." or anything that is not an info line at all)
+    static bool parseInfo(const char *line, size_t length, UciInfo &info);
+
+    // Parse a "bestmove xxxx [ponder yyyy]" line
+    static bool parseBestMove(const char *line, size_t length, string &bestMove);
+
+    static bool startsWith(const char *line, size_t length, const char *prefix);
+};
+
+// Accumulates raw engine output and hands out complete lines as pointers into
+// its own buffer, so a line is never copied on its way to the parser
+class UciLineBuffer
+{
+private:
+    string buffer;
+    size_t readPos;
+
+public:
+    UciLineBuffer() : readPos(0) {}
+
+    void append(const char *data, size_t length);
+    void append(const string &data) { append(data.data(), data.size()); }
+
+    // Returns the next complete line (without the line ending). The pointer is
+    // valid until the next call to append() or clear()
+    bool nextLine(const char *&line, size_t &length);
+    void clear();
+};
+
+#endif // UCIINFOPARSER_H
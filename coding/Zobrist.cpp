@@ -0,0 +1,211 @@
+#include "Zobrist.h"
+#include <cstdlib>
+
+using namespace std;
+
+// 12 piece types * 64 squares, then side to move, 16 castling states and 8 en passant files
+static const int PIECE_KEYS = 12 * 64;
+static const int SIDE_KEY = PIECE_KEYS;
+static const int CASTLING_KEYS = SIDE_KEY + 1;
+static const int EN_PASSANT_KEYS = CASTLING_KEYS + 16;
+static const int KEY_COUNT = EN_PASSANT_KEYS + 8;
+
+struct ZobristKeyTable
+{
+    uint64_t keys[KEY_COUNT];
+
+    ZobristKeyTable()
+    {
+        // splitmix64 with a fixed seed so keys never change between builds
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (int i = 0; i < KEY_COUNT; i++)
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            keys[i] = z ^ (z >> 31);
+        }
+    }
+};
+
+// Helper function: the key table, built on first use (thread-safe static init)
+static const uint64_t *keyTable()
+{
+    static const ZobristKeyTable table;
+    return table.keys;
+}
+
+int Zobrist::pieceIndex(int pieceValue)
+{
+    // 6: Rook, 7: Bishop, 8: Knight, 9: King, 10: Pawn, 11: Queen
+    int type = abs(pieceValue) - 6;
+    if (pieceValue == 0 || type < 0 || type > 5)
+        return -1;
+    return pieceValue > 0 ? type : type + 6;
+}
+
+uint64_t Zobrist::hashBoard(const vector<vector<int>> &board, bool whiteToMove,
+                            int castlingRights, int enPassantCol)
+{
+    const uint64_t *keys = keyTable();
+    uint64_t hash = 0;
+
+    for (int x = 0; x < 8; x++)
+    {
+        for (int y = 0; y < 8; y++)
+        {
+            int index = pieceIndex(board[x][y]);
+            if (index != -1)
+            {
+                hash ^= keys[index * 64 + y * 8 + x];
+            }
+        }
+    }
+
+    return hash ^ stateKey(whiteToMove, castlingRights, enPassantCol);
+}
+
+uint64_t Zobrist::pieceKey(int pieceValue, int x, int y)
+{
+    int index = pieceIndex(pieceValue);
+    return index == -1 ? 0 : keyTable()[index * 64 + y * 8 + x];
+}
+
+uint64_t Zobrist::stateKey(bool whiteToMove, int castlingRights, int enPassantCol)
+{
+    const uint64_t *keys = keyTable();
+    uint64_t hash = keys[CASTLING_KEYS + (castlingRights & AllCastling)];
+    if (whiteToMove)
+        hash ^= keys[SIDE_KEY];
+    if (enPassantCol >= 0 && enPassantCol < 8)
+        hash ^= keys[EN_PASSANT_KEYS + enPassantCol];
+    return hash;
+}
+
+void Zobrist::setStartPosition(vector<vector<int>> &board)
+{
+    // Same setup as ChessBoard::initBoard
+    board.assign(8, vector<int>(8, 0));
+    int backRank[8] = {6, 8, 7, 11, 9, 7, 8, 6};
+    for (int x = 0; x < 8; x++)
+    {
+        board[x][0] = -backRank[x];
+        board[x][1] = -10;
+        board[x][6] = 10;
+        board[x][7] = backRank[x];
+    }
+}
+
+bool Zobrist::applyUciMove(vector<vector<int>> &board, const string &move,
+                           int &castlingRights, int &enPassantCol)
+{
+    if (move.length() < 4)
+        return false;
+
+    int fromX = move[0] - 'a';
+    int fromY = '8' - move[1];
+    int toX = move[2] - 'a';
+    int toY = '8' - move[3];
+    if (fromX < 0 || fromX >= 8 || fromY < 0 || fromY >= 8 ||
+        toX < 0 || toX >= 8 || toY < 0 || toY >= 8)
+        return false;
+
+    int piece = board[fromX][fromY];
+    if (piece == 0)
+        return false;
+
+    // Castling (king moves two squares): move the rook as well
+    if (abs(piece) == 9 && abs(toX - fromX) == 2)
+    {
+        int rookFromX = toX > fromX ? 7 : 0;
+        int rookToX = toX > fromX ? 5 : 3;
+        board[rookToX][fromY] = board[rookFromX][fromY];
+        board[rookFromX][fromY] = 0;
+    }
+
+    // En passant: a pawn moving diagonally onto an empty square captures beside it
+    if (abs(piece) == 10 && fromX != toX && board[toX][toY] == 0)
+    {
+        board[toX][fromY] = 0;
+    }
+
+    // Promotion
+    if (abs(piece) == 10 && (toY == 0 || toY == 7))
+    {
+        int promoted = 11; // Queen unless told otherwise
+        if (move.length() >= 5)
+        {
+            switch (move[4])
+            {
+            case 'r':
+                promoted = 6;
+                break;
+            case 'b':
+                promoted = 7;
+                break;
+            case 'n':
+                promoted = 8;
+                break;
+            }
+        }
+        piece = piece > 0 ? promoted : -promoted;
+    }
+
+    board[toX][toY] = piece;
+    board[fromX][fromY] = 0;
+
+    // Any move touching a king or rook home square removes the matching rights
+    for (int i = 0; i < 2; i++)
+    {
+        int x = i == 0 ? fromX : toX;
+        int y = i == 0 ? fromY : toY;
+        if (y == 7)
+        {
+            if (x == 4)
+                castlingRights &= ~(WhiteKingside | WhiteQueenside);
+            else if (x == 7)
+                castlingRights &= ~WhiteKingside;
+            else if (x == 0)
+                castlingRights &= ~WhiteQueenside;
+        }
+        else if (y == 0)
+        {
+            if (x == 4)
+                castlingRights &= ~(BlackKingside | BlackQueenside);
+            else if (x == 7)
+                castlingRights &= ~BlackKingside;
+            else if (x == 0)
+                castlingRights &= ~BlackQueenside;
+        }
+    }
+
+    enPassantCol = (abs(piece) == 10 && abs(toY - fromY) == 2) ? toX : -1;
+    return true;
+}
+
+uint64_t Zobrist::hashUciMoves(const string &moves)
+{
+    vector<vector<int>> board;
+    setStartPosition(board);
+    return hashUciMoves(moves, board, true, AllCastling, -1);
+}
+
+uint64_t Zobrist::hashUciMoves(const string &moves, vector<vector<int>> board, bool whiteToMove,
+                               int castlingRights, int enPassantCol)
+{
+    size_t pos = 0;
+    while (pos < moves.length())
+    {
+        size_t end = moves.find(' ', pos);
+        if (end == string::npos)
+            end = moves.length();
+        if (end > pos)
+        {
+            applyUciMove(board, moves.substr(pos, end - pos), castlingRights, enPassantCol);
+            whiteToMove = !whiteToMove;
+        }
+        pos = end + 1;
+    }
+
+    return hashBoard(board, whiteToMove, castlingRights, enPassantCol);
+}
@@ -0,0 +1,53 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Zobrist hashing for positions stored in the same board[x][y] layout as ChessBoard
+// (y = 0 is the 8th rank, positive values are white pieces, negative are black).
+// The keys are generated from a fixed seed so hashes stay valid across runs and
+// can be written to disk.
+class Zobrist
+{
+public:
+    // Castling right bits
+    enum
+    {
+        WhiteKingside = 1,
+        WhiteQueenside = 2,
+        BlackKingside = 4,
+        BlackQueenside = 8,
+        AllCastling = 15
+    };
+
+    static uint64_t hashBoard(const vector<vector<int>> &board, bool whiteToMove,
+                              int castlingRights, int enPassantCol);
+
+    // Hash the position reached by playing space separated UCI moves from the start position
+    static uint64_t hashUciMoves(const string &moves);
+
+    // The same from any position, e.g. one set up from a FEN
+    static uint64_t hashUciMoves(const string &moves, vector<vector<int>> board, bool whiteToMove,
+                                 int castlingRights, int enPassantCol);
+
+    // Apply one UCI move to a board, keeping castling rights and en passant file up to date.
+    // Returns false if the move string is malformed or there is no piece on the from-square
+    static bool applyUciMove(vector<vector<int>> &board, const string &move,
+                             int &castlingRights, int &enPassantCol);
+
+    static void setStartPosition(vector<vector<int>> &board);
+
+    // The parts hashBoard adds up, for hashes of positions kept in other layouts:
+    // one piece on one square, and the side to move, castling rights and en passant file
+    static uint64_t pieceKey(int pieceValue, int x, int y);
+    static uint64_t stateKey(bool whiteToMove, int castlingRights, int enPassantCol);
+
+private:
+    static int pieceIndex(int pieceValue); // 0-11, or -1 for an empty square
+};
+
+#endif // ZOBRIST_H
@@ -1,6 +1,49 @@
 #include "ChessBoard.h"
-int main() {
+#include "GameAnalyzer.h"
+#include "BoardImageRenderer.h"
+#include "MultiBoardView.h"
+#include "PgnImporter.h"
+#include "GameStore.h"
+#include "PositionIndex.h"
+#include "GameArchive.h"
+
+int main(int argc, char *argv[]) {
+    // Batch analysis of saved games without opening the board
+    if (argc > 1 && string(argv[1]) == "--analyze") {
+        return GameAnalyzer::runCommandLine(argc, argv);
+    }
+    // Board diagrams from FEN without opening a window
+    if (argc > 1 && string(argv[1]) == "--render") {
+        return BoardImageRenderer::runCommandLine(argc, argv);
+    }
+    // Several engine games side by side in one window
+    if (argc > 1 && string(argv[1]) == "--watch") {
+        return MultiBoardView::runCommandLine(argc, argv);
+    }
+    // Check whole PGN databases on every core
+    if (argc > 1 && string(argv[1]) == "--import") {
+        return PgnImporter::runCommandLine(argc, argv);
+    }
+    // Convert between PGN and the binary game store
+    if (argc > 1 && string(argv[1]) == "--store") {
+        return GameStore::runCommandLine(argc, argv);
+    }
+    // Build or query the position index of a game database
+    if (argc > 1 && string(argv[1]) == "--index") {
+        return PositionIndex::runCommandLine(argc, argv);
+    }
+    // Compressed, seekable game archives
+    if (argc > 1 && string(argv[1]) == "--archive") {
+        return GameArchive::runCommandLine(argc, argv);
+    }
+
     ChessBoard chessBoard;
+    // Play from a set-up position instead of the standard start
+    if (argc > 2 && string(argv[1]) == "--fen") {
+        if (!chessBoard.setStartFen(argv[2])) {
+            return 1;
+        }
+    }
     chessBoard.run();
     
     return 0;